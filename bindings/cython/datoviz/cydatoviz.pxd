@@ -1421,20 +1421,26 @@ cdef extern from "<datoviz/datoviz.h>":
 
     DvzVisual* dvz_scene_visual(DvzPanel* panel, DvzVisualType type, int flags)
 
-    void dvz_upload_buffer(DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
+    uint64_t dvz_upload_buffer(DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
 
-    void dvz_download_buffer(DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
+    uint64_t dvz_download_buffer(DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
 
-    void dvz_copy_buffer(DvzContext* context, DvzBufferRegions src, VkDeviceSize src_offset, DvzBufferRegions dst, VkDeviceSize dst_offset, VkDeviceSize size)
+    uint64_t dvz_copy_buffer(DvzContext* context, DvzBufferRegions src, VkDeviceSize src_offset, DvzBufferRegions dst, VkDeviceSize dst_offset, VkDeviceSize size)
 
-    void dvz_upload_texture(DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
+    uint64_t dvz_upload_texture(DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
 
-    void dvz_download_texture(DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
+    uint64_t dvz_download_texture(DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
 
-    void dvz_copy_texture(DvzContext* context, DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset, uvec3 shape, VkDeviceSize size)
+    uint64_t dvz_copy_texture(DvzContext* context, DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset, uvec3 shape, VkDeviceSize size)
 
     void dvz_process_transfers(DvzContext* context)
 
+    void dvz_transfers_sync(DvzContext* context, bint sync)
+
+    bint dvz_transfer_done(DvzContext* context, uint64_t ticket)
+
+    void dvz_transfer_wait(DvzContext* context, uint64_t ticket)
+
     void dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out, bint inverse)
 
     void dvz_transform(DvzPanel* panel, DvzCDS source, dvec3 pos_in, DvzCDS target, dvec3 pos_out)
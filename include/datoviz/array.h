@@ -254,7 +254,10 @@ static DvzArray _create_array(uint32_t item_count, DvzDataType dtype, VkDeviceSi
     arr.item_count = item_count;
     arr.buffer_size = item_count * arr.item_size;
     if (item_count > 0)
+    {
+        dvz_alloc_track(arr.buffer_size);
         arr.data = calloc(item_count, arr.item_size);
+    }
     dvz_obj_created(&arr.obj);
     return arr;
 }
@@ -286,6 +289,7 @@ static DvzArray dvz_array(uint32_t item_count, DvzDataType dtype)
 static DvzArray dvz_array_copy(DvzArray* arr)
 {
     DvzArray arr_new = *arr; // struct copy
+    dvz_alloc_track(arr->buffer_size);
     arr_new.data = malloc(arr->buffer_size);
     memcpy(arr_new.data, arr->data, arr->buffer_size);
     return arr_new;
@@ -293,6 +297,34 @@ static DvzArray dvz_array_copy(DvzArray* arr)
 
 
 
+/**
+ * Copy an array into another one, reusing the data buffer of the destination array when it is
+ * large enough.
+ *
+ * @param arr the source array
+ * @param out the destination array, which may be uninitialized or destroyed
+ */
+static void dvz_array_copy_into(DvzArray* arr, DvzArray* out)
+{
+    ASSERT(arr != NULL);
+    ASSERT(out != NULL);
+    if (!dvz_obj_is_created(&out->obj) || out->buffer_size < arr->buffer_size)
+    {
+        if (dvz_obj_is_created(&out->obj))
+            FREE(out->data);
+        *out = dvz_array_copy(arr);
+        return;
+    }
+    void* data = out->data;
+    VkDeviceSize buffer_size = out->buffer_size;
+    *out = *arr; // struct copy
+    out->data = data;
+    out->buffer_size = buffer_size;
+    memcpy(out->data, arr->data, arr->buffer_size);
+}
+
+
+
 /**
  * Create an array with a single dvec3 position.
  *
@@ -424,6 +456,7 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
     // If the array was not allocated, allocate it with the specified size.
     if (array->data == NULL)
     {
+        dvz_alloc_track(item_count * array->item_size);
         array->data = calloc(item_count, array->item_size);
         array->item_count = item_count;
 
@@ -453,6 +486,7 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
         log_debug(
             "resize array from %d to %d items of size %d", old_item_count, new_item_count,
             array->item_size);
+        dvz_alloc_track(new_size);
         REALLOC(array->data, new_size);
         // Repeat the last element when resizing.
         _repeat_last(old_size / array->item_size, array->item_size, array->data, new_item_count);
@@ -632,7 +666,10 @@ static void dvz_array_data(
     void* dst = array->data;
     // Allocate the array if needed.
     if (dst == NULL)
+    {
+        dvz_alloc_track((first_item + array->item_count) * array->item_size);
         dst = array->data = calloc(first_item + array->item_count, array->item_size);
+    }
     ASSERT(dst != NULL);
     const void* src = data;
     ASSERT(src != NULL);
@@ -695,26 +732,265 @@ static inline void* dvz_array_item(DvzArray* array, uint32_t idx)
 
 
 
-// Cast a vector.
-static inline void _cast(DvzDataType target_dtype, void* dst, DvzDataType source_dtype, void* src)
+/*************************************************************************************************/
+/*  Column copy kernels                                                                          */
+/*************************************************************************************************/
+
+// Strided copy kernel: copy `count` items of `col_size` bytes, advancing the source and
+// destination pointers by their respective strides. A zero source stride broadcasts one item.
+typedef void (*DvzColumnKernel)(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count);
+
+
+
+// Generic kernel, for any column size.
+static void _column_copy(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
 {
-    if (source_dtype == DVZ_DTYPE_DOUBLE && target_dtype == DVZ_DTYPE_FLOAT)
+    // Fully contiguous copy.
+    if (src_stride == col_size && dst_stride == col_size)
     {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
+        memcpy(dst, src, count * col_size);
+        return;
     }
-    else if (source_dtype == DVZ_DTYPE_DVEC2 && target_dtype == DVZ_DTYPE_VEC2)
+    for (uint32_t i = 0; i < count; i++)
     {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
-        ((vec3*)dst)[0][1] = ((dvec3*)src)[0][1];
+        memcpy(dst, src, col_size);
+        dst += dst_stride;
+        src += src_stride;
     }
-    else if (source_dtype == DVZ_DTYPE_DVEC3 && target_dtype == DVZ_DTYPE_VEC3)
+}
+
+
+
+// Fixed-size kernels: the constant-size memcpy is inlined as plain loads and stores.
+#define _COLUMN_COPY_FIXED(n)                                                                     \
+    static void _column_copy_##n(                                                                 \
+        uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,       \
+        VkDeviceSize col_size, uint32_t count)                                                    \
+    {                                                                                             \
+        if (src_stride == n && dst_stride == n)                                                   \
+        {                                                                                         \
+            memcpy(dst, src, count * (VkDeviceSize)n);                                            \
+            return;                                                                               \
+        }                                                                                         \
+        for (uint32_t i = 0; i < count; i++)                                                      \
+        {                                                                                         \
+            memcpy(dst, src, n);                                                                  \
+            dst += dst_stride;                                                                    \
+            src += src_stride;                                                                    \
+        }                                                                                         \
+    }
+
+_COLUMN_COPY_FIXED(1)
+_COLUMN_COPY_FIXED(2)
+_COLUMN_COPY_FIXED(4)
+_COLUMN_COPY_FIXED(8)
+_COLUMN_COPY_FIXED(12)
+_COLUMN_COPY_FIXED(16)
+_COLUMN_COPY_FIXED(64)
+
+
+
+// Fused double to float cast kernels, scalar fallback.
+static void _column_cast_double(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count, uint32_t components)
+{
+    double d[3] = {0};
+    float f[3] = {0};
+    ASSERT(components <= 3);
+    for (uint32_t i = 0; i < count; i++)
     {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
-        ((vec3*)dst)[0][1] = ((dvec3*)src)[0][1];
-        ((vec3*)dst)[0][2] = ((dvec3*)src)[0][2];
+        memcpy(d, src, components * sizeof(double));
+        for (uint32_t k = 0; k < components; k++)
+            f[k] = (float)d[k];
+        memcpy(dst, f, components * sizeof(float));
+        dst += dst_stride;
+        src += src_stride;
     }
-    else
-        log_error("unknown casting dtypes %d %d", source_dtype, target_dtype);
+}
+
+static void _column_cast_double_1(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    _column_cast_double(dst, dst_stride, src, src_stride, col_size, count, 1);
+}
+
+static void _column_cast_double_2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    _column_cast_double(dst, dst_stride, src, src_stride, col_size, count, 2);
+}
+
+static void _column_cast_double_3(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    _column_cast_double(dst, dst_stride, src, src_stride, col_size, count, 3);
+}
+
+
+
+// SIMD cast kernels. The double to float conversion instructions round to nearest like the scalar
+// cast, so the results are bit-identical to the scalar fallback.
+#if DVZ_SIMD_X86
+
+// SSE2 is part of the x86-64 baseline and needs no runtime check.
+static void _column_cast_double_2_sse2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        _mm_storel_pi(
+            (__m64*)(void*)dst, _mm_cvtpd_ps(_mm_loadu_pd((const double*)(const void*)src)));
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+static void _column_cast_double_3_sse2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    const double* s = NULL;
+    float* d = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        s = (const double*)(const void*)src;
+        d = (float*)(void*)dst;
+        _mm_storel_pi((__m64*)(void*)d, _mm_cvtpd_ps(_mm_loadu_pd(s)));
+        _mm_store_ss(&d[2], _mm_cvtsd_ss(_mm_setzero_ps(), _mm_load_sd(&s[2])));
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+#if DVZ_SIMD_AVX
+
+// AVX: one masked 3-lane load and conversion per item, without reading or writing past the
+// dvec3 source and vec3 destination.
+__attribute__((target("avx"))) static void _column_cast_double_3_avx(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    const __m256i mask_d = _mm256_setr_epi64x(-1, -1, -1, 0);
+    const __m128i mask_f = _mm_setr_epi32(-1, -1, -1, 0);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        _mm_maskstore_ps(
+            (float*)(void*)dst, mask_f,
+            _mm256_cvtpd_ps(_mm256_maskload_pd((const double*)(const void*)src, mask_d)));
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+#endif
+
+#endif
+
+#if DVZ_SIMD_NEON
+
+static void _column_cast_double_2_neon(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vst1_f32((float*)(void*)dst, vcvt_f32_f64(vld1q_f64((const double*)(const void*)src)));
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+static void _column_cast_double_3_neon(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t count)
+{
+    const double* s = NULL;
+    float* d = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        s = (const double*)(const void*)src;
+        d = (float*)(void*)dst;
+        vst1_f32(d, vcvt_f32_f64(vld1q_f64(s)));
+        d[2] = (float)s[2];
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+#endif
+
+
+
+// Select the copy kernel once per column copy, or return NULL if the cast is not supported.
+static DvzColumnKernel
+_column_kernel(VkDeviceSize col_size, DvzDataType source_dtype, DvzDataType target_dtype)
+{
+    // Plain copy.
+    if (source_dtype == target_dtype ||   //
+        source_dtype == DVZ_DTYPE_NONE || //
+        target_dtype == DVZ_DTYPE_NONE)   //
+    {
+        switch (col_size)
+        {
+        case 1:
+            return _column_copy_1;
+        case 2:
+            return _column_copy_2;
+        case 4:
+            return _column_copy_4;
+        case 8:
+            return _column_copy_8;
+        case 12:
+            return _column_copy_12;
+        case 16:
+            return _column_copy_16;
+        case 64:
+            return _column_copy_64;
+        default:
+            return _column_copy;
+        }
+    }
+
+    // Fused cast.
+    if (source_dtype == DVZ_DTYPE_DOUBLE && target_dtype == DVZ_DTYPE_FLOAT)
+        return _column_cast_double_1;
+
+    if (source_dtype == DVZ_DTYPE_DVEC2 && target_dtype == DVZ_DTYPE_VEC2)
+    {
+#if DVZ_SIMD_X86
+        return _column_cast_double_2_sse2;
+#elif DVZ_SIMD_NEON
+        return _column_cast_double_2_neon;
+#else
+        return _column_cast_double_2;
+#endif
+    }
+
+    if (source_dtype == DVZ_DTYPE_DVEC3 && target_dtype == DVZ_DTYPE_VEC3)
+    {
+#if DVZ_SIMD_X86
+#if DVZ_SIMD_AVX
+        if (_cpu_has_avx())
+            return _column_cast_double_3_avx;
+#endif
+        return _column_cast_double_3_sse2;
+#elif DVZ_SIMD_NEON
+        return _column_cast_double_3_neon;
+#else
+        return _column_cast_double_3;
+#endif
+    }
+
+    return NULL;
 }
 
 
@@ -726,6 +1002,9 @@ static inline void _cast(DvzDataType target_dtype, void* dst, DvzDataType source
  * (corresponding to a record array with as many fields as GLSL attributes in the vertex shader)
  * the user-specified visual props (data for the individual elements).
  *
+ * The destination item `i` receives the source item `min(i / reps, data_item_count - 1)`. In
+ * SINGLE copy mode, only the first of each group of `reps` destination items is written.
+ *
  * @param array the array
  * @param offset the offset within the array, in bytes
  * @param col_size stride in the source array, in bytes
@@ -752,62 +1031,55 @@ static void dvz_array_column(
     ASSERT(item_count > 0);
     ASSERT(first_item + item_count <= array->item_count);
 
-    VkDeviceSize src_offset = 0;
     VkDeviceSize src_stride = col_size;
-
-    VkDeviceSize dst_offset = offset;
     VkDeviceSize dst_stride = array->item_size;
 
-    void* dst = array->data;
-    const void* src = data;
+    uint8_t* dst = (uint8_t*)array->data + first_item * dst_stride + offset;
+    const uint8_t* src = (const uint8_t*)data;
 
     ASSERT(src != NULL);
     ASSERT(dst != NULL);
     ASSERT(src_stride > 0);
     ASSERT(dst_stride > 0);
-    ASSERT(item_count > 0);
 
     log_trace(
-        "copy src offset %d stride %d, dst offset %d stride %d, item size %d count %d", //
-        src_offset, src_stride, dst_offset, dst_stride, col_size, item_count);
-
-    int64_t src_byte = (int64_t)src + (int64_t)src_offset;
-    int64_t dst_byte = (int64_t)dst + (int64_t)(first_item * dst_stride) + (int64_t)dst_offset;
+        "copy src stride %d, dst offset %d stride %d, item size %d count %d", //
+        src_stride, offset, dst_stride, col_size, item_count);
 
-    uint32_t j = 0; // j: src index
-    uint32_t m = 0;
-    bool skip = false;
-    for (uint32_t i = 0; i < item_count; i++) // i: dst index
+    DvzColumnKernel kernel = _column_kernel(col_size, source_dtype, target_dtype);
+    if (kernel == NULL)
     {
-        if (reps > 1)
-            m = i % reps;
-        // Determine whether the current item copy should be skipped.
-        skip = copy_type == DVZ_ARRAY_COPY_SINGLE && reps > 1 && m > 0;
+        log_error("unknown casting dtypes %d %d", source_dtype, target_dtype);
+        return;
+    }
 
-        // NOTE: this function is not optimized and might benefit from being refactored.
+    uint32_t r = MAX(reps, 1);
+    bool single = copy_type == DVZ_ARRAY_COPY_SINGLE && r > 1;
 
-        // Copy the current item, unless we are in SINGLE copy mode
-        if (!skip)
-        {
-            if (source_dtype == target_dtype ||   //
-                source_dtype == DVZ_DTYPE_NONE || //
-                target_dtype == DVZ_DTYPE_NONE)   //
-                memcpy((void*)dst_byte, (void*)src_byte, col_size);
-            else
-            {
-                _cast(target_dtype, (void*)dst_byte, source_dtype, (void*)src_byte);
-            }
-        }
+    // Destination items that map to distinct source items, the remaining ones repeat the last
+    // source item.
+    uint32_t direct = (uint32_t)MIN((uint64_t)item_count, (uint64_t)data_item_count * r);
 
-        // Advance the source pointer, unless we are in SINGLE copy mode
-        skip = reps > 1 && m < reps - 1;
-        if (j < data_item_count - 1 && !skip)
-        {
-            src_byte += (int64_t)src_stride;
-            j++;
-        }
+    // Repeated items are copied phase by phase, with a destination stride of `reps` items.
+    uint32_t phases = single ? 1 : r;
+    uint32_t count = 0;
+    for (uint32_t p = 0; p < phases && p < direct; p++)
+    {
+        count = (direct - p + r - 1) / r;
+        kernel(dst + p * dst_stride, r * dst_stride, src, src_stride, col_size, count);
+    }
 
-        dst_byte += (int64_t)dst_stride;
+    // Broadcast the last source item over the tail.
+    if (direct < item_count)
+    {
+        // NOTE: direct is a multiple of reps here, so the tail starts at the first phase.
+        ASSERT(direct % r == 0);
+        count = item_count - direct;
+        if (single)
+            count = (count + r - 1) / r;
+        kernel(
+            dst + direct * dst_stride, (single ? r : 1) * dst_stride,
+            src + (data_item_count - 1) * src_stride, 0, col_size, count);
     }
 }
 
@@ -24,6 +24,10 @@ extern "C" {
 #define DVZ_MAX_EVENT_CALLBACKS 32
 // Maximum acceptable duration for the pending events in the event queue, in seconds
 #define DVZ_MAX_EVENT_DURATION .5
+// Number of events allocated at once by the event pool
+#define DVZ_EVENT_POOL_SIZE 64
+// Maximum duration of the event wait when all canvases are idle in on-demand mode, in seconds
+#define DVZ_ON_DEMAND_TIMEOUT .5
 #define DVZ_DEFAULT_BACKGROUND                                                                    \
     (VkClearColorValue)                                                                           \
     {                                                                                             \
@@ -50,6 +54,13 @@ extern "C" {
 #define DVZ_DEFAULT_COMMANDS_TRANSFER 0
 #define DVZ_DEFAULT_COMMANDS_RENDER   1
 #define DVZ_MAX_FRAMES_IN_FLIGHT      2
+#define DVZ_MAX_SCREENSHOTS           4
+#define DVZ_MAX_PICK_BATCHES          4
+#define DVZ_MAX_PICK_QUERIES          64 // maximum number of positions in a pick batch
+#define DVZ_SCREENCAST_DEPTH          3 // number of screencast frames being downloaded at once
+#define DVZ_VIDEO_QUEUE_CAPACITY      8 // number of frames waiting for the video encoder
+#define DVZ_MAX_WARMUP_THREADS        4 // number of threads creating graphics pipelines at once
+#define DVZ_GRAPHICS_REGISTRY_SIZE    64 // initial capacity of the graphics registry hash table
 
 
 
@@ -65,6 +76,7 @@ typedef enum
     DVZ_CANVAS_FLAGS_FPS = 0x0003, // NOTE: 1 bit for ImGUI, 1 bit for FPS
     DVZ_CANVAS_FLAGS_PICK = 0x0004,
     DVZ_CANVAS_FLAGS_OFFSCREEN = 0x0008,
+    DVZ_CANVAS_FLAGS_ON_DEMAND = 0x0010,
 
     DVZ_CANVAS_FLAGS_DPI_SCALE_050 = 0x1000,
     DVZ_CANVAS_FLAGS_DPI_SCALE_100 = 0x2000,
@@ -167,6 +179,36 @@ typedef enum
 
 
 
+// Video encoder policy when the encoder queue is full.
+typedef enum
+{
+    DVZ_VIDEO_POLICY_BLOCK, // the render loop waits for the encoder
+    DVZ_VIDEO_POLICY_DROP,  // the frame is dropped
+} DvzVideoPolicy;
+
+
+
+// Asynchronous screenshot status.
+typedef enum
+{
+    DVZ_SCREENSHOT_NONE,      // the slot has no staging image yet
+    DVZ_SCREENSHOT_IDLE,      // the slot is available
+    DVZ_SCREENSHOT_REQUESTED, // the copy will be recorded in the next frame
+    DVZ_SCREENSHOT_PENDING,   // the copy has been submitted, waiting for the frame fence
+} DvzScreenshotStatus;
+
+
+
+// Pick batch status.
+typedef enum
+{
+    DVZ_PICK_BATCH_IDLE,      // the batch is available
+    DVZ_PICK_BATCH_REQUESTED, // the copies will be recorded in the next frame
+    DVZ_PICK_BATCH_PENDING,   // the copies have been submitted, waiting for the frame fence
+} DvzPickBatchStatus;
+
+
+
 /*************************************************************************************************/
 /*  Event system                                                                                 */
 /*************************************************************************************************/
@@ -203,6 +245,7 @@ typedef enum
     DVZ_EVENT_PRE_SEND,           // called before sending the commands buffers
     DVZ_EVENT_POST_SEND,          // called after sending the commands buffers
     DVZ_EVENT_DESTROY,            // called before destruction
+    DVZ_EVENT_COUNT,
 } DvzEventType;
 
 
@@ -216,6 +259,16 @@ typedef enum
 
 
 
+// Event coalescing policy, applied when an event is enqueued for the async callbacks
+typedef enum
+{
+    DVZ_EVENT_COALESCE_NONE,       // every event is enqueued
+    DVZ_EVENT_COALESCE_LATEST,     // the last pending event of the same type is replaced
+    DVZ_EVENT_COALESCE_ACCUMULATE, // the deltas are added to the last pending event
+} DvzEventCoalesce;
+
+
+
 // Key modifiers
 // NOTE: must match GLFW values! no mapping is done for now
 typedef enum
@@ -271,7 +324,22 @@ typedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent);
 typedef struct DvzEventCallbackRegister DvzEventCallbackRegister;
 
 typedef struct DvzScreencast DvzScreencast;
+typedef struct DvzScreencastFrame DvzScreencastFrame;
+typedef struct DvzScreencastStats DvzScreencastStats;
+typedef struct DvzVideoEncoder DvzVideoEncoder;
+typedef struct DvzScreenshot DvzScreenshot;
+typedef struct DvzPickResult DvzPickResult;
+typedef struct DvzPickBatch DvzPickBatch;
 typedef struct DvzPendingRefill DvzPendingRefill;
+typedef struct DvzGraphicsKey DvzGraphicsKey;
+typedef struct DvzGraphicsEntry DvzGraphicsEntry;
+typedef struct DvzGraphicsRegistry DvzGraphicsRegistry;
+typedef struct DvzGraphicsWarmup DvzGraphicsWarmup;
+
+typedef void (*DvzScreenshotCallback)(
+    DvzCanvas*, uint8_t* rgba, uint32_t width, uint32_t height, void* user_data);
+typedef void (*DvzPickCallback)(
+    DvzCanvas*, uint32_t count, DvzPickResult* results, void* user_data);
 
 // Forward declarations.
 typedef struct DvzGui DvzGui;
@@ -354,6 +422,14 @@ struct DvzViewport
     // Used to discard transform on one axis
     int32_t interact_axis;
 
+    // Whether the vertex shader normalizes the positions with the MVP data_scale and data_shift.
+    int32_t data_norm;
+
+    // Streaming visuals: position of the oldest item in the vertex ring buffer, and capacity of
+    // the ring buffer (0 if the visual is not streamed).
+    uint32_t ring_base;
+    uint32_t ring_size;
+
     // TODO: aspect ratio
 };
 
@@ -452,6 +528,7 @@ struct DvzRefillEvent
     DvzCommands* cmds[32];
     DvzViewport viewport;
     VkClearColorValue clear_color;
+    bool full; // if false, only the invalidated secondary command buffers need to be rerecorded
 };
 
 
@@ -523,6 +600,45 @@ struct DvzEventCallbackRegister
 /*  Misc structs                                                                                 */
 /*************************************************************************************************/
 
+struct DvzScreencastFrame
+{
+    DvzScreencastStatus status;
+    DvzCommands cmds;
+    DvzSemaphores semaphore;
+    DvzFences fence;
+    DvzImages staging;
+    uint64_t seq;        // capture order
+    double request_time; // used to compute the readback latency
+};
+
+
+
+struct DvzScreencastStats
+{
+    uint64_t frames;         // number of downloaded frames
+    uint64_t dropped;        // number of frames skipped because all staging images were busy
+    double latency_avg;      // average readback latency, in seconds
+    double latency_max;      // maximum readback latency, in seconds
+    uint64_t encoded;        // number of frames encoded by the video encoder
+    uint64_t encode_dropped; // number of frames dropped because the encoder queue was full
+    double encode_avg;       // average encoding time per frame, in seconds
+};
+
+
+
+struct DvzVideoEncoder
+{
+    void* video; // opaque Video pointer
+    DvzThread thread;
+    DvzRing queue; // pointers to the RGBA frames to encode
+    DvzVideoPolicy policy;
+    uint64_t dropped;
+    atomic(uint64_t, encoded);
+    atomic(uint64_t, encode_time_us);
+};
+
+
+
 struct DvzScreencast
 {
     DvzObject obj;
@@ -530,23 +646,109 @@ struct DvzScreencast
 
     bool has_alpha;
     DvzCanvas* canvas;
-    DvzCommands cmds;
-    DvzSemaphores semaphore;
-    DvzFences fence;
-    DvzImages staging;
+    DvzScreencastFrame frames[DVZ_SCREENCAST_DEPTH];
     DvzSubmit submit;
-    uint64_t frame_idx;
+    uint64_t frame_idx; // number of SCREENCAST events
+    uint64_t seq;       // number of requested frames
     DvzClock clock;
-    DvzScreencastStatus status;
+    DvzScreencastStats stats;
+    void* user_data;
+};
+
+
+
+struct DvzScreenshot
+{
+    DvzScreenshotStatus status;
+    bool has_alpha;
+    uint32_t frame; // index of the frame in flight whose fence signals the end of the copy
+    DvzCommands cmds;
+    DvzImages staging; // persistent linear staging image
+    uint8_t* rgba;     // persistent CPU buffer passed to the callback
+    DvzScreenshotCallback callback;
     void* user_data;
 };
 
 
 
+struct DvzPickResult
+{
+    uvec2 pos;          // requested position, in pixel coordinates
+    ivec4 picked;       // pick attachment value, or RGBA color if the canvas has no pick support
+    uint64_t frame_idx; // index of the frame the value was read from
+    double latency;     // time between the request and the result, in seconds
+};
+
+
+
+struct DvzPickBatch
+{
+    DvzPickBatchStatus status;
+    uint32_t count;
+    uvec2 positions[DVZ_MAX_PICK_QUERIES];
+    uint32_t frame;      // index of the frame in flight whose fence signals the end of the copies
+    uint64_t frame_idx;  // index of the frame the values are read from
+    double request_time; // used to compute the latency
+    DvzCommands cmds;
+    DvzBuffer staging; // persistently-mapped host-visible buffer, one ivec4 per query
+    DvzPickResult results[DVZ_MAX_PICK_QUERIES];
+    DvzPickCallback callback;
+    void* user_data;
+};
+
+
+
+struct DvzGraphicsKey
+{
+    DvzGraphicsType type;
+    int flags;
+    DvzRenderpass* renderpass;
+    uint32_t subpass;
+};
+
+
+
+struct DvzGraphicsEntry
+{
+    DvzGraphicsKey key;
+    DvzGraphics* graphics; // NULL for an empty slot
+    uint32_t ref_count;    // number of users, may be 0 for warmed-up graphics
+};
+
+
+
+// Open-addressing hash table of the builtin graphics pipelines of a canvas.
+struct DvzGraphicsRegistry
+{
+    uint32_t capacity; // power of two
+    uint32_t count;
+    DvzGraphicsEntry* entries;
+    uint64_t hits;   // number of requests that reused an existing pipeline
+    uint64_t misses; // number of requests that created a new pipeline
+};
+
+
+
+struct DvzGraphicsWarmup
+{
+    uint32_t count;         // number of graphics pipelines being created in the background
+    DvzGraphics** graphics; // graphics allocated by the main thread, created by the workers
+    bool* done;             // protected by the lock
+    uint32_t next;          // index of the next graphics to create, protected by the lock
+    pthread_mutex_t lock;
+    pthread_cond_t cond;   // signaled every time a graphics has been created
+    uint32_t thread_count; // 0 when there is no warm-up in progress
+    DvzThread threads[DVZ_MAX_WARMUP_THREADS];
+};
+
+
+
 struct DvzPendingRefill
 {
     bool completed[DVZ_MAX_SWAPCHAIN_IMAGES];
     atomic(DvzRefillStatus, status);
+    atomic(bool, full_requested); // set from any thread by dvz_canvas_to_refill()
+    bool full;                    // whether the ongoing refill invalidates all cached commands
 };
 
 
@@ -573,6 +775,11 @@ struct DvzCanvas
     atomic(DvzObjectStatus, cur_status);
     atomic(bool, to_close);
 
+    // On-demand rendering: a frame is only rendered when the canvas is dirty.
+    bool on_demand;
+    bool idle; // whether the last frame was skipped
+    atomic(bool, dirty);
+
     DvzWindow* window;
 
     // Swapchain.
@@ -603,6 +810,8 @@ struct DvzCanvas
     DvzSemaphores* present_semaphores;
     DvzFences fences_render_finished;
     DvzFences fences_flight;
+    DvzTransferSync sync_frame;    // signaled by the frames, waited on by the transfer batches
+    DvzTransferSync sync_transfer; // signaled by the transfer batches, waited on by the frames
 
     // Default command buffers.
     DvzCommands cmds_transfer;
@@ -613,6 +822,8 @@ struct DvzCanvas
 
     // Graphics pipelines.
     DvzContainer graphics;
+    DvzGraphicsRegistry graphics_registry;
+    DvzGraphicsWarmup warmup;
 
     // Event callbacks, running in the background thread, may be slow, for end-users.
     uint32_t callbacks_count;
@@ -620,10 +831,12 @@ struct DvzCanvas
 
     // Event queue.
     DvzFifo event_queue;
-    // DvzEvent events[DVZ_MAX_FIFO_CAPACITY];
+    DvzPool event_pool; // recycled DvzEvent items of the event queue
     DvzThread event_thread;
     bool enable_lock;
     atomic(DvzEventType, event_processing);
+    DvzEventCoalesce event_coalesce[DVZ_EVENT_COUNT]; // coalescing policy of each event type
+    uint64_t event_coalesced[DVZ_EVENT_COUNT];        // number of events merged, per event type
 
     bool captured; // if true, mouse and keyboard should not be processed
     DvzMouse mouse;
@@ -634,6 +847,8 @@ struct DvzCanvas
     DvzContainer guis;
 
     DvzScreencast* screencast;
+    DvzScreenshot screenshots[DVZ_MAX_SCREENSHOTS];
+    DvzPickBatch pick_batches[DVZ_MAX_PICK_BATCHES];
     DvzPendingRefill refills;
 
     DvzViewport viewport;
@@ -841,6 +1056,16 @@ DVZ_EXPORT void dvz_event_callback(
  */
 DVZ_EXPORT void dvz_canvas_to_refill(DvzCanvas* canvas);
 
+/**
+ * Trigger a partial canvas refill at the next frame.
+ *
+ * The primary command buffers are refilled, but the cached secondary command buffers that were
+ * not explicitly invalidated are executed as they are, without being recorded again.
+ *
+ * @param canvas the canvas
+ */
+DVZ_EXPORT void dvz_canvas_to_refill_partial(DvzCanvas* canvas);
+
 /**
  * Close the canvas at the next frame.
  *
@@ -848,6 +1073,29 @@ DVZ_EXPORT void dvz_canvas_to_refill(DvzCanvas* canvas);
  */
 DVZ_EXPORT void dvz_canvas_to_close(DvzCanvas* canvas);
 
+/**
+ * Enable or disable on-demand rendering.
+ *
+ * In on-demand mode, a frame is only acquired, recorded and submitted when the canvas is dirty:
+ * after an input event, a GUI change, a visual data change, a data transfer, a refill request, or
+ * when a TIMER callback is due. When all canvases are idle, the main loop blocks on the window
+ * events instead of spinning.
+ *
+ * @param canvas the canvas
+ * @param enable whether to enable on-demand rendering
+ */
+DVZ_EXPORT void dvz_canvas_on_demand(DvzCanvas* canvas, bool enable);
+
+/**
+ * Mark the canvas as needing a new frame, in on-demand rendering mode.
+ *
+ * This function is thread-safe. It only needs to be called by the user when modifying GPU
+ * objects directly, as the Datoviz data changes already mark the canvas as dirty.
+ *
+ * @param canvas the canvas
+ */
+DVZ_EXPORT void dvz_canvas_dirty(DvzCanvas* canvas);
+
 
 
 /*************************************************************************************************/
@@ -881,6 +1129,15 @@ DVZ_EXPORT void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alph
  */
 DVZ_EXPORT void dvz_screencast_destroy(DvzCanvas* canvas);
 
+/**
+ * Return the screencast statistics.
+ *
+ * @param canvas the canvas
+ * @returns the number of downloaded and dropped frames, the readback latency, and the video
+ *     encoder statistics
+ */
+DVZ_EXPORT DvzScreencastStats dvz_screencast_stats(DvzCanvas* canvas);
+
 /**
  * Make a screenshot.
  *
@@ -896,6 +1153,26 @@ DVZ_EXPORT void dvz_screencast_destroy(DvzCanvas* canvas);
  */
 DVZ_EXPORT uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha);
 
+/**
+ * Make a screenshot asynchronously.
+ *
+ * The copy of the swapchain image is submitted with the next frame, in a persistent staging
+ * image, and the callback is called in the main thread once the fence of that frame has
+ * signaled. There is no device-wide synchronization.
+ *
+ * !!! important
+ *     The RGB(A) buffer passed to the callback is only valid during the callback call. It must
+ *     be copied if it needs to be kept.
+ *
+ * @param canvas the canvas
+ * @param has_alpha whether the screenshot array is RGB or RGBA
+ * @param callback the function called with the screenshot
+ * @param user_data a pointer passed to the callback
+ * @returns whether the screenshot was scheduled, false if too many screenshots are pending
+ */
+DVZ_EXPORT bool dvz_screenshot_async(
+    DvzCanvas* canvas, bool has_alpha, DvzScreenshotCallback callback, void* user_data);
+
 /**
  * Make a screenshot and save it to a PNG file.
  *
@@ -922,6 +1199,27 @@ DVZ_EXPORT void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path);
  */
 DVZ_EXPORT void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picked);
 
+/**
+ * Pick several pixels in a canvas asynchronously.
+ *
+ * The pixel copies are recorded with the next frame and the results are read from a single
+ * mapped buffer once the fence of that frame has signaled, without any device-wide
+ * synchronization. The callback is called in the main thread with one result per position.
+ *
+ * !!! important
+ *     The results passed to the callback are only valid during the callback call.
+ *
+ * @param canvas the canvas
+ * @param count the number of positions, at most `DVZ_MAX_PICK_QUERIES`
+ * @param positions the coordinates of the points, in pixel coordinates
+ * @param callback the function called with the results
+ * @param user_data a pointer passed to the callback
+ * @returns whether the batch was scheduled, false if too many batches are pending
+ */
+DVZ_EXPORT bool dvz_canvas_pick_batch(
+    DvzCanvas* canvas, uint32_t count, uvec2* positions, //
+    DvzPickCallback callback, void* user_data);
+
 
 
 /*************************************************************************************************/
@@ -942,6 +1240,17 @@ DVZ_EXPORT void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picke
 DVZ_EXPORT void
 dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char* path, bool record);
 
+/**
+ * Set what happens when the video encoder is slower than the screencast.
+ *
+ * The frames are encoded in a background thread, fed through a bounded queue. When the queue is
+ * full, the render loop either waits for the encoder (default) or drops the frame.
+ *
+ * @param canvas the canvas
+ * @param policy the video encoder policy
+ */
+DVZ_EXPORT void dvz_canvas_video_policy(DvzCanvas* canvas, DvzVideoPolicy policy);
+
 /**
  * Pause the live video screencast.
  *
@@ -1179,6 +1488,29 @@ DVZ_EXPORT void dvz_event_timer(DvzCanvas* canvas, uint64_t idx, double time, do
  */
 DVZ_EXPORT int dvz_event_pending(DvzCanvas* canvas, DvzEventType type);
 
+/**
+ * Set the coalescing policy of an event type.
+ *
+ * When an event is enqueued for the async callbacks while the last pending event in the queue
+ * has the same type, the two events may be merged into one. By default, mouse move and resize
+ * events keep the latest value, mouse wheel events accumulate their direction, and the other
+ * events (clicks, keys...) are never coalesced.
+ *
+ * @param canvas the canvas
+ * @param type the event type
+ * @param policy the coalescing policy
+ */
+DVZ_EXPORT void dvz_event_coalesce(DvzCanvas* canvas, DvzEventType type, DvzEventCoalesce policy);
+
+/**
+ * Return the number of events that were merged into a pending event of the same type.
+ *
+ * @param canvas the canvas
+ * @param type the event type
+ * @returns the number of coalesced events
+ */
+DVZ_EXPORT uint64_t dvz_event_coalesced(DvzCanvas* canvas, DvzEventType type);
+
 /**
  * Stop the background event loop.
  *
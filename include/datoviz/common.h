@@ -40,6 +40,7 @@ extern "C" {
 #if MSVC
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <intrin.h> // bit scan intrinsics
 #include <stdint.h> // portable: uint64_t   MSVC: __int64
 
 // MSVC defines this in winsock2.h!?
@@ -102,6 +103,12 @@ END_INCL_NO_WARN
 
 #define DVZ_MAX_FRAMES_IN_FLIGHT    2
 #define DVZ_CONTAINER_DEFAULT_COUNT 64
+#define DVZ_CONTAINER_MAX_CHUNKS    32
+
+#define DVZ_HANDLE_INDEX_BITS       20
+#define DVZ_HANDLE_INDEX_MASK       ((1u << DVZ_HANDLE_INDEX_BITS) - 1)
+#define DVZ_HANDLE_GENERATION_MASK  ((1u << (32 - DVZ_HANDLE_INDEX_BITS)) - 1)
+#define DVZ_HANDLE_NONE             0
 
 
 /*************************************************************************************************/
@@ -162,6 +169,68 @@ END_INCL_NO_WARN
 
 
 
+/*************************************************************************************************/
+/*  SIMD                                                                                         */
+/*************************************************************************************************/
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DVZ_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define DVZ_SIMD_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define DVZ_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define DVZ_SIMD_NEON 0
+#endif
+
+// The kernels beyond the SSE2 x86-64 baseline are compiled with target attributes and selected
+// at runtime.
+#if DVZ_SIMD_X86 && (GCC || CLANG)
+#define DVZ_SIMD_AVX 1
+
+static inline bool _cpu_has_ssse3(void)
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("ssse3") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+static inline bool _cpu_has_avx(void)
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+static inline bool _cpu_has_avx2(void)
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+#else
+#define DVZ_SIMD_AVX 0
+#endif
+
+
+
 /*************************************************************************************************/
 /*  Common enums                                                                                 */
 /*************************************************************************************************/
@@ -242,9 +311,18 @@ typedef struct DvzObject DvzObject;
 typedef struct DvzContainer DvzContainer;
 typedef struct DvzContainerIterator DvzContainerIterator;
 typedef struct DvzThread DvzThread;
+typedef struct DvzPool DvzPool;
+typedef struct DvzArena DvzArena;
+
+// Generation-tagged handle to an item of a container: slot index in the low bits, slot generation
+// in the high bits.
+typedef uint32_t DvzHandle;
 
 typedef void* (*DvzThreadCallback)(void*);
 
+// Callback called whenever a datoviz data structure allocates memory from the heap.
+typedef void (*DvzAllocHook)(size_t size, void* user_data);
+
 
 
 /*************************************************************************************************/
@@ -263,13 +341,52 @@ struct DvzObject
 
 
 
+// The items are stored in chunks that are never moved nor freed before the container is
+// destroyed, so that pointers to the items remain valid. The first chunk has the initial
+// capacity, and every new chunk doubles the capacity of the container.
 struct DvzContainer
 {
-    uint32_t count;
-    uint32_t capacity;
+    uint32_t count;    // number of allocated items, including destroyed items not yet released
+    uint32_t capacity; // total number of slots
     DvzObjectType type;
-    void** items;
     size_t item_size;
+
+    uint32_t chunk_size; // number of slots in the first chunk
+    uint32_t chunk_count;
+    uint8_t* chunks[DVZ_CONTAINER_MAX_CHUNKS];
+
+    uint64_t* live;        // bitmap of the allocated slots
+    uint32_t* generations; // generation of every slot, incremented when the slot is released
+    uint32_t first_free;   // all slots below this index are allocated
+};
+
+
+
+// Thread-safe pool of fixed-size objects. The objects are allocated in chunks that are only freed
+// when the pool is destroyed, and the released objects are recycled through a free list.
+struct DvzPool
+{
+    size_t item_size;
+    uint32_t chunk_size; // number of items in every chunk
+    uint32_t chunk_count;
+    uint8_t** chunks;
+    void* free_list; // released items, linked through their first bytes
+    uint32_t used;   // number of items in use
+    pthread_mutex_t lock;
+};
+
+
+
+// Scratch memory reset at every use cycle (frame, bake...). When the main block is full, overflow
+// blocks are allocated, and the main block is enlarged at the next reset so that the steady state
+// does not allocate memory.
+struct DvzArena
+{
+    uint8_t* data;
+    size_t capacity;
+    size_t offset;
+    void* overflow;       // linked list of overflow blocks
+    size_t overflow_size; // total size of the overflow blocks
 };
 
 
@@ -299,6 +416,11 @@ struct DvzMVP
     mat4 view;
     mat4 proj;
     float time;
+
+    // Data normalization done in the vertex shader (panels with DVZ_TRANSFORM_FLAGS_GPU).
+    float _std140_pad[3]; // std140 aligns the following vec4 to 16 bytes
+    vec4 data_scale;
+    vec4 data_shift;
 };
 
 
@@ -344,6 +466,37 @@ static inline bool dvz_obj_is_created(DvzObject* obj)
 
 
 
+/*************************************************************************************************/
+/*  Allocation tracking                                                                          */
+/*************************************************************************************************/
+
+/**
+ * Set a callback called whenever a datoviz data structure allocates memory from the heap.
+ *
+ * The containers, pools, arenas, and arrays report their allocations, which makes it possible to
+ * check that the steady state of the frame loop does not allocate memory.
+ *
+ * @param hook the callback, or NULL to remove it
+ * @param user_data a pointer passed to the callback
+ */
+DVZ_EXPORT void dvz_alloc_hook(DvzAllocHook hook, void* user_data);
+
+/**
+ * Return the number of heap allocations reported by the datoviz data structures so far.
+ *
+ * @returns the number of allocations
+ */
+DVZ_EXPORT uint64_t dvz_alloc_count(void);
+
+/**
+ * Report a heap allocation (internal).
+ *
+ * @param size the allocation size, in bytes
+ */
+DVZ_EXPORT void dvz_alloc_track(size_t size);
+
+
+
 /*************************************************************************************************/
 /*  Container                                                                                    */
 /*************************************************************************************************/
@@ -357,6 +510,147 @@ static uint64_t dvz_next_pow2(uint64_t x)
     return p;
 }
 
+// Number of trailing zero bits of a nonzero 64-bit integer.
+static inline uint32_t _dvz_ctz64(uint64_t x)
+{
+    ASSERT(x != 0);
+#if MSVC
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, x);
+    return (uint32_t)idx;
+#else
+    return (uint32_t)__builtin_ctzll(x);
+#endif
+}
+
+// Index of the most significant bit of a nonzero 32-bit integer.
+static inline uint32_t _dvz_msb32(uint32_t x)
+{
+    ASSERT(x != 0);
+#if MSVC
+    unsigned long idx = 0;
+    _BitScanReverse(&idx, x);
+    return (uint32_t)idx;
+#else
+    return 31 - (uint32_t)__builtin_clz(x);
+#endif
+}
+
+// Number of 64-bit words in the bitmap of a container.
+static inline uint32_t _container_words(uint32_t capacity) { return (capacity + 63) / 64; }
+
+// Pointer to the item in a given slot. Chunk #0 has chunk_size slots, chunk #k > 0 starts at
+// slot chunk_size * 2^(k-1) and has as many slots.
+static inline void* _container_slot(DvzContainer* container, uint32_t idx)
+{
+    ASSERT(container != NULL);
+    ASSERT(idx < container->capacity);
+    uint32_t chunk = 0;
+    uint32_t offset = idx;
+    if (idx >= container->chunk_size)
+    {
+        chunk = _dvz_msb32(idx / container->chunk_size) + 1;
+        offset = idx - (container->chunk_size << (chunk - 1));
+    }
+    ASSERT(chunk < container->chunk_count);
+    return container->chunks[chunk] + offset * container->item_size;
+}
+
+static inline bool _container_is_live(DvzContainer* container, uint32_t idx)
+{
+    return ((container->live[idx / 64] >> (idx % 64)) & 1) != 0;
+}
+
+// Add a chunk, doubling the capacity of the container.
+static void _container_grow(DvzContainer* container)
+{
+    ASSERT(container != NULL);
+    ASSERT(container->chunk_count < DVZ_CONTAINER_MAX_CHUNKS);
+    uint32_t old_capacity = container->capacity;
+    uint32_t size = old_capacity > 0 ? old_capacity : container->chunk_size;
+    uint32_t capacity = old_capacity + size;
+    ASSERT(capacity - 1 <= DVZ_HANDLE_INDEX_MASK);
+    log_trace("grow container up to %d items", capacity);
+
+    // NOTE: the existing chunks are not moved.
+    dvz_alloc_track(size * container->item_size);
+    container->chunks[container->chunk_count] = (uint8_t*)calloc(size, container->item_size);
+    ASSERT(container->chunks[container->chunk_count] != NULL);
+    container->chunk_count++;
+
+    uint32_t old_words = _container_words(old_capacity);
+    uint32_t words = _container_words(capacity);
+    container->live = (uint64_t*)realloc(container->live, words * sizeof(uint64_t));
+    ASSERT(container->live != NULL);
+    memset(&container->live[old_words], 0, (words - old_words) * sizeof(uint64_t));
+
+    container->generations =
+        (uint32_t*)realloc(container->generations, capacity * sizeof(uint32_t));
+    ASSERT(container->generations != NULL);
+    for (uint32_t i = old_capacity; i < capacity; i++)
+        container->generations[i] = 1;
+
+    container->capacity = capacity;
+}
+
+// Release an allocated slot. Its generation is incremented so that the existing handles to the
+// slot become invalid.
+static void _container_release(DvzContainer* container, uint32_t idx)
+{
+    ASSERT(container != NULL);
+    ASSERT(_container_is_live(container, idx));
+    container->live[idx / 64] &= ~(1ULL << (idx % 64));
+    uint32_t gen = (container->generations[idx] + 1) & DVZ_HANDLE_GENERATION_MASK;
+    container->generations[idx] = gen == 0 ? 1 : gen;
+    container->first_free = MIN(container->first_free, idx);
+    container->count--;
+    ASSERT(container->count < UINT32_MAX);
+}
+
+// Release the slots of all destroyed objects, and return the number of released slots.
+static uint32_t _container_reclaim(DvzContainer* container)
+{
+    ASSERT(container != NULL);
+    uint32_t released = 0;
+    uint32_t words = _container_words(container->capacity);
+    uint64_t bits = 0;
+    uint32_t idx = 0;
+    for (uint32_t w = 0; w < words; w++)
+    {
+        bits = container->live[w];
+        while (bits != 0)
+        {
+            idx = w * 64 + _dvz_ctz64(bits);
+            bits &= bits - 1;
+            if (((DvzObject*)_container_slot(container, idx))->status ==
+                DVZ_OBJECT_STATUS_DESTROYED)
+            {
+                _container_release(container, idx);
+                released++;
+            }
+        }
+    }
+    return released;
+}
+
+// Return the lowest free slot, or UINT32_MAX if the container is full.
+static uint32_t _container_first_free(DvzContainer* container)
+{
+    ASSERT(container != NULL);
+    uint32_t words = _container_words(container->capacity);
+    uint64_t bits = 0;
+    uint32_t idx = 0;
+    for (uint32_t w = container->first_free / 64; w < words; w++)
+    {
+        bits = ~container->live[w];
+        if (bits == 0)
+            continue;
+        idx = w * 64 + _dvz_ctz64(bits);
+        return idx < container->capacity ? idx : UINT32_MAX;
+    }
+    return UINT32_MAX;
+}
+
 /**
  * Create a container that will contain an arbitrary number of objects of the same type.
  *
@@ -367,28 +661,23 @@ static uint64_t dvz_next_pow2(uint64_t x)
 static DvzContainer dvz_container(uint32_t count, size_t item_size, DvzObjectType type)
 {
     ASSERT(count > 0);
-    ASSERT(item_size > 0);
+    ASSERT(item_size >= sizeof(DvzObject));
     // log_trace("create container");
     DvzContainer container = {0};
     container.count = 0;
     container.item_size = item_size;
     container.type = type;
-    container.capacity = dvz_next_pow2(count);
-    ASSERT(container.capacity > 0);
-    container.items = (void**)calloc(container.capacity, sizeof(void*));
-    // NOTE: we shouldn't rely on calloc() initializing pointer values to NULL as it is not
-    // guaranteed that NULL is represented by 0 bits.
-    // https://stackoverflow.com/a/22624643/1595060
-    for (uint32_t i = 0; i < container.capacity; i++)
-    {
-        container.items[i] = NULL;
-    }
+    container.chunk_size = (uint32_t)dvz_next_pow2(count);
+    _container_grow(&container);
+    ASSERT(container.capacity == container.chunk_size);
     return container;
 }
 
 /**
  * Free a given object in the constainer if it was previously destroyed.
  *
+ * The slot of the object may then be reused by a subsequent allocation.
+ *
  * @param container the container
  * @param idx the index of the object within the container
  */
@@ -396,25 +685,24 @@ static void dvz_container_delete_if_destroyed(DvzContainer* container, uint32_t
 {
     ASSERT(container != NULL);
     ASSERT(container->capacity > 0);
-    ASSERT(container->items != NULL);
+    ASSERT(container->live != NULL);
     ASSERT(idx < container->capacity);
-    if (container->items[idx] == NULL)
+    if (!_container_is_live(container, idx))
         return;
-    DvzObject* object = (DvzObject*)container->items[idx];
+    DvzObject* object = (DvzObject*)_container_slot(container, idx);
     if (object->status == DVZ_OBJECT_STATUS_DESTROYED)
     {
         // log_trace("delete container item #%d", idx);
-        FREE(container->items[idx]);
-        container->items[idx] = NULL;
-        container->count--;
-        ASSERT(container->count < UINT32_MAX);
+        _container_release(container, idx);
     }
 }
 
 /**
  * Get a pointer to a new object in the container.
  *
- * If the container is full, it will be automatically resized.
+ * The object is allocated in the lowest free slot. If the container is full, the slots of the
+ * destroyed objects are released, and the container is automatically resized if only few of them
+ * were destroyed. The existing objects are never moved in memory.
  *
  * @param container the container
  * @returns a pointer to an allocated object
@@ -423,55 +711,34 @@ static void* dvz_container_alloc(DvzContainer* container)
 {
     ASSERT(container != NULL);
     ASSERT(container->capacity > 0);
-    ASSERT(container->items != NULL);
-    uint32_t available_slot = UINT32_MAX;
-
-    // Free the memory of destroyed objects and find the first available slot.
-    for (uint32_t i = 0; i < container->capacity; i++)
-    {
-        dvz_container_delete_if_destroyed(container, i);
-        // Find first slot with empty pointer, to use for new allocation.
-        if (container->items[i] == NULL && available_slot == UINT32_MAX)
-            available_slot = i;
-    }
+    ASSERT(container->live != NULL);
 
-    // If no slot, need to reallocate container.
-    if (available_slot == UINT32_MAX)
+    uint32_t idx = _container_first_free(container);
+    if (idx == UINT32_MAX)
     {
-        log_trace("reallocate container up to %d items", 2 * container->capacity);
-        void** _new =
-            (void**)realloc(container->items, 2 * container->capacity * container->item_size);
-        ASSERT(_new != NULL);
-        container->items = _new;
-
-        ASSERT(container->items != NULL);
-        // Initialize newly-allocated pointers to NULL.
-        for (uint32_t i = container->capacity; i < 2 * container->capacity; i++)
-        {
-            container->items[i] = NULL;
-        }
-        ASSERT(container->items[container->capacity] == NULL);
-        ASSERT(container->items[2 * container->capacity - 1] == NULL);
-        // Return the first empty slot of the newly-allocated container.
-        available_slot = container->capacity;
-        // Update the container capacity.
-        container->capacity *= 2;
+        // NOTE: growing the container when less than a quarter of the slots could be released
+        // bounds the amortized cost of the release scans.
+        uint32_t released = _container_reclaim(container);
+        if (released == 0 || released < container->capacity / 4)
+            _container_grow(container);
+        idx = _container_first_free(container);
     }
-    ASSERT(available_slot < UINT32_MAX);
-    ASSERT(container->items[available_slot] == NULL);
+    ASSERT(idx < container->capacity);
+    ASSERT(!_container_is_live(container, idx));
 
-    // Memory allocation on the heap and store the pointer in the container.
-    // log_trace("container allocates new item #%d", available_slot);
-    container->items[available_slot] = calloc(1, container->item_size);
+    // log_trace("container allocates new item #%d", idx);
+    void* item = _container_slot(container, idx);
+    memset(item, 0, container->item_size);
+    container->live[idx / 64] |= 1ULL << (idx % 64);
+    container->first_free = idx + 1;
     container->count++;
-    ASSERT(container->items[available_slot] != NULL);
 
     // Initialize the DvzObject field.
-    DvzObject* obj = (DvzObject*)container->items[available_slot];
+    DvzObject* obj = (DvzObject*)item;
     obj->status = DVZ_OBJECT_STATUS_ALLOC;
     obj->type = container->type;
 
-    return container->items[available_slot];
+    return item;
 }
 
 /**
@@ -479,19 +746,76 @@ static void* dvz_container_alloc(DvzContainer* container)
  *
  * @param container the container
  * @param idx the index of the object within the container
- * @param returns a pointer to the object at the specified index
+ * @param returns a pointer to the object at the specified index, or NULL if the slot is free
  */
 static void* dvz_container_get(DvzContainer* container, uint32_t idx)
 {
     ASSERT(container != NULL);
-    ASSERT(container->items != NULL);
+    ASSERT(container->live != NULL);
     ASSERT(idx < container->capacity);
-    return container->items[idx];
+    return _container_is_live(container, idx) ? _container_slot(container, idx) : NULL;
+}
+
+/**
+ * Return a generation-tagged handle to an object of the container.
+ *
+ * The handle becomes invalid when the slot of the object is released, even if the slot is then
+ * reused by another object.
+ *
+ * @param container the container
+ * @param item a pointer to an object of the container
+ * @returns the handle, or DVZ_HANDLE_NONE if the object does not belong to the container
+ */
+static DvzHandle dvz_container_handle(DvzContainer* container, const void* item)
+{
+    ASSERT(container != NULL);
+    ASSERT(item != NULL);
+    const uint8_t* ptr = (const uint8_t*)item;
+    uint32_t first = 0;
+    uint32_t size = container->chunk_size;
+    uint32_t idx = 0;
+    for (uint32_t chunk = 0; chunk < container->chunk_count; chunk++)
+    {
+        if (ptr >= container->chunks[chunk] &&
+            ptr < container->chunks[chunk] + size * container->item_size)
+        {
+            idx = first + (uint32_t)((size_t)(ptr - container->chunks[chunk]) /
+                                     container->item_size);
+            if (!_container_is_live(container, idx))
+                return DVZ_HANDLE_NONE;
+            return (container->generations[idx] << DVZ_HANDLE_INDEX_BITS) | idx;
+        }
+        first += size;
+        size = first;
+    }
+    return DVZ_HANDLE_NONE;
+}
+
+/**
+ * Return the object referred to by a handle.
+ *
+ * @param container the container
+ * @param handle the handle
+ * @returns a pointer to the object, or NULL if the handle is no longer valid
+ */
+static void* dvz_container_resolve(DvzContainer* container, DvzHandle handle)
+{
+    ASSERT(container != NULL);
+    uint32_t idx = handle & DVZ_HANDLE_INDEX_MASK;
+    uint32_t gen = handle >> DVZ_HANDLE_INDEX_BITS;
+    if (handle == DVZ_HANDLE_NONE || idx >= container->capacity)
+        return NULL;
+    if (!_container_is_live(container, idx) || container->generations[idx] != gen)
+        return NULL;
+    DvzObject* obj = (DvzObject*)_container_slot(container, idx);
+    return obj->status == DVZ_OBJECT_STATUS_DESTROYED ? NULL : obj;
 }
 
 /**
  * Continue an already-started loop iteration on a container.
  *
+ * The destroyed objects are skipped. The iteration does not modify the container.
+ *
  * @param container the container
  * @returns a pointer to the next object in the container, or NULL at the end
  */
@@ -505,25 +829,39 @@ static void dvz_container_iter(DvzContainerIterator* iterator)
     // the infinite while loop stops.
     iterator->item = NULL;
 
-    if (container->items == NULL || container->capacity == 0 || container->count == 0)
+    if (container->live == NULL || container->capacity == 0 || container->count == 0)
         return;
     if (iterator->idx >= container->capacity)
         return;
-    ASSERT(iterator->idx <= container->capacity - 1);
-    for (uint32_t i = iterator->idx; i < container->capacity; i++)
+
+    // Go through the allocated slots with the bitmap.
+    uint32_t words = _container_words(container->capacity);
+    uint32_t w = iterator->idx / 64;
+    uint64_t bits = container->live[w] & (~0ULL << (iterator->idx % 64));
+    uint32_t idx = 0;
+    DvzObject* obj = NULL;
+    while (true)
     {
-        dvz_container_delete_if_destroyed(container, i);
-        if (container->items[i] != NULL)
+        while (bits == 0)
+        {
+            if (++w >= words)
+            {
+                // End the outer loop, reset the internal idx.
+                iterator->idx = 0;
+                return;
+            }
+            bits = container->live[w];
+        }
+        idx = w * 64 + _dvz_ctz64(bits);
+        bits &= bits - 1;
+        obj = (DvzObject*)_container_slot(container, idx);
+        if (obj->status != DVZ_OBJECT_STATUS_DESTROYED)
         {
-            iterator->idx = i + 1;
-            // log_info("item %d: %d", i, container->items[i]);
-            iterator->item = container->items[i];
+            iterator->idx = idx + 1;
+            iterator->item = obj;
             return;
         }
     }
-    // End the outer loop, reset the internal idx.
-    iterator->idx = 0;
-    iterator->item = NULL;
 }
 
 /**
@@ -556,39 +894,31 @@ static DvzContainerIterator dvz_container_iterator(DvzContainer* container)
 static void dvz_container_destroy(DvzContainer* container)
 {
     ASSERT(container != NULL);
-    if (container->items == NULL)
+    if (container->live == NULL)
         return;
-    ASSERT(container->items != NULL);
     // log_trace("container destroy");
-    // Check all elements have been destroyed, and free them if necessary.
+    // Check all elements have been destroyed.
     uint32_t count = container->count;
     DvzObject* item = NULL;
     for (uint32_t i = 0; i < container->capacity; i++)
     {
-        if (container->items[i] != NULL)
-        {
-            // log_trace("deleting container item #%d", i);
-            // When destroying the container, ensure that all objects have been destroyed first.
-            // NOTE: only works if every item has a DvzObject as first struct field.
-            item = (DvzObject*)container->items[i];
-            dvz_container_delete_if_destroyed(container, i);
-            // Also deallocate objects allocated/initialized, but not created/destroyed.
-            if (container->items[i] != NULL)
-            {
-                ASSERT(item->status <= DVZ_OBJECT_STATUS_INIT);
-                ASSERT(item->status != DVZ_OBJECT_STATUS_DESTROYED);
-                FREE(container->items[i]);
-                container->items[i] = NULL;
-                container->count--;
-                ASSERT(container->count < UINT32_MAX);
-            }
-            ASSERT(container->items[i] == NULL);
-        }
+        if (!_container_is_live(container, i))
+            continue;
+        // When destroying the container, ensure that all objects have been destroyed first.
+        // NOTE: only works if every item has a DvzObject as first struct field.
+        // Also deallocate objects allocated/initialized, but not created/destroyed.
+        item = (DvzObject*)_container_slot(container, i);
+        ASSERT(item->status <= DVZ_OBJECT_STATUS_INIT);
+        _container_release(container, i);
     }
     ASSERT(container->count == 0);
     // log_trace("free container items");
-    FREE(container->items);
+    for (uint32_t i = 0; i < container->chunk_count; i++)
+        FREE(container->chunks[i]);
+    FREE(container->live);
+    FREE(container->generations);
     log_trace("container destroy (%d elements)", count);
+    container->chunk_count = 0;
     container->capacity = 0;
 }
 
@@ -600,12 +930,202 @@ static void dvz_container_destroy(DvzContainer* container)
         {                                                                                         \
             o = _iter.item;                                                                       \
             f(o);                                                                                 \
+            dvz_container_delete_if_destroyed(&c, _iter.idx - 1);                                 \
             dvz_container_iter(&_iter);                                                           \
         }                                                                                         \
     }
 
 
 
+/*************************************************************************************************/
+/*  Object pool                                                                                  */
+/*************************************************************************************************/
+
+/**
+ * Create a pool of fixed-size objects.
+ *
+ * @param item_size the size of every object, in bytes
+ * @param chunk_size the number of objects allocated at once when the pool is empty
+ * @returns the pool
+ */
+static DvzPool dvz_pool(size_t item_size, uint32_t chunk_size)
+{
+    ASSERT(item_size > 0);
+    ASSERT(chunk_size > 0);
+    DvzPool pool = {0};
+    // NOTE: the free list is stored in the released items, which are kept aligned to 16 bytes.
+    pool.item_size = (MAX(item_size, sizeof(void*)) + 15) / 16 * 16;
+    pool.chunk_size = chunk_size;
+    pthread_mutex_init(&pool.lock, NULL);
+    return pool;
+}
+
+/**
+ * Take a zero-initialized object from a pool.
+ *
+ * @param pool the pool
+ * @returns a pointer to the object
+ */
+static void* dvz_pool_alloc(DvzPool* pool)
+{
+    ASSERT(pool != NULL);
+    ASSERT(pool->item_size > 0);
+    pthread_mutex_lock(&pool->lock);
+
+    // Add a chunk of objects to the free list when it is empty.
+    if (pool->free_list == NULL)
+    {
+        size_t size = pool->chunk_size * pool->item_size;
+        log_trace("grow pool of objects of size %zu", pool->item_size);
+        dvz_alloc_track(size);
+        uint8_t* chunk = (uint8_t*)malloc(size);
+        ASSERT(chunk != NULL);
+        pool->chunks = (uint8_t**)realloc(pool->chunks, (pool->chunk_count + 1) * sizeof(void*));
+        pool->chunks[pool->chunk_count++] = chunk;
+        for (uint32_t i = pool->chunk_size; i > 0; i--)
+        {
+            *(void**)(chunk + (i - 1) * pool->item_size) = pool->free_list;
+            pool->free_list = chunk + (i - 1) * pool->item_size;
+        }
+    }
+
+    void* item = pool->free_list;
+    pool->free_list = *(void**)item;
+    pool->used++;
+    pthread_mutex_unlock(&pool->lock);
+
+    memset(item, 0, pool->item_size);
+    return item;
+}
+
+/**
+ * Return an object to its pool.
+ *
+ * @param pool the pool
+ * @param item the object, or NULL
+ */
+static void dvz_pool_free(DvzPool* pool, void* item)
+{
+    ASSERT(pool != NULL);
+    if (item == NULL)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    ASSERT(pool->used > 0);
+    *(void**)item = pool->free_list;
+    pool->free_list = item;
+    pool->used--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Destroy a pool and free all of its objects.
+ *
+ * @param pool the pool
+ */
+static void dvz_pool_destroy(DvzPool* pool)
+{
+    ASSERT(pool != NULL);
+    for (uint32_t i = 0; i < pool->chunk_count; i++)
+        FREE(pool->chunks[i]);
+    FREE(pool->chunks);
+    pool->chunk_count = 0;
+    pool->free_list = NULL;
+    pool->used = 0;
+    pthread_mutex_destroy(&pool->lock);
+}
+
+
+
+/*************************************************************************************************/
+/*  Arena                                                                                        */
+/*************************************************************************************************/
+
+static void _arena_free_overflow(DvzArena* arena)
+{
+    ASSERT(arena != NULL);
+    void* next = NULL;
+    while (arena->overflow != NULL)
+    {
+        next = *(void**)arena->overflow;
+        free(arena->overflow);
+        arena->overflow = next;
+    }
+}
+
+/**
+ * Allocate scratch memory in an arena, valid until the next reset of the arena.
+ *
+ * A zero-initialized arena is valid, its main block is allocated at the first reset.
+ *
+ * @param arena the arena
+ * @param size the size, in bytes
+ * @returns a pointer to zero-initialized memory, aligned to 16 bytes
+ */
+static void* dvz_arena_alloc(DvzArena* arena, size_t size)
+{
+    ASSERT(arena != NULL);
+    size = (MAX(size, 1) + 15) / 16 * 16;
+    void* ptr = NULL;
+    if (arena->offset + size <= arena->capacity)
+    {
+        ptr = arena->data + arena->offset;
+        arena->offset += size;
+    }
+    else
+    {
+        // The main block is full: allocate an overflow block, prefixed by the link to the next
+        // overflow block (16 bytes to keep the alignment).
+        log_trace("arena overflow, allocate %zu bytes", size);
+        dvz_alloc_track(size + 16);
+        uint8_t* block = (uint8_t*)malloc(size + 16);
+        ASSERT(block != NULL);
+        *(void**)block = arena->overflow;
+        arena->overflow = block;
+        arena->overflow_size += size;
+        ptr = block + 16;
+    }
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+/**
+ * Release all of the memory allocated in an arena since the last reset.
+ *
+ * @param arena the arena
+ */
+static void dvz_arena_reset(DvzArena* arena)
+{
+    ASSERT(arena != NULL);
+    arena->offset = 0;
+    if (arena->overflow == NULL)
+        return;
+
+    // Free the overflow blocks, and enlarge the main block so that it can hold them next time.
+    _arena_free_overflow(arena);
+    arena->capacity = dvz_next_pow2(arena->capacity + arena->overflow_size);
+    arena->overflow_size = 0;
+    log_trace("enlarge arena to %zu bytes", arena->capacity);
+    dvz_alloc_track(arena->capacity);
+    FREE(arena->data);
+    arena->data = (uint8_t*)malloc(arena->capacity);
+    ASSERT(arena->data != NULL);
+}
+
+/**
+ * Free the memory of an arena.
+ *
+ * @param arena the arena
+ */
+static void dvz_arena_destroy(DvzArena* arena)
+{
+    ASSERT(arena != NULL);
+    _arena_free_overflow(arena);
+    FREE(arena->data);
+    memset(arena, 0, sizeof(DvzArena));
+}
+
+
+
 /*************************************************************************************************/
 /*  I/O                                                                                          */
 /*************************************************************************************************/
@@ -24,11 +24,15 @@ extern "C" {
 #define DVZ_DEFAULT_WIDTH  800
 #define DVZ_DEFAULT_HEIGHT 600
 
-#define DVZ_BUFFER_TYPE_STAGING_SIZE (16 * 1024 * 1024)
-#define DVZ_BUFFER_TYPE_VERTEX_SIZE  (16 * 1024 * 1024)
-#define DVZ_BUFFER_TYPE_INDEX_SIZE   (16 * 1024 * 1024)
-#define DVZ_BUFFER_TYPE_STORAGE_SIZE (16 * 1024 * 1024)
-#define DVZ_BUFFER_TYPE_UNIFORM_SIZE (4 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_STAGING_SIZE  (16 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_VERTEX_SIZE   (16 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_INDEX_SIZE    (16 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_STORAGE_SIZE  (16 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_UNIFORM_SIZE  (4 * 1024 * 1024)
+#define DVZ_BUFFER_TYPE_INDIRECT_SIZE (1024 * 1024)
+
+#define DVZ_BUFFER_ALLOCATOR_DEFAULT_CAPACITY 64
+#define DVZ_TRANSFER_POOL_SIZE                64
 
 #define DVZ_ZERO_OFFSET                                                                           \
     (uvec3) { 0, 0, 0 }
@@ -67,6 +71,12 @@ typedef enum
 
 typedef struct DvzFontAtlas DvzFontAtlas;
 typedef struct DvzColorTexture DvzColorTexture;
+typedef struct DvzBufferBlock DvzBufferBlock;
+typedef struct DvzBufferAllocator DvzBufferAllocator;
+typedef struct DvzContextConfig DvzContextConfig;
+
+// Callback called when a buffer region has been moved by the compaction of its buffer.
+typedef void (*DvzBufferRelocCallback)(DvzBufferRegions* br, void* user_data);
 
 
 
@@ -95,12 +105,45 @@ struct DvzColorTexture
 
 
 
+struct DvzBufferBlock
+{
+    VkDeviceSize offset;
+    VkDeviceSize size;
+
+    // Owner of a live allocation, patched when the allocation is moved by the compaction.
+    DvzBufferRegions* owner;
+    DvzBufferRelocCallback callback;
+    void* user_data;
+};
+
+
+
+struct DvzBufferAllocator
+{
+    // Free blocks below the allocated size of the buffer, sorted by offset and coalesced.
+    uint32_t free_count, free_capacity;
+    DvzBufferBlock* free;
+
+    // Live allocations, sorted by offset.
+    uint32_t live_count, live_capacity;
+    DvzBufferBlock* live;
+};
+
+
+
+struct DvzContextConfig
+{
+    // Initial size of the default buffers, which are created on first use.
+    VkDeviceSize buffer_sizes[DVZ_BUFFER_TYPE_COUNT];
+};
+
+
+
 struct DvzContext
 {
     DvzObject obj;
     DvzGpu* gpu;
-
-    // DvzCommands transfer_cmd;
+    DvzContextConfig config;
 
     DvzContainer buffers;
     DvzContainer images;
@@ -108,10 +151,15 @@ struct DvzContext
     DvzContainer textures;
     DvzContainer computes;
 
+    // Sub-allocators of the buffers, one per buffer type.
+    DvzBufferAllocator allocators[DVZ_BUFFER_TYPE_COUNT];
+
     // Data transfers.
     DvzFifo transfers;
+    DvzPool transfer_pool; // recycled DvzTransfer items of the transfers queue
+    DvzTransferBatch batch;
 
-    // Font atlas.
+    // Default resources, created on first use.
     DvzFontAtlas font_atlas;
     DvzColorTexture color_texture;
     DvzTexture* transfer_texture; // Default linear 1D texture
@@ -141,6 +189,53 @@ DVZ_EXPORT void dvz_gpu_default(DvzGpu* gpu, DvzWindow* window);
  */
 DVZ_EXPORT DvzContext* dvz_context(DvzGpu* gpu);
 
+/**
+ * Return the default context configuration.
+ *
+ * The default buffer sizes may be overridden with the `DVZ_STAGING_SIZE`, `DVZ_VERTEX_SIZE`,
+ * `DVZ_INDEX_SIZE`, `DVZ_STORAGE_SIZE`, `DVZ_UNIFORM_SIZE` and `DVZ_INDIRECT_SIZE` environment
+ * variables, in bytes with an optional `K`, `M` or `G` suffix.
+ *
+ * @returns the context configuration
+ */
+DVZ_EXPORT DvzContextConfig dvz_context_config_default(void);
+
+/**
+ * Set the initial sizes of the default buffers of a context.
+ *
+ * The default buffers are created on first use, so this function can be called after
+ * `dvz_context()`, but it has no effect on the buffers that have already been created. A zero
+ * size keeps the current size.
+ *
+ * @param context the context
+ * @param config the context configuration
+ */
+DVZ_EXPORT void dvz_context_config(DvzContext* context, DvzContextConfig config);
+
+/**
+ * Return the font atlas, creating it on first use.
+ *
+ * @param context the context
+ * @returns the font atlas
+ */
+DVZ_EXPORT DvzFontAtlas* dvz_context_font_atlas(DvzContext* context);
+
+/**
+ * Return the colormap texture, creating and uploading it on first use.
+ *
+ * @param context the context
+ * @returns the colormap texture
+ */
+DVZ_EXPORT DvzTexture* dvz_context_color_texture(DvzContext* context);
+
+/**
+ * Return the default linear 1D texture used for transfer functions, creating it on first use.
+ *
+ * @param context the context
+ * @returns the transfer texture
+ */
+DVZ_EXPORT DvzTexture* dvz_context_transfer_texture(DvzContext* context);
+
 /**
  * Destroy all GPU resources in a GPU context.
  *
@@ -189,6 +284,43 @@ DVZ_EXPORT DvzBufferRegions dvz_ctx_buffers(
 DVZ_EXPORT void
 dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceSize new_size);
 
+/**
+ * Free a set of buffer regions, so that the space can be reused by subsequent allocations.
+ *
+ * !!! note
+ *     The GPU must not be using the regions anymore. The buffer regions are reset.
+ *
+ * @param context the context
+ * @param br the buffer regions to free
+ */
+DVZ_EXPORT void dvz_ctx_buffers_free(DvzContext* context, DvzBufferRegions* br);
+
+/**
+ * Register the owner of a set of buffer regions, so that it can be moved by the compaction.
+ *
+ * Buffer regions without a registered owner are never moved.
+ *
+ * @param context the context
+ * @param br the buffer regions, the pointer must remain valid until the regions are freed
+ * @param callback function called after the regions have been moved (optional)
+ * @param user_data pointer passed to the callback
+ */
+DVZ_EXPORT void dvz_ctx_buffers_owner(
+    DvzContext* context, DvzBufferRegions* br, DvzBufferRelocCallback callback, void* user_data);
+
+/**
+ * Compact a buffer by moving the owned buffer regions towards the start of the buffer.
+ *
+ * The pending transfers are processed and the GPU is idle during the compaction. The moved
+ * buffer regions are patched in place, and their callbacks are called so that their users can
+ * update the descriptor bindings and command buffers that refer to the old offsets.
+ *
+ * @param context the context
+ * @param buffer_type the type of the buffer to compact
+ * @returns the number of buffer regions that were moved
+ */
+DVZ_EXPORT uint32_t dvz_ctx_buffers_compact(DvzContext* context, DvzBufferType buffer_type);
+
 
 
 /*************************************************************************************************/
@@ -28,6 +28,7 @@ extern "C" {
 /*************************************************************************************************/
 
 typedef struct DvzFifo DvzFifo;
+typedef struct DvzRing DvzRing;
 typedef struct DvzDeq DvzDeq;
 typedef struct DvzDeqItem DvzDeqItem;
 typedef struct DvzDeqCallbackRegister DvzDeqCallbackRegister;
@@ -56,6 +57,31 @@ struct DvzFifo
 
 
 
+/*************************************************************************************************/
+/*  Lock-free ring                                                                               */
+/*************************************************************************************************/
+
+// Bounded lock-free queue with multiple producers and a single consumer. The items are copied
+// by value in fixed-size slots. The mutex and condition variable are only used when the
+// consumer waits for an item.
+struct DvzRing
+{
+    uint32_t capacity; // number of slots, power of 2
+    size_t item_size;
+    uint8_t* items;
+    atomic(uint64_t, *seqs); // sequence number of every slot
+
+    atomic(uint64_t, tail); // next position to be claimed by a producer
+    uint8_t _pad[64];       // keep the producers' and the consumer's positions on separate lines
+    atomic(uint64_t, head); // next position to be read by the consumer
+
+    atomic(bool, is_waiting);
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+
+
 /*************************************************************************************************/
 /*  Dequeues struct                                                                              */
 /*************************************************************************************************/
@@ -157,6 +183,69 @@ DVZ_EXPORT void dvz_fifo_destroy(DvzFifo* fifo);
 
 
 
+/*************************************************************************************************/
+/*  Lock-free ring                                                                               */
+/*************************************************************************************************/
+
+/**
+ * Create a lock-free ring queue.
+ *
+ * @param capacity the number of slots, rounded up to a power of 2
+ * @param item_size the size of every item, in bytes
+ * @returns a ring queue
+ */
+DVZ_EXPORT DvzRing dvz_ring(uint32_t capacity, size_t item_size);
+
+/**
+ * Copy an item in a ring queue. Can be called concurrently by several threads.
+ *
+ * @param ring the ring queue
+ * @param item the pointer to the item to copy
+ * @returns false if the ring queue was full, true otherwise
+ */
+DVZ_EXPORT bool dvz_ring_enqueue(DvzRing* ring, const void* item);
+
+/**
+ * Dequeue an item from a ring queue. Must be called by a single consumer thread.
+ *
+ * @param ring the ring queue
+ * @param item the pointer to the item to fill
+ * @param wait whether to return immediately, or wait until the queue is non-empty
+ * @returns whether an item was dequeued
+ */
+DVZ_EXPORT bool dvz_ring_dequeue(DvzRing* ring, void* item, bool wait);
+
+/**
+ * Dequeue several items from a ring queue. Must be called by a single consumer thread.
+ *
+ * @param ring the ring queue
+ * @param items the pointer to an array of at least `max_count` items to fill
+ * @param max_count the maximum number of items to dequeue
+ * @param wait whether to return immediately, or wait until the queue is non-empty
+ * @returns the number of dequeued items
+ */
+DVZ_EXPORT uint32_t
+dvz_ring_dequeue_batch(DvzRing* ring, void* items, uint32_t max_count, bool wait);
+
+/**
+ * Get the number of items in a ring queue.
+ *
+ * The returned value may be outdated if other threads modify the queue.
+ *
+ * @param ring the ring queue
+ * @returns the number of items in the queue
+ */
+DVZ_EXPORT uint32_t dvz_ring_size(DvzRing* ring);
+
+/**
+ * Destroy a ring queue.
+ *
+ * @param ring the ring queue
+ */
+DVZ_EXPORT void dvz_ring_destroy(DvzRing* ring);
+
+
+
 /*************************************************************************************************/
 /*  Dequeues                                                                                     */
 /*************************************************************************************************/
@@ -66,6 +66,10 @@ layout (std140, binding = 0) uniform MVP {
     mat4 view;
     mat4 proj;
     float time;
+
+    // Data normalization, when done on the GPU.
+    vec4 data_scale;
+    vec4 data_shift;
 } mvp;
 
 struct VkViewport {
@@ -85,6 +89,9 @@ layout (std140, binding = 1) uniform Viewport {
     // Options
     int clip;               // viewport clipping
     int interact_axis;
+    int data_norm;          // whether to normalize the positions with the MVP data scale/shift
+    uint ring_base;         // streaming: position of the oldest item in the vertex ring buffer
+    uint ring_size;         // streaming: capacity of the vertex ring buffer, or 0
 } viewport;
 
 
@@ -104,6 +111,10 @@ vec4 to_vulkan(vec4 tr) {
 
 
 vec4 transform(vec3 pos, vec2 shift, uint transform_mode) {
+    // Data normalization: the positions are relative to the panel origin.
+    if (viewport.data_norm > 0)
+        pos = pos * mvp.data_scale.xyz + mvp.data_shift.xyz;
+
     mat4 mvp = mvp.proj * mvp.view * mvp.model;
     vec4 tr = vec4(pos, 1.0);
 
@@ -189,6 +200,22 @@ vec4 transform(vec3 pos) {
 
 
 
+// Chronological index of a vertex of a streamed visual, from its position in the ring buffer.
+// NOTE: the vertex at index ring_size mirrors the first vertex of the ring buffer.
+uint ring_index(uint vertex_index) {
+    return (vertex_index + viewport.ring_size - viewport.ring_base) % viewport.ring_size;
+}
+
+
+
+// Normalized x coordinate of a vertex of a streamed visual: the oldest item is on the left edge
+// and the newest on the right edge once the ring buffer is full, so that the window scrolls.
+float ring_x(uint vertex_index) {
+    return -1.0 + 2.0 * ring_index(vertex_index) / max(float(viewport.ring_size) - 1.0, 1.0);
+}
+
+
+
 bool clip_viewport(vec2 frag_coords) {
     vec2 uv = frag_coords - viewport.offset;
     return (
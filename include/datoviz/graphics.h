@@ -125,6 +125,7 @@ typedef struct DvzGraphicsTextVertex DvzGraphicsTextVertex;
 typedef struct DvzGraphicsTextItem DvzGraphicsTextItem;
 
 typedef struct DvzGraphicsData DvzGraphicsData;
+typedef struct DvzGraphicsSpec DvzGraphicsSpec;
 
 
 
@@ -153,6 +154,14 @@ struct DvzGraphicsData
 
 
 
+struct DvzGraphicsSpec
+{
+    DvzGraphicsType type;
+    int flags;
+};
+
+
+
 /*************************************************************************************************/
 /*  Graphics point                                                                               */
 /*************************************************************************************************/
@@ -448,7 +457,11 @@ DVZ_EXPORT void dvz_graphics_alloc(DvzGraphicsData* data, uint32_t item_count);
 DVZ_EXPORT void dvz_graphics_append(DvzGraphicsData* data, const void* item);
 
 /**
- * Create a new graphics pipeline of a given builtin type.
+ * Acquire a graphics pipeline of a given builtin type.
+ *
+ * The pipelines are shared: requesting the same type and flags on the same canvas returns the
+ * same pipeline, which is reference counted. Each call must be balanced by a call to
+ * `dvz_graphics_release()`.
  *
  * @param canvas the canvas holding the grahpics pipeline
  * @param type the graphics type
@@ -456,6 +469,36 @@ DVZ_EXPORT void dvz_graphics_append(DvzGraphicsData* data, const void* item);
  */
 DVZ_EXPORT DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags);
 
+/**
+ * Release a builtin graphics pipeline, destroying it when the last user goes.
+ *
+ * @param canvas the canvas holding the graphics pipeline
+ * @param graphics the graphics returned by `dvz_graphics_builtin()`
+ */
+DVZ_EXPORT void dvz_graphics_release(DvzCanvas* canvas, DvzGraphics* graphics);
+
+/**
+ * Create a set of builtin graphics pipelines concurrently, on worker threads.
+ *
+ * The pipelines are created with the shared GPU pipeline cache. Subsequent calls to
+ * `dvz_graphics_builtin()` with the same type and flags return the warmed-up pipelines, waiting
+ * for them if they are still being created in the background.
+ *
+ * @param canvas the canvas holding the graphics pipelines
+ * @param count the number of graphics types
+ * @param specs the graphics types and creation flags
+ * @param background whether to return immediately instead of waiting for all pipelines
+ */
+DVZ_EXPORT void dvz_graphics_warmup(
+    DvzCanvas* canvas, uint32_t count, DvzGraphicsSpec* specs, bool background);
+
+/**
+ * Wait until the pipelines of the current graphics warm-up have all been created.
+ *
+ * @param canvas the canvas
+ */
+DVZ_EXPORT void dvz_graphics_warmup_wait(DvzCanvas* canvas);
+
 
 
 /**
@@ -101,9 +101,18 @@ struct DvzPanel
 
     // GPU objects
     DvzBufferRegions br_mvp; // for the uniform buffer containing the MVP
+    // Last MVP uploaded to each swapchain image, to skip the upload when it has not changed.
+    DvzMVP mvp_uploaded[DVZ_MAX_SWAPCHAIN_IMAGES];
+    uint32_t mvp_valid; // bit mask of the swapchain images with a valid mvp_uploaded
 
     DvzController* controller;
     DvzCommands* cmds;
+    // Secondary command buffers recording the panel visuals, executed by the canvas primary
+    // command buffers and only recorded again when the panel has been invalidated.
+    DvzCommands cmds_panel;
+    uint32_t cmds_thread; // recording thread owning the command pool, UINT32_MAX for main thread
+    bool cmds_valid[DVZ_MAX_SWAPCHAIN_IMAGES];
+    uint64_t cmds_recorded; // number of recordings of the secondary command buffers
     int prority_max;
 };
 
@@ -298,6 +307,8 @@ DVZ_EXPORT void dvz_panel_link(DvzGrid* grid, DvzPanel* source, DvzPanel* target
 /**
  * Destroy a panel and all visuals inside it.
  *
+ * The GPU must not execute the panel command buffers anymore.
+ *
  * @param panel the panel
  */
 DVZ_EXPORT void dvz_panel_destroy(DvzPanel* panel);
@@ -19,6 +19,7 @@
 /*************************************************************************************************/
 
 #define DVZ_MAX_VISUALS_PER_CONTROLLER 64
+#define DVZ_SCENE_UPDATE_POOL_SIZE     64
 
 
 
@@ -68,6 +69,7 @@ typedef enum
     DVZ_SCENE_UPDATE_PANEL_CHANGED,
     DVZ_SCENE_UPDATE_INTERACT_CHANGED,
     DVZ_SCENE_UPDATE_COORDS_CHANGED,
+    DVZ_SCENE_UPDATE_STREAM_CHANGED,
     // DVZ_SCENE_UPDATE_CANVAS_RESIZED,
 } DvzSceneUpdateType;
 
@@ -79,6 +81,8 @@ typedef enum
 
 typedef struct DvzScene DvzScene;
 typedef struct DvzSceneUpdate DvzSceneUpdate;
+typedef struct DvzSceneRecorder DvzSceneRecorder;
+typedef struct DvzSceneWorker DvzSceneWorker;
 typedef struct DvzController DvzController;
 typedef struct DvzTransformOLD DvzTransformOLD;
 typedef struct DvzAxes2D DvzAxes2D;
@@ -145,6 +149,35 @@ struct DvzController
 
 
 
+struct DvzSceneWorker
+{
+    DvzScene* scene;
+    uint32_t idx; // the worker records the panels with index idx modulo the number of workers
+};
+
+
+
+struct DvzSceneRecorder
+{
+    uint32_t thread_count; // 0 when the panels are recorded on the main thread
+    DvzThread threads[DVZ_MAX_RECORD_THREADS];
+    DvzSceneWorker workers[DVZ_MAX_RECORD_THREADS];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond_start; // signaled when a new recording job is available
+    pthread_cond_t cond_done;  // signaled when all workers have recorded their panels
+    uint64_t job;              // incremented for every recording job, protected by the lock
+    uint32_t pending;          // number of workers still recording, protected by the lock
+    bool stop;                 // protected by the lock
+    uint32_t next_thread;      // thread assigned to the next panel without command buffers
+
+    // Current recording job, set by the main thread while the workers are waiting.
+    DvzCanvas* canvas;
+    DvzEvent ev;
+};
+
+
+
 struct DvzScene
 {
     DvzObject obj;
@@ -161,6 +194,10 @@ struct DvzScene
 
     // FIFO queue with the pending scene updates.
     DvzFifo update_fifo;
+    DvzPool update_pool; // recycled DvzSceneUpdate items of the update queue
+
+    // Worker threads recording the panel command buffers during the refills.
+    DvzSceneRecorder recorder;
 };
 
 
@@ -195,6 +232,20 @@ DVZ_EXPORT void dvz_scene_destroy(DvzScene* scene);
 
 
 
+/**
+ * Record the panel command buffers on worker threads during the canvas refills.
+ *
+ * Each worker records the secondary command buffers of a fixed subset of the panels, allocated
+ * from its own command pool. The primary command buffer then executes them in the panel order,
+ * so that the result does not depend on the number of threads.
+ *
+ * @param scene the scene
+ * @param thread_count the number of worker threads, 0 to record on the main thread (default)
+ */
+DVZ_EXPORT void dvz_scene_record_threads(DvzScene* scene, uint32_t thread_count);
+
+
+
 /*************************************************************************************************/
 /*  Controller                                                                                   */
 /*************************************************************************************************/
@@ -10,6 +10,19 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_MAX_TRANSFER_DOWNLOADS     64
+#define DVZ_TRANSFER_BATCH_COUNT       2
+#define DVZ_TRANSFER_STAGING_ALIGNMENT 16
+
+// Maximum size of a single staging copy, larger transfers are split into chunks.
+#define DVZ_TRANSFER_CHUNK_SIZE (4 * 1024 * 1024)
+
+
+
 /*************************************************************************************************/
 /*  Transfer enums                                                                               */
 /*************************************************************************************************/
@@ -33,6 +46,10 @@ typedef enum
 /*************************************************************************************************/
 
 typedef struct DvzTransfer DvzTransfer;
+typedef struct DvzTransferBatch DvzTransferBatch;
+typedef struct DvzTransferSync DvzTransferSync;
+typedef struct DvzTransferDownload DvzTransferDownload;
+typedef struct DvzStagingRing DvzStagingRing;
 typedef struct DvzTransferBuffer DvzTransferBuffer;
 typedef struct DvzTransferBufferCopy DvzTransferBufferCopy;
 typedef struct DvzTransferTexture DvzTransferTexture;
@@ -95,6 +112,74 @@ struct DvzTransfer
 {
     DvzDataTransferType type;
     DvzTransferUnion u;
+    uint64_t ticket;
+};
+
+
+
+// Pending copy from the staging buffer to the CPU, done once the batch has completed.
+struct DvzTransferDownload
+{
+    VkDeviceSize staging_offset, size;
+    void* data;
+};
+
+
+
+// Fixed-size, persistently mapped staging buffer, sub-allocated as a ring: each batch releases
+// the regions it used once it has completed.
+struct DvzStagingRing
+{
+    VkDeviceSize size; // total size of the staging buffer
+    VkDeviceSize head; // offset of the next allocation
+    VkDeviceSize tail; // offset of the oldest region still in use
+    VkDeviceSize used; // number of bytes in use, including the skipped end when wrapping
+};
+
+
+
+// Binary semaphores signaled by a submission and waited on by the next one of another kind: every
+// canvas has one for its frames (the next transfer batch waits on it), and one for the transfer
+// batches (the next frame of the canvas waits on it).
+struct DvzTransferSync
+{
+    DvzSemaphores semaphores; // two semaphores used alternately
+    uint32_t idx;
+    bool pending; // whether semaphores[idx] is signaled and not waited on yet
+};
+
+
+
+// All buffer transfers processed in a frame are recorded in a single command buffer, submitted
+// once to the transfer queue with a fence. The batch waits on the last frame of every canvas,
+// and signals a semaphore that the next frame of every canvas waits on. A new batch may be
+// recorded while the previous ones are still in flight.
+struct DvzTransferBatch
+{
+    DvzCommands cmds; // one command buffer per batch slot
+    DvzFences fences; // one fence per batch slot
+    bool sync;        // whether to wait for the transfers on the CPU, even in the event loop
+
+    DvzStagingRing ring;
+    uint32_t cur; // slot of the batch being recorded
+    bool is_recording;
+    uint32_t transfer_count;
+
+    // Batch slots.
+    bool in_flight[DVZ_TRANSFER_BATCH_COUNT];
+    VkDeviceSize ring_end[DVZ_TRANSFER_BATCH_COUNT];  // ring head after the last allocation
+    VkDeviceSize ring_used[DVZ_TRANSFER_BATCH_COUNT]; // number of ring bytes to release
+    uint32_t download_count[DVZ_TRANSFER_BATCH_COUNT];
+    DvzTransferDownload downloads[DVZ_TRANSFER_BATCH_COUNT][DVZ_MAX_TRANSFER_DOWNLOADS];
+
+    // Every transfer gets a ticket, tickets are processed in increasing order. The lock protects
+    // the tickets, the staging ring and the in-flight state of the batch slots, which may be
+    // accessed from another thread with dvz_transfer_done().
+    pthread_mutex_t lock;
+    uint64_t ticket;                                  // last ticket given away
+    uint64_t ticket_batch;                            // last ticket of the batch being recorded
+    uint64_t ticket_flight[DVZ_TRANSFER_BATCH_COUNT]; // last ticket of each batch slot
+    atomic(uint64_t, done);                           // last completed ticket
 };
 
 
@@ -111,8 +196,9 @@ struct DvzTransfer
  * @param offset the offset within the buffer regions, in bytes
  * @param size the size of the data to upload, in bytes
  * @param data pointer to the data to upload to the GPU
+ * @returns the transfer ticket
  */
-DVZ_EXPORT void dvz_upload_buffer(
+DVZ_EXPORT uint64_t dvz_upload_buffer(
     DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data);
 
 /**
@@ -123,8 +209,9 @@ DVZ_EXPORT void dvz_upload_buffer(
  * @param offset the offset within the buffer regions, in bytes
  * @param size the size of the data to upload, in bytes
  * @param[out] data pointer to a buffer already allocated to contain `size` bytes
+ * @returns the transfer ticket, the data is only available once the ticket is done
  */
-DVZ_EXPORT void dvz_download_buffer(
+DVZ_EXPORT uint64_t dvz_download_buffer(
     DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data);
 
 /**
@@ -138,8 +225,9 @@ DVZ_EXPORT void dvz_download_buffer(
  * @param dst the buffer region to copy to
  * @param dst_offset the offset within the target buffer region
  * @param size the size of the data to copy
+ * @returns the transfer ticket
  */
-DVZ_EXPORT void dvz_copy_buffer(
+DVZ_EXPORT uint64_t dvz_copy_buffer(
     DvzContext* context, DvzBufferRegions src, VkDeviceSize src_offset, //
     DvzBufferRegions dst, VkDeviceSize dst_offset, VkDeviceSize size);
 
@@ -152,8 +240,9 @@ DVZ_EXPORT void dvz_copy_buffer(
  * @param shape the shape of the region to update within the texture
  * @param size the size of the uploaded data, in bytes
  * @param data pointer to the data to upload to the GPU
+ * @returns the transfer ticket
  */
-DVZ_EXPORT void dvz_upload_texture(
+DVZ_EXPORT uint64_t dvz_upload_texture(
     DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size,
     void* data);
 
@@ -166,8 +255,9 @@ DVZ_EXPORT void dvz_upload_texture(
  * @param shape the shape of the region to update within the texture
  * @param size the size of the downloaded data, in bytes
  * @param[out] data pointer to the buffer that will hold the downloaded data
+ * @returns the transfer ticket
  */
-DVZ_EXPORT void dvz_download_texture(
+DVZ_EXPORT uint64_t dvz_download_texture(
     DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size,
     void* data);
 
@@ -183,8 +273,9 @@ DVZ_EXPORT void dvz_download_texture(
  * @param dst_offset the offset within the target texture
  * @param shape the shape of the part of the texture to copy
  * @param size the corresponding size of that part, in bytes
+ * @returns the transfer ticket
  */
-DVZ_EXPORT void dvz_copy_texture(
+DVZ_EXPORT uint64_t dvz_copy_texture(
     DvzContext* context, DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset,
     uvec3 shape, VkDeviceSize size);
 
@@ -204,6 +295,77 @@ DVZ_EXPORT void dvz_copy_texture(
  */
 DVZ_EXPORT void dvz_process_transfers(DvzContext* context);
 
+/**
+ * Wait for the transfers on the CPU after each transfer processing, even in the event loop.
+ *
+ * By default, the buffer transfers processed in the event loop are submitted to the transfer
+ * queue without any CPU wait, and the next frame waits for them on the GPU.
+ *
+ * @param context the context
+ * @param sync whether the transfers should be synchronous
+ */
+DVZ_EXPORT void dvz_transfers_sync(DvzContext* context, bool sync);
+
+/**
+ * Return whether a transfer has completed.
+ *
+ * @param context the context
+ * @param ticket the ticket returned by the transfer function
+ * @returns whether the transfer has completed
+ */
+DVZ_EXPORT bool dvz_transfer_done(DvzContext* context, uint64_t ticket);
+
+/**
+ * Process the pending transfers if needed, and wait until a transfer has completed.
+ *
+ * This function must be called from the thread running the event loop.
+ *
+ * @param context the context
+ * @param ticket the ticket returned by the transfer function
+ */
+DVZ_EXPORT void dvz_transfer_wait(DvzContext* context, uint64_t ticket);
+
+
+
+
+/*************************************************************************************************/
+/*  Transfer synchronization                                                                     */
+/*************************************************************************************************/
+
+/**
+ * Create the semaphores ordering a kind of submissions before the next submission of another kind.
+ *
+ * @param gpu the GPU
+ * @returns the synchronization object
+ */
+DVZ_EXPORT DvzTransferSync dvz_transfer_sync(DvzGpu* gpu);
+
+/**
+ * Make a submission wait on the semaphore signaled last, if it has not been waited on yet.
+ *
+ * @param sync the synchronization object
+ * @param submit the submission
+ * @param stage the pipeline stage that waits on the semaphore
+ */
+DVZ_EXPORT void
+dvz_transfer_sync_wait(DvzTransferSync* sync, DvzSubmit* submit, VkPipelineStageFlags stage);
+
+/**
+ * Make a submission signal a semaphore.
+ *
+ * If the previous semaphore has not been waited on, the submission consumes it first.
+ *
+ * @param sync the synchronization object
+ * @param submit the submission
+ */
+DVZ_EXPORT void dvz_transfer_sync_signal(DvzTransferSync* sync, DvzSubmit* submit);
+
+/**
+ * Destroy the semaphores of a synchronization object.
+ *
+ * @param sync the synchronization object
+ */
+DVZ_EXPORT void dvz_transfer_sync_destroy(DvzTransferSync* sync);
 
 
 #endif
@@ -27,6 +27,10 @@
 
 #define DVZ_TRANSFORM_CHAIN_MAX_SIZE 32
 
+// Position transformations on arrays larger than this are split across worker threads.
+#define DVZ_TRANSFORM_PARALLEL_THRESHOLD 65536
+#define DVZ_TRANSFORM_MAX_THREADS        16
+
 #define DVZ_TRANSFORM_MATRIX_VULKAN                                                               \
     (dmat4)                                                                                       \
     {                                                                                             \
@@ -60,6 +64,7 @@ typedef enum
     DVZ_TRANSFORM_FLAGS_LOGY = 0x0002,
     DVZ_TRANSFORM_FLAGS_LOGLOG = 0x0003,
     DVZ_TRANSFORM_FLAGS_FIXED_ASPECT = 0x0008,
+    DVZ_TRANSFORM_FLAGS_GPU = 0x0010, // box to NDC normalization in the vertex shader
 } DvzTransformFlags;
 
 
@@ -120,6 +125,10 @@ struct DvzDataCoords
     DvzTransformType transform;
     int flags; // come from the panel
     // TODO: union with transform parameters?
+
+    // With DVZ_TRANSFORM_FLAGS_GPU, positions are uploaded relative to this origin, and the box
+    // to NDC normalization is done in the vertex shader.
+    dvec3 origin;
 };
 
 
@@ -196,9 +205,16 @@ MAKE_TRANSPOSE(vec3)
 /**
  * Apply a CPU builtin transformation on position data.
  *
+ * The input and output arrays may have any of the FLOAT, VEC2, VEC3, DOUBLE, DVEC2, DVEC3 dtypes,
+ * possibly different (for example DVEC3 positions written directly as VEC3). Missing input
+ * components are set to 0. Large arrays are processed in parallel on worker threads.
+ *
+ * With the DVZ_TRANSFORM_FLAGS_GPU flag, only the translation by the data coords origin is done
+ * here, and the box to NDC normalization is left to the vertex shader.
+ *
  * @param coords the data coordinate system and bounds
- * @param pos_in input array of dvec3 values
- * @param[out] pos_out output array of dvec3 values
+ * @param pos_in input array of positions
+ * @param[out] pos_out output array of positions, with the same number of items
  * @param inverse whether to use the inverse or forward transformation
  */
 DVZ_EXPORT void
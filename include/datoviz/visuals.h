@@ -21,6 +21,7 @@
 #define DVZ_MAX_VISUAL_GROUPS       1024
 #define DVZ_MAX_VISUAL_PRIORITY     4
 #define DVZ_MAX_UNIFORM_SIZE        65536
+#define DVZ_MAX_DIRTY_RANGES        16
 
 
 /*************************************************************************************************/
@@ -170,6 +171,7 @@ typedef enum
 
 typedef struct DvzVisual DvzVisual;
 typedef struct DvzProp DvzProp;
+typedef struct DvzDirtyRanges DvzDirtyRanges;
 
 typedef union DvzSourceUnion DvzSourceUnion;
 typedef struct DvzSource DvzSource;
@@ -177,6 +179,8 @@ typedef struct DvzSource DvzSource;
 typedef struct DvzVisualFillEvent DvzVisualFillEvent;
 typedef struct DvzVisualDataEvent DvzVisualDataEvent;
 
+typedef union DvzDrawArgs DvzDrawArgs;
+
 typedef uint32_t DvzIndex;
 
 
@@ -208,6 +212,18 @@ enqueue data transfers
 /*  Source structs                                                                               */
 /*************************************************************************************************/
 
+// Items of an array modified since the last upload, as sorted and coalesced [first, last) ranges.
+struct DvzDirtyRanges
+{
+    bool all; // the whole array has been modified
+    uint32_t count;
+    uint32_t first[DVZ_MAX_DIRTY_RANGES];
+    uint32_t last[DVZ_MAX_DIRTY_RANGES];
+};
+
+
+
+
 union DvzSourceUnion
 {
     DvzBufferRegions br;
@@ -239,6 +255,7 @@ struct DvzSource
 
     DvzSourceOrigin origin; // whether the underlying GPU object is handled by the user or datoviz
     DvzSourceUnion u;
+    DvzDirtyRanges dirty; // items of the source array to upload
 };
 
 
@@ -267,6 +284,18 @@ struct DvzProp
     DvzDataType target_dtype; // used for casting during the copy to the vertex array
     DvzArrayCopyType copy_type;
     uint32_t reps; // number of repeats when copying
+
+    DvzDirtyRanges dirty; // items of the prop array to copy to the source array
+    uint32_t stream_head; // streamed visual: index of the next item to write in the prop array
+};
+
+
+
+// Indirect draw arguments of a draw command, indexed or not.
+union DvzDrawArgs
+{
+    VkDrawIndirectCommand draw;
+    VkDrawIndexedIndirectCommand draw_indexed;
 };
 
 
@@ -319,9 +348,26 @@ struct DvzVisual
     DvzViewportClip clip[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewport viewport; // usually the visual's panel viewport, but may be customized
 
+    // Streaming mode: the VERTEX sources are fixed-capacity ring buffers.
+    uint32_t stream_capacity; // 0 if the visual is not streamed
+    uint32_t stream_head;     // index of the next item to write in the ring buffers
+    uint32_t prev_stream_head;
+
     // GPU data
     DvzContainer bindings;
     DvzContainer bindings_comp;
+
+    // Scratch memory for the bake callback, reset before every bake.
+    DvzArena arena;
+
+    // Indirect draw arguments, read by the recorded draw commands, so that a change in the number
+    // of items or in the visibility does not require the command buffers to be recorded again.
+    // There are two draws per graphics pipeline, the second one is only used by streamed visuals.
+    DvzBufferRegions br_draw; // one region per swapchain image, empty if direct draws are used
+    DvzDrawArgs draw_args[2 * DVZ_MAX_GRAPHICS_PER_VISUAL];
+    uint32_t draw_args_valid; // bit mask of the swapchain images with up-to-date draw arguments
+    bool draw_layout_changed; // the bound vertex or index buffers have changed
+    bool hidden;
 };
 
 
@@ -546,6 +592,29 @@ DVZ_EXPORT void dvz_visual_data_partial(
 DVZ_EXPORT void dvz_visual_data_append(
     DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data);
 
+/**
+ * Switch a visual to streaming mode.
+ *
+ * The VERTEX sources of a streamed visual are fixed-capacity ring buffers: appending elements to
+ * a prop with `dvz_visual_data_append()` overwrites the oldest elements once the capacity is
+ * reached, and only the new elements are uploaded to the GPU. The memory usage is constant.
+ *
+ * The items are drawn from the oldest to the newest. With the basic graphics (points, lines, line
+ * strips...) and paths, the x coordinate of every item is replaced in the vertex shader by its
+ * position in the window of the last `capacity` items, which scrolls as new items are appended.
+ *
+ * Only visuals where every VERTEX prop item corresponds to one vertex or one path point are
+ * supported: points, markers, paths, the basic graphics, and custom graphics. A streamed path is
+ * a single open path, its lengths and topology are ignored. The segment, text, image, mesh and
+ * volume visuals cannot be streamed, as their vertices are built from several items; the visual
+ * is then left unchanged and an error is logged. Custom shaders may use `ring_x()` from
+ * common.glsl to scroll the x coordinate.
+ *
+ * @param visual the visual
+ * @param capacity the maximum number of items kept by the visual
+ */
+DVZ_EXPORT void dvz_visual_stream(DvzVisual* visual, uint32_t capacity);
+
 /**
  * Set partial data for a given source.
  *
@@ -600,6 +669,16 @@ DVZ_EXPORT void dvz_visual_flags(DvzVisual* visual, int flags);
 
 DVZ_EXPORT uint32_t dvz_visual_item_count(DvzVisual* visual);
 
+/**
+ * Show or hide a visual.
+ *
+ * With the visuals of a scene, this does not require the command buffers to be recorded again.
+ *
+ * @param visual the visual
+ * @param is_visible whether the visual should be visible
+ */
+DVZ_EXPORT void dvz_visual_visible(DvzVisual* visual, bool is_visible);
+
 
 
 /*************************************************************************************************/
@@ -47,6 +47,7 @@ extern "C" {
 #define DVZ_MAX_QUEUE_FAMILIES   16
 #define DVZ_MAX_QUEUES           16
 #define DVZ_MAX_SWAPCHAIN_IMAGES 8
+#define DVZ_MAX_RECORD_THREADS   8 // number of threads recording secondary command buffers
 
 // Maximum number of command buffers per DvzCommands struct
 #define DVZ_MAX_COMMAND_BUFFERS_PER_SET     DVZ_MAX_SWAPCHAIN_IMAGES
@@ -64,6 +65,11 @@ extern "C" {
 #define DVZ_MAX_VERTEX_BINDINGS             16
 #define DVZ_MAX_VERTEX_ATTRS                32
 
+// Device memory sub-allocation
+#define DVZ_MEMORY_BLOCK_SIZE      (64 * 1024 * 1024) // default size of the device memory blocks
+#define DVZ_MEMORY_BLOCK_MIN_SIZE  (1024 * 1024)      // minimum block size, for small heaps
+#define DVZ_MEMORY_DEDICATED_RATIO 2                  // above block size / ratio: dedicated
+
 
 
 /*************************************************************************************************/
@@ -71,6 +77,11 @@ extern "C" {
 /*************************************************************************************************/
 
 typedef struct DvzQueues DvzQueues;
+typedef struct DvzMemoryRange DvzMemoryRange;
+typedef struct DvzMemoryBlock DvzMemoryBlock;
+typedef struct DvzMemoryStats DvzMemoryStats;
+typedef struct DvzAllocation DvzAllocation;
+typedef struct DvzAllocator DvzAllocator;
 typedef struct DvzGpu DvzGpu;
 typedef struct DvzWindow DvzWindow;
 typedef struct DvzSwapchain DvzSwapchain;
@@ -136,6 +147,16 @@ typedef enum
 
 
 
+// Device memory allocation strategy.
+typedef enum
+{
+    DVZ_MEMORY_STRATEGY_FREE_LIST, // general-purpose sub-allocation with a free list per block
+    DVZ_MEMORY_STRATEGY_LINEAR,    // bump allocation, blocks are recycled once empty
+    DVZ_MEMORY_STRATEGY_DEDICATED, // one device allocation per resource
+} DvzMemoryStrategy;
+
+
+
 // Buffer type.
 typedef enum
 {
@@ -146,6 +167,7 @@ typedef enum
     DVZ_BUFFER_TYPE_UNIFORM,
     DVZ_BUFFER_TYPE_STORAGE,
     DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE,
+    DVZ_BUFFER_TYPE_INDIRECT,
     DVZ_BUFFER_TYPE_COUNT,
 } DvzBufferType;
 
@@ -324,6 +346,68 @@ struct DvzQueues
     uint32_t queue_indices[DVZ_MAX_QUEUES];  // for each requested queue, its # within its family
     VkQueue queues[DVZ_MAX_QUEUES];
     VkCommandPool cmd_pools[DVZ_MAX_QUEUE_FAMILIES];
+    // Command pools used by the recording threads, created lazily, as a command pool must not be
+    // used by several threads at once.
+    VkCommandPool thread_cmd_pools[DVZ_MAX_RECORD_THREADS][DVZ_MAX_QUEUE_FAMILIES];
+};
+
+
+
+struct DvzMemoryRange
+{
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+
+
+struct DvzMemoryBlock
+{
+    VkDeviceMemory memory;
+    uint32_t memory_type;
+    DvzMemoryStrategy strategy;
+    bool optimal; // whether the block holds optimal-tiling images (bufferImageGranularity)
+
+    VkDeviceSize size;
+    VkDeviceSize used;
+    uint32_t allocation_count;
+
+    VkDeviceSize head; // linear strategy: end of the last allocation
+
+    uint32_t free_count; // free-list strategy: sorted and coalesced free ranges
+    uint32_t free_capacity;
+    DvzMemoryRange* free_ranges;
+
+    void* mmap; // persistent mapping of the whole block, for host-visible memory
+    DvzMemoryBlock* next;
+};
+
+
+
+struct DvzAllocation
+{
+    DvzMemoryBlock* block; // NULL if not allocated
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+
+
+struct DvzMemoryStats
+{
+    VkDeviceSize used;     // bytes used by the resources
+    VkDeviceSize reserved; // bytes allocated from the device
+    uint32_t block_count;
+    uint32_t allocation_count;
+};
+
+
+
+struct DvzAllocator
+{
+    pthread_mutex_t lock;
+    VkDeviceSize block_sizes[VK_MAX_MEMORY_TYPES];
+    DvzMemoryBlock* blocks[VK_MAX_MEMORY_TYPES]; // linked list of blocks per memory type
 };
 
 
@@ -348,6 +432,12 @@ struct DvzGpu
     DvzQueues queues;
     VkDescriptorPool dset_pool;
 
+    VkPipelineCache pipeline_cache;
+    char pipeline_cache_path[DVZ_PATH_MAX_LEN]; // empty: no on-disk persistence
+    size_t pipeline_cache_loaded;               // size of the valid cache data loaded from disk
+
+    DvzAllocator allocator;
+
     VkPhysicalDeviceFeatures requested_features;
     VkDevice device;
 
@@ -401,6 +491,8 @@ struct DvzCommands
 
     uint32_t queue_idx;
     uint32_t count;
+    bool secondary; // secondary command buffers, executed by primary ones within a render pass
+    VkCommandPool pool; // the command pool the command buffers were allocated from
     VkCommandBuffer cmds[DVZ_MAX_COMMAND_BUFFERS_PER_SET];
 };
 
@@ -413,7 +505,8 @@ struct DvzBuffer
 
     DvzBufferType type;
     VkBuffer buffer;
-    VkDeviceMemory device_memory;
+    DvzAllocation allocation;
+    DvzMemoryStrategy strategy;
 
     // Queues that need access to the buffer.
     uint32_t queue_count;
@@ -464,8 +557,10 @@ struct DvzImages
     VkImageAspectFlags aspect;
     VkDeviceSize size;
 
+    DvzMemoryStrategy strategy;
+
     VkImage images[DVZ_MAX_IMAGES_PER_SET];
-    VkDeviceMemory memories[DVZ_MAX_IMAGES_PER_SET];
+    DvzAllocation allocations[DVZ_MAX_IMAGES_PER_SET];
     VkImageView image_views[DVZ_MAX_IMAGES_PER_SET];
 };
 
@@ -872,6 +967,19 @@ DVZ_EXPORT void dvz_gpu_request_features(DvzGpu* gpu, VkPhysicalDeviceFeatures r
  */
 DVZ_EXPORT void dvz_gpu_queue(DvzGpu* gpu, uint32_t idx, DvzQueueType type);
 
+/**
+ * Set the file used to persist the GPU pipeline cache across runs.
+ *
+ * By default, the pipeline cache is loaded from and saved to a file in the user cache directory
+ * (or in the directory specified by the `DVZ_CACHE_DIR` environment variable), keyed by vendor,
+ * device, driver version and pipeline cache UUID. This function needs to be called before
+ * creating the GPU with `dvz_gpu_create()`.
+ *
+ * @param gpu the GPU
+ * @param path the path to the cache file, or NULL to disable the on-disk pipeline cache
+ */
+DVZ_EXPORT void dvz_gpu_pipeline_cache(DvzGpu* gpu, const char* path);
+
 /**
  * Create a GPU once the features and queues have been set up.
  *
@@ -880,6 +988,18 @@ DVZ_EXPORT void dvz_gpu_queue(DvzGpu* gpu, uint32_t idx, DvzQueueType type);
  */
 DVZ_EXPORT void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface);
 
+/**
+ * Return statistics about the device memory allocated on a given heap.
+ *
+ * Buffers and images are sub-allocated from large device memory blocks. These statistics compare
+ * the memory used by the resources to the memory actually reserved from the driver.
+ *
+ * @param gpu the GPU
+ * @param heap the memory heap index
+ * @returns the memory statistics
+ */
+DVZ_EXPORT DvzMemoryStats dvz_gpu_memory_stats(DvzGpu* gpu, uint32_t heap);
+
 /**
  * Wait for a queue to be idle.
  *
@@ -1100,6 +1220,35 @@ DVZ_EXPORT void dvz_swapchain_destroy(DvzSwapchain* swapchain);
  */
 DVZ_EXPORT DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count);
 
+/**
+ * Create a set of secondary command buffers, to be executed within a render pass.
+ *
+ * The secondary command buffers can be recorded once and executed by primary command buffers
+ * refilled several times.
+ *
+ * @param gpu the GPU
+ * @param queue the queue index within the GPU
+ * @param count the number of command buffers to create
+ * @returns the set of command buffers
+ */
+DVZ_EXPORT DvzCommands dvz_commands_secondary(DvzGpu* gpu, uint32_t queue, uint32_t count);
+
+/**
+ * Create a set of secondary command buffers to be recorded by a given thread.
+ *
+ * The command buffers are allocated from a command pool dedicated to the recording thread, so
+ * that several threads may record their own command buffers at the same time. A given thread
+ * index must only be used by one thread at a time.
+ *
+ * @param gpu the GPU
+ * @param queue the queue index within the GPU
+ * @param count the number of command buffers to create
+ * @param thread_idx the index of the recording thread, lower than DVZ_MAX_RECORD_THREADS
+ * @returns the set of command buffers
+ */
+DVZ_EXPORT DvzCommands
+dvz_commands_thread(DvzGpu* gpu, uint32_t queue, uint32_t count, uint32_t thread_idx);
+
 /**
  * Start recording a command buffer.
  *
@@ -1108,6 +1257,16 @@ DVZ_EXPORT DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
  */
 DVZ_EXPORT void dvz_cmd_begin(DvzCommands* cmds, uint32_t idx);
 
+/**
+ * Start recording a secondary command buffer, continuing a render pass.
+ *
+ * @param cmds the set of secondary command buffers
+ * @param idx the index of the command buffer to begin recording on
+ * @param renderpass the render pass the commands will be executed in
+ */
+DVZ_EXPORT void
+dvz_cmd_begin_secondary(DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass);
+
 /**
  * Stop recording a command buffer.
  *
@@ -1194,6 +1353,17 @@ DVZ_EXPORT void dvz_buffer_usage(DvzBuffer* buffer, VkBufferUsageFlags usage);
  */
 DVZ_EXPORT void dvz_buffer_memory(DvzBuffer* buffer, VkMemoryPropertyFlags memory);
 
+/**
+ * Set the strategy used to allocate the buffer device memory.
+ *
+ * The default strategy sub-allocates the buffer from a shared block with a free list. Transient
+ * buffers may use the linear strategy, and large buffers always get a dedicated allocation.
+ *
+ * @param buffer the buffer
+ * @param strategy the memory allocation strategy
+ */
+DVZ_EXPORT void dvz_buffer_memory_strategy(DvzBuffer* buffer, DvzMemoryStrategy strategy);
+
 /**
  * Set the buffer queue access.
  *
@@ -1399,6 +1569,14 @@ DVZ_EXPORT void dvz_images_usage(DvzImages* images, VkImageUsageFlags usage);
  */
 DVZ_EXPORT void dvz_images_memory(DvzImages* images, VkMemoryPropertyFlags memory);
 
+/**
+ * Set the strategy used to allocate the images device memory.
+ *
+ * @param images the images
+ * @param strategy the memory allocation strategy
+ */
+DVZ_EXPORT void dvz_images_memory_strategy(DvzImages* images, DvzMemoryStrategy strategy);
+
 /**
  * Set the images aspect.
  *
@@ -2277,6 +2455,26 @@ DVZ_EXPORT void dvz_cmd_begin_renderpass(
  */
 DVZ_EXPORT void dvz_cmd_end_renderpass(DvzCommands* cmds, uint32_t idx);
 
+/**
+ * Begin a render pass whose commands are recorded in secondary command buffers.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param renderpass the render pass
+ * @param framebuffers the framebuffers
+ */
+DVZ_EXPORT void dvz_cmd_begin_renderpass_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers);
+
+/**
+ * Execute a secondary command buffer within a render pass.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record, and of the secondary command buffer
+ * @param secondary the set of secondary command buffers
+ */
+DVZ_EXPORT void dvz_cmd_execute(DvzCommands* cmds, uint32_t idx, DvzCommands* secondary);
+
 /**
  * Launch a compute task.
  *
@@ -2307,6 +2505,21 @@ DVZ_EXPORT void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* bar
 DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
     DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images);
 
+/**
+ * Copy part of a GPU buffer to a region of a GPU image.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param buffer the buffer
+ * @param buf_offset the offset within the buffer, in bytes
+ * @param images the image
+ * @param img_offset the offset of the region within the image
+ * @param shape the shape of the region
+ */
+DVZ_EXPORT void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, VkDeviceSize buf_offset, //
+    DvzImages* images, uvec3 img_offset, uvec3 shape);
+
 /**
  * Copy a GPU image to a GPU buffer.
  *
@@ -2318,6 +2531,21 @@ DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
 DVZ_EXPORT void dvz_cmd_copy_image_to_buffer(
     DvzCommands* cmds, uint32_t idx, DvzImages* images, DvzBuffer* buffer);
 
+/**
+ * Copy a region of a GPU image to part of a GPU buffer.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param images the image
+ * @param img_offset the offset of the region within the image
+ * @param shape the shape of the region
+ * @param buffer the buffer
+ * @param buf_offset the offset within the buffer, in bytes
+ */
+DVZ_EXPORT void dvz_cmd_copy_image_to_buffer_region(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, uvec3 img_offset, uvec3 shape, //
+    DvzBuffer* buffer, VkDeviceSize buf_offset);
+
 /**
  * Copy a GPU image to another.
  *
@@ -2,6 +2,7 @@
 #include "../external/video.h"
 #include "../include/datoviz/context.h"
 #include "../include/datoviz/controls.h"
+#include "../include/datoviz/graphics.h"
 #include "../include/datoviz/gui.h"
 #include "../include/datoviz/vklite.h"
 #include "../src/canvas_utils.h"
@@ -196,6 +197,30 @@ static void _backend_next_frame(DvzCanvas* canvas)
     }
 }
 
+// Whether the mouse has moved or the window has been resized since the last frame. Used in
+// on-demand mode, as the mouse position is otherwise only polled when rendering a frame.
+static bool _backend_window_changed(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->app != NULL);
+    if (canvas->window == NULL || canvas->app->backend != DVZ_BACKEND_GLFW)
+        return false;
+    GLFWwindow* w = canvas->window->backend_window;
+    ASSERT(w != NULL);
+
+    double xpos, ypos;
+    glfwGetCursorPos(w, &xpos, &ypos);
+    if (canvas->mouse.is_active &&
+        (canvas->mouse.cur_pos[0] != (float)xpos || canvas->mouse.cur_pos[1] != (float)ypos))
+        return true;
+
+    int width, height;
+    glfwGetFramebufferSize(w, &width, &height);
+    ASSERT(canvas->swapchain.images != NULL);
+    return (uint32_t)width != canvas->swapchain.images->width ||
+           (uint32_t)height != canvas->swapchain.images->height;
+}
+
 static void backend_event_callbacks(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
@@ -373,6 +398,7 @@ static void _refill_canvas(DvzCanvas* canvas, uint32_t img_idx)
     DvzEvent ev = {0};
     ev.type = DVZ_EVENT_REFILL;
     ev.u.rf.img_idx = img_idx;
+    ev.u.rf.full = canvas->refills.full;
 
     // First commands passed is the default cmds_render DvzCommands instance used for rendering.
     uint32_t k = 0;
@@ -435,7 +461,11 @@ static void _refill_frame(DvzCanvas* canvas)
         // If refill has just been requested, reset the ongoing refill by setting completed to
         // false for all swapchain images.
         if (atomic_load(&canvas->refills.status) == DVZ_REFILL_REQUESTED)
+        {
             memset(canvas->refills.completed, 0, DVZ_MAX_SWAPCHAIN_IMAGES);
+            // A full refill requested in the middle of a partial one extends to all images.
+            canvas->refills.full |= atomic_exchange(&canvas->refills.full_requested, false);
+        }
 
         // Skip this step if the current swapchain image has already been processed.
         if (canvas->refills.completed[img_idx])
@@ -464,6 +494,7 @@ static void _refill_frame(DvzCanvas* canvas)
             atomic_store(&canvas->refills.status, status);
             // Reset the img_updated bool array.
             memset(canvas->refills.completed, 0, DVZ_MAX_SWAPCHAIN_IMAGES);
+            canvas->refills.full = false;
         }
     }
 }
@@ -511,6 +542,26 @@ static void _fps_callback(DvzCanvas* canvas, DvzEvent ev)
 
 
 
+// Delay until the next TIMER callback, in seconds, capped by the on-demand event wait timeout.
+static double _timer_delay(DvzCanvas* canvas, double time)
+{
+    ASSERT(canvas != NULL);
+    double delay = DVZ_ON_DEMAND_TIMEOUT;
+    DvzEventCallbackRegister* r = NULL;
+    for (uint32_t i = 0; i < canvas->callbacks_count; i++)
+    {
+        r = &canvas->callbacks[i];
+        // NOTE: the FPS is only meaningful when frames are rendered, it does not wake up an
+        // idle canvas.
+        if (r->type != DVZ_EVENT_TIMER || r->param <= 0 || r->callback == _fps_callback)
+            continue;
+        delay = MIN(delay, (r->idx + 1) * r->param - time);
+    }
+    return delay;
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas creation                                                                              */
 /*************************************************************************************************/
@@ -586,6 +637,7 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
     // to the main thread (REFILL or CLOSE events).
     atomic_init(&canvas->to_close, false);
     atomic_init(&canvas->refills.status, DVZ_REFILL_NONE);
+    atomic_init(&canvas->refills.full_requested, false);
 
     // Allocate memory for canvas objects.
     canvas->commands =
@@ -725,6 +777,9 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
         canvas->fences_render_finished = dvz_fences(gpu, frames_in_flight, true);
         canvas->fences_flight.gpu = gpu;
         canvas->fences_flight.count = canvas->swapchain.img_count;
+
+        canvas->sync_frame = dvz_transfer_sync(gpu);
+        canvas->sync_transfer = dvz_transfer_sync(gpu);
     }
 
     // Default transfer commands.
@@ -744,6 +799,10 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
     // Event system.
     {
         canvas->event_queue = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+        canvas->event_pool = dvz_pool(sizeof(DvzEvent), DVZ_EVENT_POOL_SIZE);
+        canvas->event_coalesce[DVZ_EVENT_MOUSE_MOVE] = DVZ_EVENT_COALESCE_LATEST;
+        canvas->event_coalesce[DVZ_EVENT_RESIZE] = DVZ_EVENT_COALESCE_LATEST;
+        canvas->event_coalesce[DVZ_EVENT_MOUSE_WHEEL] = DVZ_EVENT_COALESCE_ACCUMULATE;
         canvas->event_thread = dvz_thread(_event_thread, canvas);
 
         canvas->mouse = dvz_mouse();
@@ -785,6 +844,10 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
                 canvas, DVZ_EVENT_IMGUI, 0, DVZ_EVENT_MODE_SYNC, dvz_gui_callback_fps, NULL);
     }
 
+    // On-demand rendering.
+    if ((flags & DVZ_CANVAS_FLAGS_ON_DEMAND) != 0)
+        dvz_canvas_on_demand(canvas, true);
+
     ASSERT(canvas->swapchain.images != NULL);
     log_debug(
         "created canvas of size %dx%d", //
@@ -911,9 +974,11 @@ void dvz_canvas_reset(DvzCanvas* canvas)
     _clock_init(&canvas->clock);
     atomic_store(&canvas->to_close, false);
     atomic_store(&canvas->refills.status, DVZ_REFILL_NONE);
+    atomic_store(&canvas->refills.full_requested, false);
+    canvas->refills.full = false;
     canvas->callbacks_count = 0;
     canvas->cur_frame = 0;
-    dvz_fifo_reset(&canvas->event_queue);
+    _event_discard(canvas, 0);
     canvas->frame_idx = 0;
     canvas->last_frame_idx = 0;
 }
@@ -956,7 +1021,8 @@ void dvz_canvas_buffers(
     ASSERT(data != NULL);
     ASSERT(br.buffer != NULL);
     ASSERT(br.count == canvas->swapchain.img_count);
-    if (br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE)
+    if (br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE &&
+        br.buffer->type != DVZ_BUFFER_TYPE_INDIRECT)
     {
         log_error("dvz_canvas_buffers() can only be used on mappable buffers.");
         return;
@@ -1041,6 +1107,17 @@ void dvz_canvas_dpi_scaling(DvzCanvas* canvas, float scaling)
 
 
 
+void dvz_canvas_on_demand(DvzCanvas* canvas, bool enable)
+{
+    ASSERT(canvas != NULL);
+    log_debug("%s on-demand rendering", enable ? "enable" : "disable");
+    canvas->on_demand = enable;
+    canvas->idle = false;
+    dvz_canvas_dirty(canvas);
+}
+
+
+
 DvzViewport dvz_viewport_default(uint32_t width, uint32_t height)
 {
     DvzViewport viewport = {0};
@@ -1151,10 +1228,20 @@ void dvz_event_callback(
 /*************************************************************************************************/
 
 void dvz_canvas_to_refill(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    atomic_store(&canvas->refills.full_requested, true);
+    dvz_canvas_to_refill_partial(canvas);
+}
+
+
+
+void dvz_canvas_to_refill_partial(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
     DvzRefillStatus status = DVZ_REFILL_REQUESTED;
     atomic_store(&canvas->refills.status, status);
+    dvz_canvas_dirty(canvas);
 }
 
 
@@ -1168,6 +1255,18 @@ void dvz_canvas_to_close(DvzCanvas* canvas)
 
 
 
+void dvz_canvas_dirty(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    bool value = true;
+    atomic_store(&canvas->dirty, value);
+    // Wake up the main loop if it is waiting for window events, or sleeping in offscreen mode.
+    if (canvas->on_demand)
+        backend_wake(canvas->app->backend);
+}
+
+
+
 /*************************************************************************************************/
 /*  Utils                                                                                        */
 /*************************************************************************************************/
@@ -1687,11 +1786,40 @@ int dvz_event_pending(DvzCanvas* canvas, DvzEventType type)
 
 
 
+void dvz_event_coalesce(DvzCanvas* canvas, DvzEventType type, DvzEventCoalesce policy)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(type < DVZ_EVENT_COUNT);
+    // Deltas can only be accumulated for wheel events.
+    if (policy == DVZ_EVENT_COALESCE_ACCUMULATE && type != DVZ_EVENT_MOUSE_WHEEL)
+    {
+        log_error("only mouse wheel events can be accumulated");
+        return;
+    }
+    pthread_mutex_lock(&canvas->event_queue.lock);
+    canvas->event_coalesce[type] = policy;
+    pthread_mutex_unlock(&canvas->event_queue.lock);
+}
+
+
+
+uint64_t dvz_event_coalesced(DvzCanvas* canvas, DvzEventType type)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(type < DVZ_EVENT_COUNT);
+    pthread_mutex_lock(&canvas->event_queue.lock);
+    uint64_t count = canvas->event_coalesced[type];
+    pthread_mutex_unlock(&canvas->event_queue.lock);
+    return count;
+}
+
+
+
 void dvz_event_stop(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
-    DvzFifo* fifo = &canvas->event_queue;
-    dvz_fifo_reset(fifo);
+    // Return the pending events to the pool.
+    _event_discard(canvas, 0);
     // Send a null event to the queue which causes the dequeue awaiting thread to end.
     _event_enqueue(canvas, (DvzEvent){0});
 }
@@ -1702,11 +1830,12 @@ void dvz_event_stop(DvzCanvas* canvas)
 /*  Screencast                                                                                   */
 /*************************************************************************************************/
 
-static void _screencast_cmds(DvzScreencast* screencast)
+static void _screencast_cmds(DvzScreencast* screencast, DvzScreencastFrame* frame)
 {
     ASSERT(screencast != NULL);
     ASSERT(screencast->canvas != NULL);
     ASSERT(screencast->canvas->gpu != NULL);
+    ASSERT(frame != NULL);
 
     DvzImages* images = screencast->canvas->swapchain.images;
     uint32_t img_count = images->count;
@@ -1717,27 +1846,92 @@ static void _screencast_cmds(DvzScreencast* screencast)
 
     for (uint32_t i = 0; i < img_count; i++)
     {
-        dvz_cmd_reset(&screencast->cmds, i);
-        dvz_cmd_begin(&screencast->cmds, i);
+        dvz_cmd_reset(&frame->cmds, i);
+        dvz_cmd_begin(&frame->cmds, i);
 
         // Transition to SRC layout
         dvz_barrier_images_layout(
             &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
         dvz_barrier_images_access(
             &barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
-        dvz_cmd_barrier(&screencast->cmds, i, &barrier);
+        dvz_cmd_barrier(&frame->cmds, i, &barrier);
 
         // Copy swapchain image to screencast image
-        dvz_cmd_copy_image(&screencast->cmds, i, images, &screencast->staging);
+        dvz_cmd_copy_image(&frame->cmds, i, images, &frame->staging);
 
         // Transition back to previous layout
         dvz_barrier_images_layout(
             &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
         dvz_barrier_images_access(
             &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
-        dvz_cmd_barrier(&screencast->cmds, i, &barrier);
+        dvz_cmd_barrier(&frame->cmds, i, &barrier);
 
-        dvz_cmd_end(&screencast->cmds, i);
+        dvz_cmd_end(&frame->cmds, i);
+    }
+}
+
+
+
+// Download the frame from its staging image and emit a SCREENCAST event.
+static void _screencast_download(DvzCanvas* canvas, DvzScreencastFrame* frame)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(frame != NULL);
+    DvzScreencast* screencast = canvas->screencast;
+    ASSERT(screencast != NULL);
+
+    // To be freed by the SCREENCAST event callback.
+    uint8_t* rgb_a = calloc(frame->staging.width * frame->staging.height, 4 * sizeof(uint8_t));
+
+    // Copy the image from the staging image to the CPU.
+    log_trace("screencast CPU download");
+    dvz_images_download(&frame->staging, 0, 1, true, screencast->has_alpha, rgb_a);
+    frame->status = DVZ_SCREENCAST_IDLE;
+
+    // Readback latency statistics.
+    DvzScreencastStats* stats = &screencast->stats;
+    double latency = _clock_get(&canvas->clock) - frame->request_time;
+    stats->latency_avg = (stats->latency_avg * stats->frames + latency) / (stats->frames + 1);
+    stats->latency_max = MAX(stats->latency_max, latency);
+    stats->frames++;
+
+    // Enqueue a special SCREENCAST public event with a pointer to the CPU buffer user
+    DvzEvent sev = {0};
+    sev.type = DVZ_EVENT_SCREENCAST;
+    sev.u.sc.idx = screencast->frame_idx;
+    sev.u.sc.interval = screencast->clock.interval;
+    sev.u.sc.rgba = rgb_a;
+    sev.u.sc.width = frame->staging.width;
+    sev.u.sc.height = frame->staging.height;
+    log_trace("send SCREENCAST event");
+    _event_produce(canvas, sev);
+
+    _clock_set(&screencast->clock);
+    screencast->frame_idx++;
+}
+
+
+
+// Download the frames whose copy has completed, in capture order, without blocking.
+static void _screencast_collect(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzScreencast* screencast = canvas->screencast;
+    ASSERT(screencast != NULL);
+
+    DvzScreencastFrame* oldest = NULL;
+    while (true)
+    {
+        oldest = NULL;
+        for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+        {
+            if (screencast->frames[i].status == DVZ_SCREENCAST_AWAIT_TRANSFER &&
+                (oldest == NULL || screencast->frames[i].seq < oldest->seq))
+                oldest = &screencast->frames[i];
+        }
+        if (oldest == NULL || !dvz_fences_ready(&oldest->fence, 0))
+            break;
+        _screencast_download(canvas, oldest);
     }
 }
 
@@ -1754,24 +1948,29 @@ static void _screencast_timer_callback(DvzCanvas* canvas, DvzEvent ev)
     if (!screencast->is_active)
         return;
 
-    log_trace("screencast timer frame #%d", screencast->frame_idx);
-
-    dvz_fences_wait(&screencast->fence, 0);
+    log_trace("screencast timer frame #%" PRIu64, screencast->seq);
 
-    DvzSubmit* submit = &screencast->submit;
-    dvz_submit_reset(submit);
-    dvz_submit_commands(submit, &screencast->cmds);
-
-    // Wait for "image_ready" semaphore
-    dvz_submit_wait_semaphores(
-        submit, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, //
-        &canvas->sem_render_finished, canvas->cur_frame);
-
-    // Signal screencast_finished semaphore
-    dvz_submit_signal_semaphores(submit, &screencast->semaphore, 0);
+    // Find an idle staging image, the frame is dropped if they are all being downloaded.
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+    {
+        if (screencast->frames[i].status == DVZ_SCREENCAST_IDLE)
+        {
+            frame = &screencast->frames[i];
+            break;
+        }
+    }
+    if (frame == NULL)
+    {
+        log_trace("all screencast staging images are busy, dropping frame");
+        screencast->stats.dropped++;
+        return;
+    }
 
-    // Send screencast cmd buf to transfer queue and signal screencast fence when submitting.
-    screencast->status = DVZ_SCREENCAST_AWAIT_COPY;
+    // The copy job is sent in the POST_SEND callback.
+    frame->seq = screencast->seq++;
+    frame->request_time = _clock_get(&canvas->clock);
+    frame->status = DVZ_SCREENCAST_AWAIT_COPY;
 }
 
 
@@ -1784,72 +1983,43 @@ static void _screencast_post_send(DvzCanvas* canvas, DvzEvent ev)
     ASSERT(screencast != NULL);
     ASSERT(screencast->canvas != NULL);
     ASSERT(screencast->canvas->gpu != NULL);
-    if (!screencast->is_active)
-        return;
 
     uint32_t img_idx = canvas->swapchain.img_idx;
     // Always make sure the present semaphore is reset to its original value.
     canvas->present_semaphores = &canvas->sem_render_finished;
 
-    // Do nothing if the screencast image is not ready.
-    if (screencast->status <= DVZ_SCREENCAST_IDLE)
-        return;
-
-    log_trace("screencast event #%d", screencast->frame_idx);
-
-    // Send the copy job
-    if (screencast->status == DVZ_SCREENCAST_AWAIT_COPY)
+    // Send the copy job of the requested frame.
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
     {
+        frame = &screencast->frames[i];
+        if (frame->status != DVZ_SCREENCAST_AWAIT_COPY)
+            continue;
+
         log_trace("screencast send");
+        DvzSubmit* submit = &screencast->submit;
+        dvz_submit_reset(submit);
+        dvz_submit_commands(submit, &frame->cmds);
+
         // The copy job waits for the current image to be ready.
-        // It signals the screencast semaphore when the copy is done.
+        // It signals the frame semaphore when the copy is done.
         // The present swapchain command must wait for the screencast semaphore rather than
         // the render_finished semaphore.
-        // HACK: do not wait when submitting at the first frame.
-        dvz_submit_send(&screencast->submit, img_idx, &screencast->fence, 0);
-        // canvas->frame_idx == 0 ? NULL : &screencast->fence, 0);
-
-        canvas->present_semaphores = &screencast->semaphore;
-        screencast->status = DVZ_SCREENCAST_AWAIT_TRANSFER;
-    }
-
-    else if (screencast->status == DVZ_SCREENCAST_AWAIT_TRANSFER)
-    {
-        // if (!dvz_fences_ready(&screencast->fence, 0))
-        // {
-        //     log_trace("screencast await transfer but fence not ready");
-        //     return;
-        // }
-        // else
-        // {
-        //     log_trace("screencast await transfer and fence ready");
-        // }
-        dvz_fences_wait(&screencast->fence, 0);
-
-        // To be freed by the SCREENCAST event callback.
-        uint8_t* rgb_a =
-            calloc(screencast->staging.width * screencast->staging.height, 4 * sizeof(uint8_t));
-
-        // Copy the image from the staging image to the CPU.
-        log_trace("screencast CPU download");
-        dvz_images_download(&screencast->staging, 0, 1, true, screencast->has_alpha, rgb_a);
+        dvz_submit_wait_semaphores(
+            submit, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, //
+            &canvas->sem_render_finished, canvas->cur_frame);
+        dvz_submit_signal_semaphores(submit, &frame->semaphore, 0);
 
-        // Enqueue a special SCREENCAST public event with a pointer to the CPU buffer user
-        DvzEvent sev = {0};
-        sev.type = DVZ_EVENT_SCREENCAST;
-        sev.u.sc.idx = screencast->frame_idx;
-        sev.u.sc.interval = screencast->clock.interval;
-        sev.u.sc.rgba = rgb_a;
-        sev.u.sc.width = screencast->staging.width;
-        sev.u.sc.height = screencast->staging.height;
-        log_trace("send SCREENCAST event");
-        _event_produce(canvas, sev);
+        // NOTE: the fence is signaled, the frame being idle, so that there is no wait here.
+        dvz_submit_send(submit, img_idx, &frame->fence, 0);
 
-        // Reset screencast status.
-        _clock_set(&screencast->clock);
-        screencast->status = DVZ_SCREENCAST_IDLE;
-        screencast->frame_idx++;
+        canvas->present_semaphores = &frame->semaphore;
+        frame->status = DVZ_SCREENCAST_AWAIT_TRANSFER;
+        break;
     }
+
+    // The download of the previous frames overlaps with the rendering of the next frames.
+    _screencast_collect(canvas);
 }
 
 
@@ -1863,13 +2033,34 @@ static void _screencast_resize(DvzCanvas* canvas, DvzEvent ev)
     ASSERT(screencast->canvas != NULL);
     ASSERT(screencast->canvas->gpu != NULL);
 
-    screencast->status = DVZ_SCREENCAST_NONE;
-    dvz_images_resize(
-        &screencast->staging, canvas->swapchain.images->width, canvas->swapchain.images->height,
-        canvas->swapchain.images->depth);
-    dvz_images_transition(&screencast->staging);
+    // Finish the frames whose copy has been sent, before their staging images are resized.
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+    {
+        frame = &screencast->frames[i];
+        if (frame->status == DVZ_SCREENCAST_AWAIT_TRANSFER)
+            dvz_fences_wait(&frame->fence, 0);
+    }
+    _screencast_collect(canvas);
 
-    _screencast_cmds(screencast);
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+    {
+        frame = &screencast->frames[i];
+        // The frames whose copy has not been sent yet are dropped, as the image being rendered
+        // no longer matches the staging image.
+        if (frame->status == DVZ_SCREENCAST_AWAIT_COPY)
+        {
+            log_trace("dropping screencast frame #%" PRIu64 " after resize", frame->seq);
+            screencast->stats.dropped++;
+        }
+        ASSERT(frame->status != DVZ_SCREENCAST_AWAIT_TRANSFER);
+        frame->status = DVZ_SCREENCAST_IDLE;
+        dvz_images_resize(
+            &frame->staging, canvas->swapchain.images->width, canvas->swapchain.images->height,
+            canvas->swapchain.images->depth);
+        dvz_images_transition(&frame->staging);
+        _screencast_cmds(screencast, frame);
+    }
 }
 
 
@@ -1896,27 +2087,23 @@ void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alpha)
     sc->canvas = canvas;
     sc->has_alpha = has_alpha;
 
-    sc->staging = dvz_images(canvas->gpu, VK_IMAGE_TYPE_2D, 1);
-    dvz_images_format(&sc->staging, images->format);
-    dvz_images_size(&sc->staging, images->width, images->height, images->depth);
-    dvz_images_tiling(&sc->staging, VK_IMAGE_TILING_LINEAR);
-    dvz_images_usage(&sc->staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
-    dvz_images_layout(&sc->staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    dvz_images_memory(
-        &sc->staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    dvz_images_create(&sc->staging);
-
-    // Transition the staging image to its layout.
-    dvz_images_transition(&sc->staging);
+    // Ring of staging images, so that the download of a frame overlaps with the rendering of
+    // the next frames.
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+    {
+        frame = &sc->frames[i];
+        frame->staging = _staging_image(canvas, images->format, images->width, images->height);
 
-    sc->fence = dvz_fences(gpu, 1, true);
-    ASSERT(dvz_fences_ready(&sc->fence, 0));
-    sc->semaphore = dvz_semaphores(gpu, 1);
+        frame->fence = dvz_fences(gpu, 1, true);
+        ASSERT(dvz_fences_ready(&frame->fence, 0));
+        frame->semaphore = dvz_semaphores(gpu, 1);
 
-    // NOTE: we predefine the transfer command buffers, one per swapchain image.
-    sc->cmds =
-        dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_TRANSFER, canvas->swapchain.images->count);
-    _screencast_cmds(sc);
+        // NOTE: we predefine the transfer command buffers, one per swapchain image.
+        frame->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, images->count);
+        _screencast_cmds(sc, frame);
+        frame->status = DVZ_SCREENCAST_IDLE;
+    }
     sc->submit = dvz_submit(canvas->gpu);
 
     _clock_init(&sc->clock);
@@ -1934,6 +2121,29 @@ void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alpha)
 
 
 
+DvzScreencastStats dvz_screencast_stats(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzScreencastStats stats = {0};
+    DvzScreencast* screencast = canvas->screencast;
+    if (screencast == NULL)
+        return stats;
+    stats = screencast->stats;
+
+    // Video encoder statistics.
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)screencast->user_data;
+    if (encoder != NULL)
+    {
+        stats.encoded = atomic_load(&encoder->encoded);
+        stats.encode_dropped = encoder->dropped;
+        if (stats.encoded > 0)
+            stats.encode_avg = atomic_load(&encoder->encode_time_us) * 1e-6 / stats.encoded;
+    }
+    return stats;
+}
+
+
+
 void dvz_screencast_destroy(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
@@ -1944,9 +2154,20 @@ void dvz_screencast_destroy(DvzCanvas* canvas)
     if (!dvz_obj_is_created(&screencast->obj))
         return;
 
-    dvz_fences_destroy(&screencast->fence);
-    dvz_semaphores_destroy(&screencast->semaphore);
-    dvz_images_destroy(&screencast->staging);
+    DvzScreencastStats* stats = &screencast->stats;
+    log_debug(
+        "screencast: %" PRIu64 " frames, %" PRIu64 " dropped, readback latency %.1f ms "
+        "(max %.1f ms)",
+        stats->frames, stats->dropped, stats->latency_avg * 1000, stats->latency_max * 1000);
+
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_DEPTH; i++)
+    {
+        frame = &screencast->frames[i];
+        dvz_fences_destroy(&frame->fence);
+        dvz_semaphores_destroy(&frame->semaphore);
+        dvz_images_destroy(&frame->staging);
+    }
 
     dvz_obj_destroyed(&screencast->obj);
     FREE(screencast);
@@ -1995,7 +2216,7 @@ uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha)
 {
     // WARNING: this function is SLOW because it recreates a staging buffer at every call.
     // Also because it forces a hard synchronization on the whole GPU.
-    // TODO: more efficient screenshot saving with screencast
+    // NOTE: use dvz_screenshot_async() for periodic screenshots.
 
     ASSERT(canvas != NULL);
 
@@ -2027,10 +2248,11 @@ uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha)
     dvz_images_destroy(&staging);
 
     {
-        uint8_t* null = calloc(size, 1);
-        if (memcmp(rgba, null, size) == 0)
+        VkDeviceSize k = 0;
+        while (k < size && rgba[k] == 0)
+            k++;
+        if (k == size)
             log_warn("screenshot was blank");
-        FREE(null);
     }
 
     // NOTE: the caller MUST free the returned pointer.
@@ -2059,6 +2281,155 @@ void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path)
 
 
 
+static void _screenshot_record(DvzCanvas* canvas, DvzScreenshot* ss, uint32_t img_idx)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(ss != NULL);
+    DvzImages* images = canvas->swapchain.images;
+    ASSERT(images != NULL);
+
+    // Persistent staging image and copy commands, recreated only when the canvas is resized.
+    if (!dvz_obj_is_created(&ss->staging.obj) || ss->staging.width != images->width ||
+        ss->staging.height != images->height)
+    {
+        dvz_images_destroy(&ss->staging);
+        ss->staging = _staging_image(canvas, images->format, images->width, images->height);
+        FREE(ss->rgba);
+        ss->rgba = (uint8_t*)calloc(images->width * images->height, 4 * sizeof(uint8_t));
+    }
+    if (ss->cmds.obj.status < DVZ_OBJECT_STATUS_INIT)
+        ss->cmds = dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_RENDER, images->count);
+
+    // The copy is submitted after the render commands of the same frame, so that the barrier
+    // waits for the color attachment output of the frame.
+    DvzBarrier barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&barrier, images);
+
+    DvzCommands* cmds = &ss->cmds;
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin(cmds, img_idx);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+    dvz_cmd_copy_image_region(
+        cmds, img_idx, images, (ivec3){0, 0, 0}, &ss->staging, (ivec3){0, 0, 0},
+        (uvec3){images->width, images->height, images->depth});
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    dvz_barrier_images_access(&barrier, VK_ACCESS_TRANSFER_READ_BIT, 0);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+    dvz_cmd_end(cmds, img_idx);
+}
+
+
+
+// Add the requested screenshot copies to the Submit instance of the current frame.
+static void _screenshot_submit(DvzCanvas* canvas, DvzSubmit* submit, uint32_t f)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(submit != NULL);
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    DvzScreenshot* ss = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_SCREENSHOTS; i++)
+    {
+        ss = &canvas->screenshots[i];
+        if (ss->status != DVZ_SCREENSHOT_REQUESTED)
+            continue;
+        _screenshot_record(canvas, ss, img_idx);
+        dvz_submit_commands(submit, &ss->cmds);
+        ss->frame = f;
+        ss->status = DVZ_SCREENSHOT_PENDING;
+    }
+}
+
+
+
+// Download the screenshots whose frame fence has signaled, and call the callbacks. The
+// screenshots submitted with the frame in flight f are always collected, as the fence of that
+// frame is about to be reused.
+static void _screenshot_collect(DvzCanvas* canvas, uint32_t f)
+{
+    ASSERT(canvas != NULL);
+    DvzFences* fences = &canvas->fences_render_finished;
+    DvzScreenshot* ss = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_SCREENSHOTS; i++)
+    {
+        ss = &canvas->screenshots[i];
+        if (ss->status != DVZ_SCREENSHOT_PENDING)
+            continue;
+        if (ss->frame == f)
+            dvz_fences_wait(fences, f);
+        else if (!dvz_fences_ready(fences, ss->frame))
+            continue;
+
+        dvz_images_download(&ss->staging, 0, sizeof(uint8_t), true, ss->has_alpha, ss->rgba);
+        ss->status = DVZ_SCREENSHOT_IDLE;
+        if (ss->callback != NULL)
+            ss->callback(
+                canvas, ss->rgba, ss->staging.width, ss->staging.height, ss->user_data);
+    }
+}
+
+
+
+static void _screenshot_destroy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzScreenshot* ss = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_SCREENSHOTS; i++)
+    {
+        ss = &canvas->screenshots[i];
+        dvz_commands_destroy(&ss->cmds);
+        dvz_images_destroy(&ss->staging);
+        FREE(ss->rgba);
+        ss->status = DVZ_SCREENSHOT_NONE;
+    }
+}
+
+
+
+bool dvz_screenshot_async(
+    DvzCanvas* canvas, bool has_alpha, DvzScreenshotCallback callback, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    if (canvas->swapchain.images == NULL)
+    {
+        log_error("empty swapchain images, aborting screenshot creation");
+        return false;
+    }
+
+    // Find an available slot.
+    DvzScreenshot* ss = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_SCREENSHOTS; i++)
+    {
+        if (canvas->screenshots[i].status <= DVZ_SCREENSHOT_IDLE)
+        {
+            ss = &canvas->screenshots[i];
+            break;
+        }
+    }
+    if (ss == NULL)
+    {
+        log_warn("too many pending screenshots, skipping");
+        return false;
+    }
+
+    // NOTE: the staging image is created or resized when the copy is recorded.
+    ss->status = DVZ_SCREENSHOT_REQUESTED;
+    ss->has_alpha = has_alpha;
+    ss->callback = callback;
+    ss->user_data = user_data;
+    return true;
+}
+
+
+
 void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picked)
 {
     ASSERT(canvas != NULL);
@@ -2132,40 +2503,326 @@ void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picked)
 
 
 
+static void _pick_batch_record(DvzCanvas* canvas, DvzPickBatch* batch, uint32_t img_idx)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(batch != NULL);
+    ASSERT(batch->count > 0);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+
+    // Source image: pick image if pick support, otherwise swapchain image.
+    bool has_pick = _support_pick(canvas);
+    DvzImages* images = has_pick ? &canvas->pick_image : canvas->swapchain.images;
+    ASSERT(images != NULL);
+    VkImageLayout layout =
+        has_pick ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // Persistent staging buffer and copy commands.
+    if (!dvz_obj_is_created(&batch->staging.obj))
+    {
+        batch->staging = dvz_buffer(gpu);
+        dvz_buffer_size(&batch->staging, DVZ_MAX_PICK_QUERIES * sizeof(ivec4));
+        dvz_buffer_usage(&batch->staging, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        dvz_buffer_memory(
+            &batch->staging,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        dvz_buffer_queue_access(&batch->staging, DVZ_DEFAULT_QUEUE_RENDER);
+        dvz_buffer_create(&batch->staging);
+        batch->staging.mmap = dvz_buffer_map(&batch->staging, 0, VK_WHOLE_SIZE);
+    }
+    if (batch->cmds.obj.status < DVZ_OBJECT_STATUS_INIT)
+        batch->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+
+    DvzCommands* cmds = &batch->cmds;
+
+    // The image barriers take the image at the command buffer index, so the single pick image is
+    // repeated for every swapchain image.
+    DvzImages barrier_images = *images;
+    ASSERT(cmds->count <= DVZ_MAX_IMAGES_PER_SET);
+    for (uint32_t i = images->count; i < cmds->count; i++)
+        barrier_images.images[i] = images->images[0];
+    barrier_images.count = MAX(images->count, cmds->count);
+
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&barrier, &barrier_images);
+
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin(cmds, img_idx);
+    dvz_barrier_images_layout(&barrier, layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    // One single-pixel copy per query, into consecutive slots of the staging buffer.
+    uvec3 offset = {0};
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        offset[0] = MIN(batch->positions[i][0], images->width - 1);
+        offset[1] = MIN(batch->positions[i][1], images->height - 1);
+        dvz_cmd_copy_image_to_buffer_region(
+            cmds, img_idx, images, offset, (uvec3){1, 1, 1}, &batch->staging, i * sizeof(ivec4));
+    }
+
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    dvz_barrier_images_layout(&barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, layout);
+    dvz_barrier_images_access(&barrier, VK_ACCESS_TRANSFER_READ_BIT, 0);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+    dvz_cmd_end(cmds, img_idx);
+}
+
+
+
+// Add the requested pick copies to the Submit instance of the current frame.
+static void _pick_batch_submit(DvzCanvas* canvas, DvzSubmit* submit, uint32_t f)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(submit != NULL);
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    DvzPickBatch* batch = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_PICK_BATCHES; i++)
+    {
+        batch = &canvas->pick_batches[i];
+        if (batch->status != DVZ_PICK_BATCH_REQUESTED)
+            continue;
+        _pick_batch_record(canvas, batch, img_idx);
+        dvz_submit_commands(submit, &batch->cmds);
+        batch->frame = f;
+        batch->frame_idx = canvas->frame_idx;
+        batch->status = DVZ_PICK_BATCH_PENDING;
+    }
+}
+
+
+
+// Resolve the pick batches whose frame fence has signaled, and call the callbacks. The batches
+// submitted with the frame in flight f are always resolved, as the fence of that frame is about
+// to be reused.
+static void _pick_batch_collect(DvzCanvas* canvas, uint32_t f)
+{
+    ASSERT(canvas != NULL);
+    DvzFences* fences = &canvas->fences_render_finished;
+    bool has_pick = _support_pick(canvas);
+    DvzPickBatch* batch = NULL;
+    DvzPickResult* res = NULL;
+    double latency = 0;
+    for (uint32_t i = 0; i < DVZ_MAX_PICK_BATCHES; i++)
+    {
+        batch = &canvas->pick_batches[i];
+        if (batch->status != DVZ_PICK_BATCH_PENDING)
+            continue;
+        if (batch->frame == f)
+            dvz_fences_wait(fences, f);
+        else if (!dvz_fences_ready(fences, batch->frame))
+            continue;
+
+        // Read all queries from the mapped staging buffer.
+        ASSERT(batch->staging.mmap != NULL);
+        latency = _clock_get(&canvas->clock) - batch->request_time;
+        for (uint32_t j = 0; j < batch->count; j++)
+        {
+            res = &batch->results[j];
+            res->pos[0] = batch->positions[j][0];
+            res->pos[1] = batch->positions[j][1];
+            res->frame_idx = batch->frame_idx;
+            res->latency = latency;
+            if (has_pick)
+            {
+                memcpy(res->picked, &((ivec4*)batch->staging.mmap)[j], sizeof(ivec4));
+            }
+            else
+            {
+                // NOTE: the swapchain images are BGRA.
+                uint8_t* bgra = (uint8_t*)&((ivec4*)batch->staging.mmap)[j];
+                res->picked[0] = bgra[2];
+                res->picked[1] = bgra[1];
+                res->picked[2] = bgra[0];
+                res->picked[3] = 255;
+            }
+        }
+        batch->status = DVZ_PICK_BATCH_IDLE;
+        if (batch->callback != NULL)
+            batch->callback(canvas, batch->count, batch->results, batch->user_data);
+    }
+}
+
+
+
+static void _pick_batch_destroy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPickBatch* batch = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_PICK_BATCHES; i++)
+    {
+        batch = &canvas->pick_batches[i];
+        dvz_commands_destroy(&batch->cmds);
+        if (batch->staging.mmap != NULL)
+        {
+            dvz_buffer_unmap(&batch->staging);
+            batch->staging.mmap = NULL;
+        }
+        dvz_buffer_destroy(&batch->staging);
+        batch->status = DVZ_PICK_BATCH_IDLE;
+    }
+}
+
+
+
+bool dvz_canvas_pick_batch(
+    DvzCanvas* canvas, uint32_t count, uvec2* positions, //
+    DvzPickCallback callback, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(positions != NULL);
+    if (count == 0)
+        return false;
+    if (count > DVZ_MAX_PICK_QUERIES)
+    {
+        log_error("too many positions in the pick batch (%d > %d)", count, DVZ_MAX_PICK_QUERIES);
+        return false;
+    }
+
+    // Find an available batch.
+    DvzPickBatch* batch = NULL;
+    for (uint32_t i = 0; i < DVZ_MAX_PICK_BATCHES; i++)
+    {
+        if (canvas->pick_batches[i].status == DVZ_PICK_BATCH_IDLE)
+        {
+            batch = &canvas->pick_batches[i];
+            break;
+        }
+    }
+    if (batch == NULL)
+    {
+        log_debug("too many pending pick batches, skipping");
+        return false;
+    }
+
+    batch->count = count;
+    memcpy(batch->positions, positions, count * sizeof(uvec2));
+    batch->request_time = _clock_get(&canvas->clock);
+    batch->callback = callback;
+    batch->user_data = user_data;
+    batch->status = DVZ_PICK_BATCH_REQUESTED;
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Video screencast                                                                             */
 /*************************************************************************************************/
 
-static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+// Background thread encoding the frames of the video encoder queue.
+static void* _video_thread(void* user_data)
 {
-    ASSERT(canvas != NULL);
-    log_debug("video frame #%d", ev.u.sc.idx);
-
-    Video* video = (Video*)canvas->screencast->user_data;
-    if (video == NULL)
-        return;
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)user_data;
+    ASSERT(encoder != NULL);
+    Video* video = (Video*)encoder->video;
     ASSERT(video != NULL);
+    log_debug("starting video encoder thread");
+
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    double elapsed = 0;
+    uint8_t* rgba = NULL;
+    while (true)
+    {
+        dvz_ring_dequeue(&encoder->queue, &rgba, true);
+        // A NULL frame stops the encoder thread.
+        if (rgba == NULL)
+            break;
 
 // Create the video if needed.
 #if HAS_FFMPEG
-    if (video->ost == NULL)
-        create_video(video);
-    ASSERT(video->ost != NULL);
+        if (video->ost == NULL)
+            create_video(video);
+        ASSERT(video->ost != NULL);
 #else
-    if (video->fp == NULL)
-        create_video(video);
-    ASSERT(video->fp != NULL);
+        if (video->fp == NULL)
+            create_video(video);
+        ASSERT(video->fp != NULL);
 #endif
 
-    add_frame(video, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
+        elapsed = _clock_get(&clock);
+        add_frame(video, rgba);
+        elapsed = _clock_get(&clock) - elapsed;
+        FREE(rgba);
+
+        atomic_fetch_add(&encoder->encode_time_us, (uint64_t)(elapsed * 1e6));
+        atomic_fetch_add(&encoder->encoded, 1);
+    }
+    log_debug("end video encoder thread");
+    return NULL;
+}
+
+
+
+static void _video_encoder_stop(DvzScreencast* screencast)
+{
+    ASSERT(screencast != NULL);
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)screencast->user_data;
+    if (encoder == NULL)
+        return;
+
+    // Wait until all pending frames have been encoded.
+    uint8_t* stop = NULL;
+    while (!dvz_ring_enqueue(&encoder->queue, &stop))
+        dvz_sleep(1);
+    dvz_thread_join(&encoder->thread);
+    dvz_ring_destroy(&encoder->queue);
+
+    uint64_t encoded = atomic_load(&encoder->encoded);
+    double encode_avg = encoded > 0 ? atomic_load(&encoder->encode_time_us) * 1e-3 / encoded : 0;
+    log_info(
+        "video: %" PRIu64 " frames encoded (%.1f ms per frame), %" PRIu64
+        " dropped by the encoder, %" PRIu64 " dropped by the screencast",
+        encoded, encode_avg, encoder->dropped, screencast->stats.dropped);
+
+    // This call frees the pointer.
+    end_video((Video*)encoder->video);
+    FREE(encoder);
+    screencast->user_data = NULL;
+}
+
+
+
+static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    log_debug("video frame #%" PRIu64, ev.u.sc.idx);
+
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)canvas->screencast->user_data;
+    if (encoder == NULL)
+    {
+        FREE(ev.u.sc.rgba);
+        return;
+    }
+    ASSERT(encoder != NULL);
+
+    // The encoder thread takes ownership of the frame.
+    uint8_t* rgba = ev.u.sc.rgba;
+    while (!dvz_ring_enqueue(&encoder->queue, &rgba))
+    {
+        if (encoder->policy == DVZ_VIDEO_POLICY_DROP)
+        {
+            log_trace("video encoder queue is full, dropping frame #%" PRIu64, ev.u.sc.idx);
+            encoder->dropped++;
+            FREE(rgba);
+            return;
+        }
+        dvz_sleep(1);
+    }
 }
 
 static void _video_destroy(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
-    if (canvas->screencast != NULL && canvas->screencast->user_data != NULL)
-        end_video((Video*)canvas->screencast->user_data);
+    if (canvas->screencast != NULL)
+        _video_encoder_stop(canvas->screencast);
 }
 
 
@@ -2181,6 +2838,12 @@ void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char*
     if (video == NULL)
         return;
 
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)calloc(1, sizeof(DvzVideoEncoder));
+    encoder->video = video;
+    encoder->policy = DVZ_VIDEO_POLICY_BLOCK;
+    encoder->queue = dvz_ring(DVZ_VIDEO_QUEUE_CAPACITY, sizeof(uint8_t*));
+    encoder->thread = dvz_thread(_video_thread, encoder);
+
     dvz_event_callback(
         canvas, DVZ_EVENT_SCREENCAST, 0, DVZ_EVENT_MODE_SYNC, _video_callback, NULL);
     dvz_event_callback(canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _video_destroy, NULL);
@@ -2188,7 +2851,20 @@ void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char*
     dvz_screencast(canvas, 1. / framerate, true);
     ASSERT(canvas->screencast != NULL);
     canvas->screencast->is_active = record;
-    canvas->screencast->user_data = video;
+    canvas->screencast->user_data = encoder;
+}
+
+
+
+void dvz_canvas_video_policy(DvzCanvas* canvas, DvzVideoPolicy policy)
+{
+    ASSERT(canvas != NULL);
+    if (canvas->screencast == NULL || canvas->screencast->user_data == NULL)
+    {
+        log_error("there is no video screencast");
+        return;
+    }
+    ((DvzVideoEncoder*)canvas->screencast->user_data)->policy = policy;
 }
 
 
@@ -2220,10 +2896,8 @@ void dvz_canvas_stop(DvzCanvas* canvas)
     ASSERT(canvas->screencast != NULL);
     canvas->screencast->is_active = false;
     ASSERT(canvas->screencast->user_data != NULL);
-    // This call frees the pointer.
     log_info("stop screencast");
-    end_video((Video*)canvas->screencast->user_data);
-    canvas->screencast->user_data = NULL;
+    _video_encoder_stop(canvas->screencast);
 }
 
 
@@ -2284,6 +2958,10 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
         &canvas->fences_render_finished, f, //
         &canvas->fences_flight, img_idx);
 
+    // Hand the completed asynchronous screenshots and pick batches to their callbacks.
+    _screenshot_collect(canvas, f);
+    _pick_batch_collect(canvas, f);
+
     // Reset the Submit instance before adding the command buffers.
     dvz_submit_reset(s);
 
@@ -2292,6 +2970,13 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     if (canvas->cmds_render.obj.status == DVZ_OBJECT_STATUS_CREATED)
         dvz_submit_commands(s, &canvas->cmds_render);
 
+    // Asynchronous screenshot and pick copies, after the render commands.
+    if (s->commands_count > 0)
+    {
+        _screenshot_submit(canvas, s, f);
+        _pick_batch_submit(canvas, s, f);
+    }
+
     // // Extra render commands.
     // DvzCommands* cmds = dvz_container_iter(&canvas->commands);
     // while (cmds != NULL)
@@ -2320,6 +3005,11 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
         dvz_submit_signal_semaphores(s, &canvas->sem_render_finished, f);
     }
 
+    // Wait for the GPU transfers submitted since the last frame of this canvas, and let the next
+    // transfer batch wait on this frame.
+    dvz_transfer_sync_wait(&canvas->sync_transfer, s, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    dvz_transfer_sync_signal(&canvas->sync_frame, s);
+
     // SEND callbacks and send the Submit instance.
     {
         // Call PRE_SEND callbacks
@@ -2345,6 +3035,58 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
 
 
 
+// Whether the canvas needs to render a new frame. Always true, unless in on-demand mode.
+static bool _canvas_needs_frame(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->app != NULL);
+    if (!canvas->on_demand || canvas->frame_idx == 0)
+        return true;
+
+    // Explicit changes, and closing requests.
+    if (atomic_load(&canvas->dirty) || atomic_load(&canvas->to_close))
+        return true;
+    if (canvas->window != NULL &&
+        backend_window_should_close(canvas->app->backend, canvas->window->backend_window))
+        return true;
+
+    // Pending refills, screencasts, screenshots and pick batches need frames to complete.
+    if (atomic_load(&canvas->refills.status) != DVZ_REFILL_NONE || canvas->screencast != NULL)
+        return true;
+    for (uint32_t i = 0; i < DVZ_MAX_SCREENSHOTS; i++)
+        if (canvas->screenshots[i].status == DVZ_SCREENSHOT_REQUESTED ||
+            canvas->screenshots[i].status == DVZ_SCREENSHOT_PENDING)
+            return true;
+    for (uint32_t i = 0; i < DVZ_MAX_PICK_BATCHES; i++)
+        if (canvas->pick_batches[i].status == DVZ_PICK_BATCH_REQUESTED ||
+            canvas->pick_batches[i].status == DVZ_PICK_BATCH_PENDING)
+            return true;
+
+    // Mouse move, window resize, and TIMER callbacks.
+    if (_backend_window_changed(canvas))
+        return true;
+    return _timer_delay(canvas, _clock_get(&canvas->clock)) <= 0;
+}
+
+
+
+// Mark all canvases of a GPU as dirty, for example after data transfers.
+static void _gpu_canvases_dirty(DvzApp* app, DvzGpu* gpu)
+{
+    ASSERT(app != NULL);
+    DvzContainerIterator iterator = dvz_container_iterator(&app->canvases);
+    DvzCanvas* canvas = NULL;
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        if (canvas->gpu == gpu)
+            dvz_canvas_dirty(canvas);
+        dvz_container_iter(&iterator);
+    }
+}
+
+
+
 static void _process_gpu_transfers(DvzApp* app)
 {
     // NOTE: this has never been tested with multiple GPUs yet.
@@ -2358,6 +3100,9 @@ static void _process_gpu_transfers(DvzApp* app)
 
         // Pending transfers.
         ASSERT(gpu->context != NULL);
+        // The canvases need a new frame to show the transferred data.
+        if (!gpu->context->transfers.is_empty)
+            _gpu_canvases_dirty(app, gpu);
         // NOTE: the function below uses hard GPU synchronization primitives
         dvz_process_transfers(gpu->context);
 
@@ -2408,6 +3153,14 @@ int dvz_canvas_frame(DvzCanvas* canvas)
     if (canvas->window != NULL)
         dvz_window_poll_events(canvas->window);
 
+    // On-demand rendering: skip the frame if nothing has changed since the last one.
+    canvas->idle = !_canvas_needs_frame(canvas);
+    if (canvas->idle)
+        return 0;
+    // NOTE: the changes made while rendering this frame will trigger another frame.
+    bool dirty = false;
+    atomic_store(&canvas->dirty, dirty);
+
     // NOTE: swapchain image acquisition happens here
 
     // We acquire the next swapchain image.
@@ -2573,10 +3326,14 @@ int dvz_app_run(DvzApp* app, uint64_t frame_count)
     DvzContainerIterator iterator;
     DvzCanvas* canvas = NULL;
     uint32_t n_canvas_active = 0;
+    uint32_t n_canvas_idle = 0;
+    double timeout = 0;
     uint64_t iter = 0;
     for (iter = 0; iter < frame_count; iter++)
     {
         n_canvas_active = 0;
+        n_canvas_idle = 0;
+        timeout = DVZ_ON_DEMAND_TIMEOUT;
 
         // Loop over all canvases.
         iterator = dvz_container_iterator(&app->canvases);
@@ -2589,7 +3346,14 @@ int dvz_app_run(DvzApp* app, uint64_t frame_count)
             // Run and present the next canvas frame, and count the canvas as active if the
             // presentation was successfull.
             if (dvz_canvas_frame(canvas) == 0)
+            {
                 n_canvas_active++;
+                if (canvas->idle)
+                {
+                    n_canvas_idle++;
+                    timeout = MIN(timeout, _timer_delay(canvas, _clock_get(&canvas->clock)));
+                }
+            }
 
             // Go to the next canvas.
             dvz_container_iter(&iterator);
@@ -2598,6 +3362,11 @@ int dvz_app_run(DvzApp* app, uint64_t frame_count)
         // Process the pending GPU transfers after all canvases have executed their frame.
         _process_gpu_transfers(app);
 
+        // On-demand rendering: if all canvases are idle, block until the next window event
+        // instead of spinning, or until the next TIMER callback.
+        if (n_canvas_active > 0 && n_canvas_idle == n_canvas_active && timeout > 0)
+            backend_wait_events(app->backend, timeout);
+
         // Close the application if all canvases have been closed.
         if (n_canvas_active == 0 && frame_count != 1)
         {
@@ -2647,20 +3416,31 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     dvz_event_stop(canvas);
     dvz_thread_join(&canvas->event_thread);
     dvz_fifo_destroy(&canvas->event_queue);
+    dvz_pool_destroy(&canvas->event_pool);
 
     // Destroy callbacks.
     _destroy_callbacks(canvas);
 
-    // Destroy the graphics.
+    // Destroy the graphics, after the end of the background warm-up, if any.
     log_trace("canvas destroy graphics pipelines");
+    dvz_graphics_warmup_wait(canvas);
     CONTAINER_DESTROY_ITEMS(DvzGraphics, canvas->graphics, dvz_graphics_destroy)
     dvz_container_destroy(&canvas->graphics);
+    log_debug(
+        "graphics registry: %" PRIu64 " hit(s), %" PRIu64 " miss(es)",
+        canvas->graphics_registry.hits, canvas->graphics_registry.misses);
+    FREE(canvas->graphics_registry.entries);
+    memset(&canvas->graphics_registry, 0, sizeof(DvzGraphicsRegistry));
 
     // Destroy the depth and pick images.
     dvz_images_destroy(&canvas->depth_image);
     dvz_images_destroy(&canvas->pick_image);
     dvz_images_destroy(&canvas->pick_staging);
 
+    // Destroy the asynchronous screenshot and pick staging resources.
+    _screenshot_destroy(canvas);
+    _pick_batch_destroy(canvas);
+
     // Destroy the renderpasses.
     log_trace("canvas destroy renderpass");
     dvz_renderpass_destroy(&canvas->renderpass);
@@ -2701,6 +3481,8 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     log_trace("canvas destroy semaphores");
     dvz_semaphores_destroy(&canvas->sem_img_available);
     dvz_semaphores_destroy(&canvas->sem_render_finished);
+    dvz_transfer_sync_destroy(&canvas->sync_frame);
+    dvz_transfer_sync_destroy(&canvas->sync_transfer);
 
     // Destroy the fences.
     log_trace("canvas destroy fences");
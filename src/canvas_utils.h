@@ -19,13 +19,70 @@ static void _event_enqueue(DvzCanvas* canvas, DvzEvent event)
     ASSERT(canvas != NULL);
     DvzFifo* fifo = &canvas->event_queue;
     ASSERT(fifo != NULL);
-    DvzEvent* ev = (DvzEvent*)calloc(1, sizeof(DvzEvent));
+    DvzEvent* ev = (DvzEvent*)dvz_pool_alloc(&canvas->event_pool);
     *ev = event;
     dvz_fifo_enqueue(fifo, ev);
 }
 
 
 
+// Try to merge an event into the last pending event of the queue, if it has the same type and
+// if the event type has a coalescing policy. Return whether the event has been merged.
+static bool _event_coalesce(DvzCanvas* canvas, DvzEvent event)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(event.type < DVZ_EVENT_COUNT);
+    DvzEventCoalesce policy = canvas->event_coalesce[event.type];
+    if (policy == DVZ_EVENT_COALESCE_NONE)
+        return false;
+
+    DvzFifo* fifo = &canvas->event_queue;
+    ASSERT(fifo != NULL);
+    bool merged = false;
+    pthread_mutex_lock(&fifo->lock);
+
+    // NOTE: only the last pending event can be merged, so that the order of the events of
+    // different types (for example, moves before and after a click) is preserved.
+    if (fifo->head != fifo->tail)
+    {
+        int32_t last = fifo->tail > 0 ? fifo->tail - 1 : fifo->capacity - 1;
+        DvzEvent* pending = (DvzEvent*)fifo->items[last];
+        ASSERT(pending != NULL);
+        if (pending->type == event.type)
+        {
+            switch (policy)
+            {
+            case DVZ_EVENT_COALESCE_LATEST:
+                *pending = event;
+                merged = true;
+                break;
+
+            case DVZ_EVENT_COALESCE_ACCUMULATE:
+                // Only wheel events have deltas for now.
+                ASSERT(event.type == DVZ_EVENT_MOUSE_WHEEL);
+                if (pending->u.w.modifiers != event.u.w.modifiers)
+                    break;
+                pending->u.w.pos[0] = event.u.w.pos[0];
+                pending->u.w.pos[1] = event.u.w.pos[1];
+                pending->u.w.dir[0] += event.u.w.dir[0];
+                pending->u.w.dir[1] += event.u.w.dir[1];
+                merged = true;
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+    if (merged)
+        canvas->event_coalesced[event.type]++;
+
+    pthread_mutex_unlock(&fifo->lock);
+    return merged;
+}
+
+
+
 // Dequeue an event, immediately, or waiting until an event is available.
 static DvzEvent _event_dequeue(DvzCanvas* canvas, bool wait)
 {
@@ -39,12 +96,35 @@ static DvzEvent _event_dequeue(DvzCanvas* canvas, bool wait)
         return out;
     ASSERT(item != NULL);
     out = *item;
-    FREE(item);
+    dvz_pool_free(&canvas->event_pool, item);
     return out;
 }
 
 
 
+// Discard the oldest pending events so that at most max_size events remain in the queue, and
+// return them to the event pool. A max_size of 0 discards everything.
+static void _event_discard(DvzCanvas* canvas, int max_size)
+{
+    ASSERT(canvas != NULL);
+    DvzFifo* fifo = &canvas->event_queue;
+    int size = dvz_fifo_size(fifo);
+    if (size > max_size)
+        log_trace(
+            "discarding %d items in the event queue which is getting overloaded",
+            size - max_size);
+    DvzEvent* item = NULL;
+    for (; size > max_size; size--)
+    {
+        item = (DvzEvent*)dvz_fifo_dequeue(fifo, false);
+        if (item == NULL)
+            break;
+        dvz_pool_free(&canvas->event_pool, item);
+    }
+}
+
+
+
 // Whether there is at least one async callback.
 static bool _has_async_callbacks(DvzCanvas* canvas, DvzEventType type)
 {
@@ -116,17 +196,31 @@ static int _event_consume(DvzCanvas* canvas, DvzEvent ev, DvzEventMode mode)
 
 
 
+// Whether an event type requires a new frame in on-demand rendering mode.
+static bool _event_needs_frame(DvzEventType type)
+{
+    return type == DVZ_EVENT_INIT || type == DVZ_EVENT_GUI ||
+           (type >= DVZ_EVENT_MOUSE_PRESS && type <= DVZ_EVENT_RESIZE);
+}
+
+
+
 // Produce an event, call the sync callbacks, and enqueue the event if there is at least one async
 // callback.
 static int _event_produce(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
 
+    // Input and GUI events mark the canvas as dirty, in on-demand rendering mode.
+    if (canvas->on_demand && _event_needs_frame(ev.type))
+        dvz_canvas_dirty(canvas);
+
     // Call the sync callbacks directly.
     int n_callbacks = _event_consume(canvas, ev, DVZ_EVENT_MODE_SYNC);
 
     // Enqueue the event only if there is at least one async callback for that event type.
-    if (_has_async_callbacks(canvas, ev.type))
+    // Stale high-frequency events are merged into the last pending event when possible.
+    if (_has_async_callbacks(canvas, ev.type) && !_event_coalesce(canvas, ev))
         _event_enqueue(canvas, ev);
 
     return n_callbacks;
@@ -189,7 +283,8 @@ static void* _event_thread(void* p_canvas)
         // Handle event queue overloading: if events are enqueued faster than
         // they are consumed, we should discard the older events so that the
         // queue doesn't keep filling up.
-        dvz_fifo_discard(&canvas->event_queue, events_to_keep);
+        if (events_to_keep > 0)
+            _event_discard(canvas, events_to_keep);
 
         canvas->event_processing = DVZ_EVENT_NONE;
         counter++;
@@ -16,6 +16,38 @@ END_INCL_NO_WARN
 
 
 
+/*************************************************************************************************/
+/*  Allocation tracking                                                                          */
+/*************************************************************************************************/
+
+static DvzAllocHook ALLOC_HOOK;
+static void* ALLOC_HOOK_DATA;
+static atomic(uint64_t, ALLOC_COUNT);
+
+
+
+void dvz_alloc_hook(DvzAllocHook hook, void* user_data)
+{
+    ALLOC_HOOK_DATA = user_data;
+    ALLOC_HOOK = hook;
+}
+
+
+
+uint64_t dvz_alloc_count(void) { return atomic_load(&ALLOC_COUNT); }
+
+
+
+void dvz_alloc_track(size_t size)
+{
+    atomic_fetch_add(&ALLOC_COUNT, 1);
+    DvzAllocHook hook = ALLOC_HOOK;
+    if (hook != NULL)
+        hook(size, ALLOC_HOOK_DATA);
+}
+
+
+
 /*************************************************************************************************/
 /*  I/O                                                                                          */
 /*************************************************************************************************/
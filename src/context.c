@@ -25,13 +25,16 @@ static void _context_default_buffers(DvzContext* context)
 {
     ASSERT(context != NULL);
     ASSERT(context->gpu != NULL);
-    // Create a predetermined set of buffers.
+    // Declare a predetermined set of buffers, one per type. They are only created on first use,
+    // with the size specified in the context configuration.
     DvzBuffer* buffer = NULL;
     for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
     {
         buffer = dvz_container_alloc(&context->buffers);
         *buffer = dvz_buffer(context->gpu);
         ASSERT(buffer != NULL);
+        ASSERT(buffer == dvz_container_get(&context->buffers, i));
+        dvz_buffer_type(buffer, (DvzBufferType)i);
 
         // All buffers may be accessed from these queues.
         dvz_buffer_queue_access(buffer, DVZ_DEFAULT_QUEUE_TRANSFER);
@@ -41,88 +44,45 @@ static void _context_default_buffers(DvzContext* context)
 
     VkBufferUsageFlagBits transferable =
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    VkMemoryPropertyFlags mappable =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
     // Staging buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STAGING);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_STAGING);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_STAGING_SIZE);
-        dvz_buffer_usage(buffer, transferable);
-        dvz_buffer_memory(
-            buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-
-        // Permanently map the buffer.
-        buffer->mmap = dvz_buffer_map(buffer, 0, VK_WHOLE_SIZE);
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STAGING);
+    dvz_buffer_usage(buffer, transferable);
+    dvz_buffer_memory(buffer, mappable);
 
     // Vertex buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_VERTEX);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_VERTEX);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_VERTEX_SIZE);
-        dvz_buffer_usage(
-            buffer,
-            transferable | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-        dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_VERTEX);
+    dvz_buffer_usage(
+        buffer,
+        transferable | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // Index buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_INDEX);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_INDEX);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_INDEX_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-        dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_INDEX);
+    dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // Storage buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STORAGE);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_STORAGE);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_STORAGE_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-        dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STORAGE);
+    dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // Uniform buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_UNIFORM);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_UNIFORM);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_UNIFORM_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-        dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_UNIFORM);
+    dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // Mappable uniform buffer
-    {
-        buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
-        ASSERT(buffer != NULL);
-        dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
-        dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_UNIFORM_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-        dvz_buffer_memory(
-            buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        dvz_buffer_create(buffer);
-        ASSERT(dvz_obj_is_created(&buffer->obj));
-
-        // Permanently map the buffer.
-        buffer->mmap = dvz_buffer_map(buffer, 0, VK_WHOLE_SIZE);
-    }
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
+    dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    dvz_buffer_memory(buffer, mappable);
+
+    // Mappable indirect draw buffer
+    buffer = dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_INDIRECT);
+    dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    dvz_buffer_memory(buffer, mappable);
 }
 
 
@@ -131,24 +91,15 @@ static void _context_default_resources(DvzContext* context)
 {
     ASSERT(context != NULL);
 
-    // Create the default buffers.
+    // Declare the default buffers.
     _context_default_buffers(context);
 
-    // Create the font atlas and assign it to the context.
-    context->font_atlas = dvz_font_atlas(context);
-
-    // Color texture.
-    context->color_texture.arr = _load_colormaps();
-    context->color_texture.texture =
-        dvz_ctx_texture(context, 2, (uvec3){256, 256, 1}, VK_FORMAT_R8G8B8A8_UNORM);
-    dvz_texture_address_mode(
-        context->color_texture.texture, DVZ_TEXTURE_AXIS_U, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-    dvz_texture_address_mode(
-        context->color_texture.texture, DVZ_TEXTURE_AXIS_V, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-    dvz_context_colormap(context);
-
-    // Default 1D texture, for transfer functions.
-    context->transfer_texture = _default_transfer_texture(context);
+    // NOTE: the font atlas, the colormap texture and the transfer texture are created on first
+    // use, see dvz_context_font_atlas(), dvz_context_color_texture() and
+    // dvz_context_transfer_texture().
+    context->font_atlas.texture = NULL;
+    context->color_texture.texture = NULL;
+    context->transfer_texture = NULL;
 }
 
 
@@ -157,8 +108,26 @@ static void _destroy_resources(DvzContext* context)
 {
     ASSERT(context != NULL);
 
+    // The in-flight transfers may still use the buffers and the staging buffer.
+    _transfer_batch_complete(context, true);
+
+    // Release the slots of the unused default buffers. NOTE: the container iterator skips the
+    // destroyed items, so they must be released here rather than in CONTAINER_DESTROY_ITEMS.
+    DvzBuffer* buffer = NULL;
+    for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
+    {
+        buffer = (DvzBuffer*)dvz_container_get(&context->buffers, i);
+        if (buffer != NULL && !dvz_obj_is_created(&buffer->obj))
+        {
+            dvz_obj_destroyed(&buffer->obj);
+            dvz_container_delete_if_destroyed(&context->buffers, i);
+        }
+    }
+
     log_trace("context destroy buffers");
     CONTAINER_DESTROY_ITEMS(DvzBuffer, context->buffers, dvz_buffer_destroy)
+    for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
+        _allocator_reset(&context->allocators[i]);
 
     log_trace("context destroy sets of images");
     CONTAINER_DESTROY_ITEMS(DvzImages, context->images, dvz_images_destroy)
@@ -228,11 +197,18 @@ DvzContext* dvz_context(DvzGpu* gpu)
             DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzCompute), DVZ_OBJECT_TYPE_COMPUTE);
     }
 
-    // Transfer command buffer.
-    // context->transfer_cmd = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
-
     // FIFO queue with the pending transfers.
     context->transfers = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    context->transfer_pool = dvz_pool(sizeof(DvzTransfer), DVZ_TRANSFER_POOL_SIZE);
+
+    // Transfer command buffer, with the synchronization primitives of the transfer batches.
+    context->batch.cmds =
+        dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, DVZ_TRANSFER_BATCH_COUNT);
+    context->batch.fences = dvz_fences(gpu, DVZ_TRANSFER_BATCH_COUNT, false);
+
+    // Initial sizes of the default buffers.
+    dvz_context_config(context, dvz_context_config_default());
+    pthread_mutex_init(&context->batch.lock, NULL);
 
     // HACK: the vklite module makes the assumption that the queue #0 supports transfers.
     // Here, in the context, we make the same assumption. The first queue is reserved to transfers.
@@ -242,7 +218,7 @@ DvzContext* dvz_context(DvzGpu* gpu)
     gpu->context = context;
     dvz_obj_created(&context->obj);
 
-    // Create the default resources.
+    // Declare the default resources, which are created on first use.
     _context_default_resources(context);
 
     return context;
@@ -250,10 +226,123 @@ DvzContext* dvz_context(DvzGpu* gpu)
 
 
 
+DvzContextConfig dvz_context_config_default(void)
+{
+    DvzContextConfig config = {0};
+    config.buffer_sizes[DVZ_BUFFER_TYPE_STAGING] = DVZ_BUFFER_TYPE_STAGING_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_VERTEX] = DVZ_BUFFER_TYPE_VERTEX_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_INDEX] = DVZ_BUFFER_TYPE_INDEX_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_STORAGE] = DVZ_BUFFER_TYPE_STORAGE_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_UNIFORM] = DVZ_BUFFER_TYPE_UNIFORM_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE] = DVZ_BUFFER_TYPE_UNIFORM_SIZE;
+    config.buffer_sizes[DVZ_BUFFER_TYPE_INDIRECT] = DVZ_BUFFER_TYPE_INDIRECT_SIZE;
+
+    // Environment variables override the default sizes.
+    _env_size("DVZ_STAGING_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_STAGING]);
+    _env_size("DVZ_VERTEX_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_VERTEX]);
+    _env_size("DVZ_INDEX_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_INDEX]);
+    _env_size("DVZ_STORAGE_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_STORAGE]);
+    _env_size("DVZ_UNIFORM_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_UNIFORM]);
+    _env_size("DVZ_UNIFORM_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE]);
+    _env_size("DVZ_INDIRECT_SIZE", &config.buffer_sizes[DVZ_BUFFER_TYPE_INDIRECT]);
+    return config;
+}
+
+
+
+void dvz_context_config(DvzContext* context, DvzContextConfig config)
+{
+    ASSERT(context != NULL);
+    DvzBuffer* buffer = NULL;
+    for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
+    {
+        if (config.buffer_sizes[i] == 0)
+            config.buffer_sizes[i] = context->config.buffer_sizes[i];
+        buffer = (DvzBuffer*)dvz_container_get(&context->buffers, i);
+        if (buffer != NULL && dvz_obj_is_created(&buffer->obj) &&
+            config.buffer_sizes[i] != context->config.buffer_sizes[i])
+        {
+            log_warn("buffer %d has already been created, its size cannot be configured", i);
+            config.buffer_sizes[i] = context->config.buffer_sizes[i];
+        }
+    }
+
+    // The staging buffer must be large enough to hold a transfer chunk.
+    VkDeviceSize* staging_size = &config.buffer_sizes[DVZ_BUFFER_TYPE_STAGING];
+    if (*staging_size < DVZ_TRANSFER_CHUNK_SIZE)
+    {
+        log_warn(
+            "staging buffer size must be at least %s", pretty_size(DVZ_TRANSFER_CHUNK_SIZE));
+        *staging_size = DVZ_TRANSFER_CHUNK_SIZE;
+    }
+
+    context->config = config;
+    context->batch.ring.size = *staging_size;
+}
+
+
+
+DvzFontAtlas* dvz_context_font_atlas(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    DvzFontAtlas* atlas = &context->font_atlas;
+    if (atlas->font_texture == NULL)
+    {
+        log_debug("create the font atlas");
+        *atlas = dvz_font_atlas(context);
+    }
+    // After a context reset, the font atlas is kept but its texture must be recreated.
+    else if (atlas->texture == NULL)
+    {
+        atlas->texture = _font_texture(context, atlas);
+    }
+    ASSERT(atlas->texture != NULL);
+    return atlas;
+}
+
+
+
+DvzTexture* dvz_context_color_texture(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    DvzColorTexture* color_texture = &context->color_texture;
+    if (color_texture->texture == NULL)
+    {
+        log_debug("create the colormap texture");
+        color_texture->arr = _load_colormaps();
+        color_texture->texture =
+            dvz_ctx_texture(context, 2, (uvec3){256, 256, 1}, VK_FORMAT_R8G8B8A8_UNORM);
+        dvz_texture_address_mode(
+            color_texture->texture, DVZ_TEXTURE_AXIS_U, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+        dvz_texture_address_mode(
+            color_texture->texture, DVZ_TEXTURE_AXIS_V, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+        dvz_context_colormap(context);
+    }
+    return color_texture->texture;
+}
+
+
+
+DvzTexture* dvz_context_transfer_texture(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    if (context->transfer_texture == NULL)
+    {
+        log_debug("create the default transfer texture");
+        context->transfer_texture = _default_transfer_texture(context);
+    }
+    return context->transfer_texture;
+}
+
+
+
 void dvz_context_colormap(DvzContext* context)
 {
     ASSERT(context != NULL);
-    ASSERT(context->color_texture.texture != NULL);
+
+    // The colormap texture will be uploaded when it is first used.
+    if (context->color_texture.texture == NULL)
+        return;
     ASSERT(context->color_texture.arr != NULL);
 
     dvz_texture_upload(
@@ -285,16 +374,23 @@ void dvz_context_destroy(DvzContext* context)
     ASSERT(context != NULL);
     ASSERT(context->gpu != NULL);
 
-    // Destroy the font atlas.
-    dvz_font_atlas_destroy(&context->font_atlas);
+    // Destroy the font atlas, if it was used.
+    if (context->font_atlas.font_texture != NULL)
+        dvz_font_atlas_destroy(&context->font_atlas);
 
     // Destroy the buffers, images, samplers, textures, computes.
     _destroy_resources(context);
 
     // Destroy the transfers queue.
     dvz_fifo_destroy(&context->transfers);
+    dvz_pool_destroy(&context->transfer_pool);
+    dvz_commands_destroy(&context->batch.cmds);
+    dvz_fences_destroy(&context->batch.fences);
+    pthread_mutex_destroy(&context->batch.lock);
 
     // Free the allocated memory.
+    for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
+        _allocator_destroy(&context->allocators[i]);
     dvz_container_destroy(&context->buffers);
     dvz_container_destroy(&context->images);
     dvz_container_destroy(&context->samplers);
@@ -336,71 +432,54 @@ DvzBufferRegions dvz_ctx_buffers(
     ASSERT(size > 0);
     ASSERT(buffer_type < DVZ_BUFFER_TYPE_COUNT);
 
-    // Choose the first buffer with the requested type.
-    DvzContainerIterator iter = dvz_container_iterator(&context->buffers);
-    DvzBuffer* buffer = NULL;
-    while (iter.item != NULL)
-    {
-        buffer = iter.item;
-        if (dvz_obj_is_created(&buffer->obj) && buffer->type == buffer_type)
-            break;
-        dvz_container_iter(&iter);
-    }
+    // Choose the first buffer with the requested type, the default buffer is created if needed.
+    DvzBuffer* buffer = _ctx_default_buffer(context, buffer_type);
     if (buffer == NULL)
     {
         log_error("could not find buffer with requested type %d", buffer_type);
         return (DvzBufferRegions){0};
     }
-    ASSERT(buffer != NULL);
     ASSERT(buffer->type == buffer_type);
     ASSERT(dvz_obj_is_created(&buffer->obj));
 
     VkDeviceSize alignment = 0;
-    VkDeviceSize offset = buffer->allocated_size;
     bool needs_align =
         buffer_type == DVZ_BUFFER_TYPE_UNIFORM || buffer_type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE;
     if (needs_align)
     {
         alignment = context->gpu->device_properties.limits.minUniformBufferOffsetAlignment;
-        ASSERT(offset % alignment == 0); // offset should be already aligned
+        ASSERT(alignment > 0);
     }
-
-    DvzBufferRegions regions = dvz_buffer_regions(buffer, buffer_count, offset, size, alignment);
-    VkDeviceSize alsize = regions.aligned_size;
-    if (alsize == 0)
-        alsize = size;
+    VkDeviceSize alsize = alignment > 0 ? aligned_size(size, alignment) : size;
     ASSERT(alsize > 0);
 
-    if (!dvz_obj_is_created(&buffer->obj))
-    {
-        log_error("invalid buffer %d", buffer_type);
-        return regions;
-    }
+    // Find some space for all regions in the buffer.
+    DvzBufferAllocator* alloc = &context->allocators[buffer_type];
+    VkDeviceSize offset = _allocator_alloc(alloc, buffer, alsize * buffer_count, alignment);
+    DvzBufferRegions regions = dvz_buffer_regions(buffer, buffer_count, offset, size, alignment);
+    ASSERT(regions.offsets[0] == offset);
 
     // Check alignment for uniform buffers.
     if (needs_align)
     {
-        ASSERT(alignment > 0);
-        ASSERT(alsize % alignment == 0);
+        ASSERT(regions.aligned_size == alsize);
         for (uint32_t i = 0; i < buffer_count; i++)
             ASSERT(regions.offsets[i] % alignment == 0);
     }
 
     // Need to reallocate?
-    if (offset + alsize * buffer_count > regions.buffer->size)
+    if (buffer->allocated_size > buffer->size)
     {
-        VkDeviceSize new_size = dvz_next_pow2(offset + alsize * buffer_count);
+        VkDeviceSize new_size = dvz_next_pow2(buffer->allocated_size);
         log_info("reallocating buffer %d to %s", buffer_type, pretty_size(new_size));
-        dvz_buffer_resize(regions.buffer, new_size);
+        dvz_buffer_resize(buffer, new_size);
     }
 
     log_debug(
         "allocating %d buffers (type %d) with size %s (aligned size %s)", //
         buffer_count, buffer_type, pretty_size(size), pretty_size(alsize));
-    ASSERT(offset + alsize * buffer_count <= regions.buffer->size);
-    buffer->allocated_size += alsize * buffer_count;
-
-    ASSERT(regions.offsets[buffer_count - 1] + alsize == buffer->allocated_size);
+    ASSERT(buffer->allocated_size <= buffer->size);
+    ASSERT(regions.offsets[buffer_count - 1] + alsize <= buffer->allocated_size);
     return regions;
 }
 
@@ -408,9 +487,7 @@ DvzBufferRegions dvz_ctx_buffers(
 
 void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceSize new_size)
 {
-    // NOTE: this function tries to resize a buffer region in-place, which only works if
-    // it is the last allocated region in the buffer. Otherwise a brand new region is allocated,
-    // which wastes space. TODO: smarter memory management, defragmentation etc.
+    ASSERT(context != NULL);
     ASSERT(br->buffer != NULL);
     ASSERT(br->count > 0);
     if (br->count > 1)
@@ -420,23 +497,30 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
     }
     ASSERT(br->count == 1);
 
-    // The region is the last allocated in the buffer, we can safely resize it.
-    VkDeviceSize old_size = br->aligned_size > 0 ? br->aligned_size : br->size;
-    ASSERT(old_size > 0);
-    if (br->offsets[0] + old_size == br->buffer->allocated_size)
+    DvzBuffer* buffer = br->buffer;
+    DvzBufferAllocator* alloc = &context->allocators[buffer->type];
+    uint32_t pos = _allocator_live(alloc, br->offsets[0]);
+    if (pos == UINT32_MAX)
+    {
+        log_error("the buffer regions to resize were not allocated by the context");
+        return;
+    }
+    VkDeviceSize alsize = br->alignment > 0 ? aligned_size(new_size, br->alignment) : new_size;
+
+    // The region is followed by enough free space, we can safely resize it.
+    if (_allocator_grow(alloc, buffer, pos, alsize))
     {
         log_debug("resize the buffer region in-place");
         br->size = new_size;
         if (br->alignment > 0)
-            br->aligned_size = aligned_size(new_size, br->alignment);
-        br->buffer->allocated_size = br->offsets[0] + new_size;
+            br->aligned_size = alsize;
 
         // Need to reallocate a new underlying buffer.
-        if (br->offsets[0] + old_size > br->buffer->size)
+        if (buffer->allocated_size > buffer->size)
         {
-            VkDeviceSize bs = dvz_next_pow2(br->offsets[0] + old_size);
-            log_info("reallocating buffer #%d to %s", br->buffer->type, pretty_size(bs));
-            dvz_buffer_resize(br->buffer, bs);
+            VkDeviceSize bs = dvz_next_pow2(buffer->allocated_size);
+            log_info("reallocating buffer #%d to %s", buffer->type, pretty_size(bs));
+            dvz_buffer_resize(buffer, bs);
         }
     }
 
@@ -444,8 +528,157 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
     else
     {
         log_debug("failed to resize the buffer region in-place, allocating a new region");
-        *br = dvz_ctx_buffers(context, br->buffer->type, 1, new_size);
+        DvzBufferBlock block = alloc->live[pos];
+        _block_remove(alloc->live, &alloc->live_count, pos);
+        _allocator_release(alloc, buffer, block.offset, block.size);
+
+        *br = dvz_ctx_buffers(context, buffer->type, 1, new_size);
+        // Keep the registered owner of the regions.
+        if (block.owner != NULL)
+            dvz_ctx_buffers_owner(context, br, block.callback, block.user_data);
+    }
+}
+
+
+
+void dvz_ctx_buffers_free(DvzContext* context, DvzBufferRegions* br)
+{
+    ASSERT(context != NULL);
+    ASSERT(br != NULL);
+    if (br->buffer == NULL)
+        return;
+    ASSERT(br->count > 0);
+
+    DvzBuffer* buffer = br->buffer;
+    ASSERT(buffer->type < DVZ_BUFFER_TYPE_COUNT);
+    DvzBufferAllocator* alloc = &context->allocators[buffer->type];
+    uint32_t pos = _allocator_live(alloc, br->offsets[0]);
+    if (pos == UINT32_MAX)
+    {
+        log_error("the buffer regions to free were not allocated by the context");
+        return;
+    }
+
+    DvzBufferBlock block = alloc->live[pos];
+    log_debug(
+        "free %d buffers (type %d) with size %s", //
+        br->count, buffer->type, pretty_size(block.size));
+    _block_remove(alloc->live, &alloc->live_count, pos);
+    _allocator_release(alloc, buffer, block.offset, block.size);
+    *br = (DvzBufferRegions){0};
+}
+
+
+
+void dvz_ctx_buffers_owner(
+    DvzContext* context, DvzBufferRegions* br, DvzBufferRelocCallback callback, void* user_data)
+{
+    ASSERT(context != NULL);
+    ASSERT(br != NULL);
+    ASSERT(br->buffer != NULL);
+
+    DvzBufferAllocator* alloc = &context->allocators[br->buffer->type];
+    uint32_t pos = _allocator_live(alloc, br->offsets[0]);
+    if (pos == UINT32_MAX)
+    {
+        log_error("the buffer regions were not allocated by the context");
+        return;
+    }
+    alloc->live[pos].owner = br;
+    alloc->live[pos].callback = callback;
+    alloc->live[pos].user_data = user_data;
+}
+
+
+
+uint32_t dvz_ctx_buffers_compact(DvzContext* context, DvzBufferType buffer_type)
+{
+    ASSERT(context != NULL);
+    ASSERT(context->gpu != NULL);
+    ASSERT(buffer_type < DVZ_BUFFER_TYPE_COUNT);
+
+    DvzBuffer* buffer = _ctx_buffer(context, buffer_type);
+    DvzBufferAllocator* alloc = &context->allocators[buffer_type];
+    if (buffer == NULL || alloc->free_count == 0)
+        return 0;
+
+    VkDeviceSize alignment = 1;
+    if (buffer_type == DVZ_BUFFER_TYPE_UNIFORM || buffer_type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE)
+        alignment = context->gpu->device_properties.limits.minUniformBufferOffsetAlignment;
+
+    // Compute the new offsets: the owned regions are packed, the other ones are left in place.
+    VkDeviceSize* targets = (VkDeviceSize*)calloc(alloc->live_count, sizeof(VkDeviceSize));
+    VkDeviceSize cursor = 0, moved_size = 0;
+    uint32_t moved = 0;
+    DvzBufferBlock* block = NULL;
+    for (uint32_t i = 0; i < alloc->live_count; i++)
+    {
+        block = &alloc->live[i];
+        targets[i] = block->offset;
+        if (block->owner != NULL)
+            targets[i] = (cursor + alignment - 1) / alignment * alignment;
+        ASSERT(targets[i] <= block->offset);
+        if (targets[i] != block->offset)
+        {
+            moved++;
+            moved_size += block->size;
+        }
+        cursor = targets[i] + block->size;
+    }
+    if (moved == 0)
+    {
+        FREE(targets);
+        return 0;
     }
+
+    // The pending transfers refer to the old offsets, and the GPU must not use the buffer.
+    dvz_process_transfers(context);
+    _transfer_batch_complete(context, true);
+    dvz_gpu_wait(context->gpu);
+
+    _allocator_relocate(context, buffer, alloc, targets, moved_size);
+
+    // Patch the moved regions, and rebuild the free list from the gaps between the live regions.
+    VkDeviceSize old_size = buffer->allocated_size;
+    alloc->free_count = 0;
+    cursor = 0;
+    for (uint32_t i = 0; i < alloc->live_count; i++)
+    {
+        block = &alloc->live[i];
+        if (targets[i] != block->offset)
+        {
+            ASSERT(block->owner != NULL);
+            ASSERT(block->owner->buffer == buffer);
+            for (uint32_t j = 0; j < block->owner->count; j++)
+                block->owner->offsets[j] -= block->offset - targets[i];
+            // Keep the old offset to know which regions were moved.
+            VkDeviceSize old_offset = block->offset;
+            block->offset = targets[i];
+            targets[i] = old_offset;
+        }
+        if (block->offset > cursor)
+        {
+            DvzBufferBlock gap = {.offset = cursor, .size = block->offset - cursor};
+            _block_insert(
+                &alloc->free, &alloc->free_count, &alloc->free_capacity, alloc->free_count, gap);
+        }
+        cursor = block->offset + block->size;
+    }
+    buffer->allocated_size = cursor;
+    log_info(
+        "compacted buffer %d, %d regions moved, %s reclaimed", //
+        buffer_type, moved, pretty_size(old_size - cursor));
+
+    // Let the owners update the objects that refer to the moved regions.
+    for (uint32_t i = 0; i < alloc->live_count; i++)
+    {
+        block = &alloc->live[i];
+        if (targets[i] != block->offset || block->callback == NULL)
+            continue;
+        block->callback(block->owner, block->user_data);
+    }
+    FREE(targets);
+    return moved;
 }
 
 
@@ -591,27 +824,102 @@ void dvz_texture_address_mode(
 
 
 
-void dvz_texture_upload(
-    DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, const void* data)
+// Transfer a texture region through the staging buffer, in chunks of whole slices, or of whole
+// rows, that fit in the staging buffer.
+static void _texture_transfer(
+    DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, //
+    const void* upload_data, void* download_data)
 {
     ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
     DvzContext* context = texture->context;
     ASSERT(context != NULL);
     ASSERT(size > 0);
-    ASSERT(data != NULL);
+    ASSERT((upload_data != NULL) != (download_data != NULL));
+
+    // A zero shape means the whole image.
+    uvec3 full = {texture->image->width, texture->image->height, texture->image->depth};
+    uvec3 region = {0};
+    for (uint32_t i = 0; i < 3; i++)
+        region[i] = shape[i] == 0 ? full[i] - offset[i] : shape[i];
+
+    // Determine the number of rows and slices per chunk.
+    VkDeviceSize max_size = context->batch.ring.size;
+    VkDeviceSize texel = 0, row = 0, slice = 0;
+    uint32_t ny = region[1], nz = region[2];
+    if (size > max_size)
+    {
+        VkDeviceSize count = (VkDeviceSize)region[0] * region[1] * region[2];
+        texel = size / count;
+        ASSERT(texel * count == size);
+        row = region[0] * texel;
+        slice = region[1] * row;
+        if (slice <= max_size)
+            nz = (uint32_t)(max_size / slice);
+        else
+        {
+            nz = 1;
+            ny = (uint32_t)(max_size / row);
+        }
+        log_debug("split texture transfer of %s into chunks", pretty_size(size));
+    }
+    ASSERT(ny > 0 && nz > 0);
+
+    // The transfer command buffer is reset and rerecorded for every chunk.
+    DvzCommands cmds = dvz_commands(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
+    DvzBuffer* staging = NULL;
+    uvec3 chunk_offset = {0}, chunk_shape = {0};
+    VkDeviceSize chunk_size = 0, data_offset = 0;
+    for (uint32_t z = 0; z < region[2]; z += nz)
+    {
+        for (uint32_t y = 0; y < region[1]; y += ny)
+        {
+            chunk_shape[0] = region[0];
+            chunk_shape[1] = MIN(ny, region[1] - y);
+            chunk_shape[2] = MIN(nz, region[2] - z);
+            chunk_offset[0] = offset[0];
+            chunk_offset[1] = offset[1] + y;
+            chunk_offset[2] = offset[2] + z;
+            chunk_size =
+                texel > 0 ? (VkDeviceSize)chunk_shape[0] * chunk_shape[1] * chunk_shape[2] * texel
+                          : size;
+            // NOTE: the chunks are contiguous in the data, as they either contain whole slices,
+            // or rows of a single slice.
+            data_offset = z * slice + y * row;
+
+            staging = staging_buffer(context, chunk_size);
+            if (upload_data != NULL)
+            {
+                // Memcpy into the staging buffer, and copy to the texture.
+                dvz_buffer_upload(
+                    staging, 0, chunk_size, (const uint8_t*)upload_data + data_offset);
+                _copy_texture_from_staging(
+                    context, &cmds, texture, chunk_offset, chunk_shape, chunk_size);
+                dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+            }
+            else
+            {
+                // IMPORTANT: need to wait for the texture to be copied to the staging buffer,
+                // *before* downloading the data from the staging buffer.
+                _copy_texture_to_staging(
+                    context, &cmds, texture, chunk_offset, chunk_shape, chunk_size);
+                dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+                dvz_buffer_download(staging, 0, chunk_size, (uint8_t*)download_data + data_offset);
+            }
+        }
+    }
 
-    // Take the staging buffer.
-    DvzBuffer* staging = staging_buffer(context, size);
+    // The transfer queue is idle at this point, so the command buffer can be freed.
+    dvz_cmd_free(&cmds);
+}
 
-    // Memcpy into the staging buffer.
-    dvz_buffer_upload(staging, 0, size, data);
 
-    // Copy from the staging buffer to the texture.
-    _copy_texture_from_staging(context, texture, offset, shape, size);
 
-    // IMPORTANT: need to wait for the texture to be copied to the staging buffer, *before*
-    // downloading the data from the staging buffer.
-    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+void dvz_texture_upload(
+    DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, const void* data)
+{
+    ASSERT(data != NULL);
+    _texture_transfer(texture, offset, shape, size, data, NULL);
 }
 
 
@@ -619,24 +927,8 @@ void dvz_texture_upload(
 void dvz_texture_download(
     DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
 {
-    ASSERT(texture != NULL);
-    DvzContext* context = texture->context;
-    ASSERT(context != NULL);
-    ASSERT(size > 0);
     ASSERT(data != NULL);
-
-    // Take the staging buffer.
-    DvzBuffer* staging = staging_buffer(context, size);
-
-    // Copy from the staging buffer to the texture.
-    _copy_texture_to_staging(context, texture, offset, shape, size);
-
-    // IMPORTANT: need to wait for the texture to be copied to the staging buffer, *before*
-    // downloading the data from the staging buffer.
-    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
-
-    // Memcpy into the staging buffer.
-    dvz_buffer_download(staging, 0, size, data);
+    _texture_transfer(texture, offset, shape, size, NULL, data);
 }
 
 
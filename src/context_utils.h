@@ -2,6 +2,7 @@
 #define DVZ_CONTEXT_UTILS_HEADER
 
 #include "../include/datoviz/context.h"
+#include <errno.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,135 +11,243 @@ extern "C" {
 
 
 /*************************************************************************************************/
-/*  Staging buffer                                                                               */
+/*  Default buffers                                                                              */
 /*************************************************************************************************/
 
-// Get the staging buffer, and make sure it can contain `size` bytes.
-static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
+// Read a size in bytes from an environment variable, with an optional K, M or G suffix. The size
+// is left unchanged if the value is malformed, zero, or too large.
+static void _env_size(const char* name, VkDeviceSize* size)
 {
-    log_trace("requesting staging buffer of size %s", pretty_size(size));
-    DvzBuffer* staging = (DvzBuffer*)dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STAGING);
-    ASSERT(staging != NULL);
-    ASSERT(staging->buffer != VK_NULL_HANDLE);
-
-    // Make sure the staging buffer is idle before using it.
-    // TODO: optimize this and avoid hard synchronization here before copying data into
-    // the staging buffer.
-    // dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
-
-    // Resize the staging buffer is needed.
-    // TODO: keep staging buffer fixed and copy parts of the data to staging buffer in several
-    // steps?
-    if (staging->size < size)
+    ASSERT(name != NULL);
+    ASSERT(size != NULL);
+    const char* s = getenv(name);
+    if (s == NULL || strlen(s) == 0)
+        return;
+
+    // NOTE: strtoull() accepts leading spaces and a minus sign, which are rejected here.
+    char* end = NULL;
+    errno = 0;
+    VkDeviceSize value = s[0] >= '0' && s[0] <= '9' ? strtoull(s, &end, 10) : 0;
+    VkDeviceSize factor = 1;
+    bool valid = end != NULL && end != s && errno == 0;
+    if (valid)
     {
-        VkDeviceSize new_size = dvz_next_pow2(size);
-        log_debug("reallocating staging buffer to %s", pretty_size(new_size));
-        dvz_buffer_resize(staging, new_size);
+        switch (*end)
+        {
+        case 'G':
+        case 'g':
+            factor = 1024 * 1024 * 1024;
+            end++;
+            break;
+        case 'M':
+        case 'm':
+            factor = 1024 * 1024;
+            end++;
+            break;
+        case 'K':
+        case 'k':
+            factor = 1024;
+            end++;
+            break;
+        default:
+            break;
+        }
+        valid = *end == '\0' && value > 0 && value <= UINT64_MAX / factor;
     }
-    ASSERT(staging->size >= size);
-    return staging;
+    if (!valid)
+    {
+        log_warn(
+            "invalid size %s in environment variable %s, using the default %s", s, name,
+            pretty_size(*size));
+        return;
+    }
+    value *= factor;
+    log_debug("%s set to %s", name, pretty_size(value));
+    *size = value;
 }
 
 
 
-static void _copy_buffer_from_staging(
-    DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
+// Return the default buffer with the requested type, creating it on first use.
+static DvzBuffer* _ctx_default_buffer(DvzContext* context, DvzBufferType buffer_type)
 {
     ASSERT(context != NULL);
+    ASSERT(buffer_type < DVZ_BUFFER_TYPE_COUNT);
+    DvzBuffer* buffer = (DvzBuffer*)dvz_container_get(&context->buffers, buffer_type);
+    ASSERT(buffer != NULL);
+    ASSERT(buffer->type == buffer_type);
+    if (dvz_obj_is_created(&buffer->obj))
+        return buffer;
+
+    VkDeviceSize size = context->config.buffer_sizes[buffer_type];
+    log_debug("create default buffer %d with size %s", buffer_type, pretty_size(size));
+    dvz_buffer_size(buffer, size);
+    dvz_buffer_create(buffer);
+    ASSERT(dvz_obj_is_created(&buffer->obj));
+
+    // Permanently map the host-visible buffers.
+    if ((buffer->memory & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+        buffer->mmap = dvz_buffer_map(buffer, 0, VK_WHOLE_SIZE);
+    return buffer;
+}
 
-    DvzGpu* gpu = context->gpu;
-    ASSERT(gpu != NULL);
 
-    DvzBuffer* staging = staging_buffer(context, size);
-    ASSERT(staging != NULL);
 
-    // Take transfer cmd buf.
-    DvzCommands cmds_ = dvz_commands(gpu, 0, 1);
-    DvzCommands* cmds = &cmds_;
-    dvz_cmd_reset(cmds, 0);
-    dvz_cmd_begin(cmds, 0);
+/*************************************************************************************************/
+/*  Staging ring                                                                                 */
+/*************************************************************************************************/
 
-    VkBufferCopy region = {0};
-    region.size = size;
-    region.srcOffset = 0;
-    region.dstOffset = br.offsets[0] + offset;
-    vkCmdCopyBuffer(cmds->cmds[0], staging->buffer, br.buffer->buffer, br.count, &region);
-    dvz_cmd_end(cmds, 0);
+// Allocate a contiguous region of the staging ring, return false if there is not enough space.
+static bool _staging_ring_alloc(DvzStagingRing* ring, VkDeviceSize size, VkDeviceSize* offset)
+{
+    ASSERT(ring != NULL);
+    ASSERT(offset != NULL);
+    ASSERT(size <= ring->size);
+
+    VkDeviceSize alignment = DVZ_TRANSFER_STAGING_ALIGNMENT;
+    if (ring->used == 0)
+        ring->head = ring->tail = 0;
+    VkDeviceSize head = (ring->head + alignment - 1) / alignment * alignment;
+    VkDeviceSize skipped = head - ring->head;
+
+    // The free space is between the head and the end of the buffer, and then before the tail.
+    if (ring->used == 0 || ring->tail < ring->head)
+    {
+        if (head + size > ring->size)
+        {
+            // Wrap around, skipping the end of the buffer.
+            if (size > ring->tail)
+                return false;
+            skipped = ring->size - ring->head;
+            head = 0;
+        }
+    }
+    // The free space is between the head and the tail.
+    else if (head + size > ring->tail)
+        return false;
+
+    *offset = head;
+    ring->head = head + size;
+    ring->used += skipped + size;
+    ASSERT(ring->used <= ring->size);
+    return true;
+}
 
-    // Wait for the render queue to be idle.
-    // TODO: less brutal synchronization with semaphores. Here we stop all
-    // rendering so that we're sure that the buffer we're going to write to is not
-    // being used by the GPU.
-    // dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
 
-    // Submit the commands to the transfer queue.
-    DvzSubmit submit = dvz_submit(gpu);
-    dvz_submit_commands(&submit, cmds);
-    log_debug("copy %s from staging buffer", pretty_size(size));
-    dvz_submit_send(&submit, 0, NULL, 0);
 
-    // Wait for the transfer queue to be idle.
-    // TODO: less brutal synchronization with semaphores. Here we wait for the
-    // transfer to be complete before we send new rendering commands.
-    // dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+// Release the oldest regions of the staging ring, up to a given head position.
+static void _staging_ring_release(DvzStagingRing* ring, VkDeviceSize end, VkDeviceSize used)
+{
+    ASSERT(ring != NULL);
+    ASSERT(used <= ring->used);
+    ring->tail = end;
+    ring->used -= used;
 }
 
 
 
-static void _copy_buffer_to_staging(
-    DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
+/*************************************************************************************************/
+/*  Transfer batch                                                                               */
+/*************************************************************************************************/
+
+// Complete an in-flight transfer batch once its fence is signaled: copy the downloaded data from
+// the staging ring, release its staging regions, and mark its transfers as done. Return false if
+// the batch is still running on the GPU (only when not waiting). The batch lock is held, as this
+// may be called from another thread with dvz_transfer_done().
+static bool _transfer_slot_complete(DvzContext* context, uint32_t slot, bool wait)
 {
     ASSERT(context != NULL);
+    DvzTransferBatch* batch = &context->batch;
+    ASSERT(slot < DVZ_TRANSFER_BATCH_COUNT);
+    bool completed = true;
 
-    DvzGpu* gpu = context->gpu;
-    ASSERT(gpu != NULL);
+    pthread_mutex_lock(&batch->lock);
+    if (!batch->in_flight[slot])
+        goto unlock;
 
-    DvzBuffer* staging = staging_buffer(context, size);
-    ASSERT(staging != NULL);
+    if (wait)
+        dvz_fences_wait(&batch->fences, slot);
+    else if (!dvz_fences_ready(&batch->fences, slot))
+    {
+        completed = false;
+        goto unlock;
+    }
+
+    if (batch->download_count[slot] > 0)
+    {
+        DvzBuffer* staging = _ctx_default_buffer(context, DVZ_BUFFER_TYPE_STAGING);
+        ASSERT(staging != NULL);
+        DvzTransferDownload* download = NULL;
+        for (uint32_t i = 0; i < batch->download_count[slot]; i++)
+        {
+            download = &batch->downloads[slot][i];
+            dvz_buffer_download(staging, download->staging_offset, download->size, download->data);
+        }
+        batch->download_count[slot] = 0;
+    }
+
+    _staging_ring_release(&batch->ring, batch->ring_end[slot], batch->ring_used[slot]);
+    batch->in_flight[slot] = false;
+    atomic_store(&batch->done, batch->ticket_flight[slot]);
+
+unlock:
+    pthread_mutex_unlock(&batch->lock);
+    return completed;
+}
 
-    // Take transfer cmd buf.
-    DvzCommands cmds_ = dvz_commands(gpu, 0, 1);
-    DvzCommands* cmds = &cmds_;
-    dvz_cmd_reset(cmds, 0);
-    dvz_cmd_begin(cmds, 0);
 
-    // Determine the offset in the source buffer.
-    // Should be consecutive offsets.
-    VkDeviceSize vk_offset = br.offsets[0];
-    uint32_t n_regions = br.count;
-    for (uint32_t i = 1; i < n_regions; i++)
+
+// Complete the in-flight transfer batches, in submission order. Return false if some batches are
+// still running on the GPU (only when not waiting).
+static bool _transfer_batch_complete(DvzContext* context, bool wait)
+{
+    ASSERT(context != NULL);
+    DvzTransferBatch* batch = &context->batch;
+
+    // The oldest batch is the one after the batch being recorded.
+    pthread_mutex_lock(&batch->lock);
+    uint32_t cur = batch->cur;
+    pthread_mutex_unlock(&batch->lock);
+    uint32_t slot = 0;
+    for (uint32_t i = 1; i <= DVZ_TRANSFER_BATCH_COUNT; i++)
     {
-        ASSERT(br.offsets[i] == vk_offset + i * size);
+        slot = (cur + i) % DVZ_TRANSFER_BATCH_COUNT;
+        if (!_transfer_slot_complete(context, slot, wait))
+            return false;
     }
-    // Take into account the transfer offset.
-    vk_offset += offset;
+    return true;
+}
 
-    // Copy to staging buffer
-    ASSERT(br.buffer != 0);
-    dvz_cmd_copy_buffer(cmds, 0, br.buffer, vk_offset, staging, 0, size * n_regions);
-    dvz_cmd_end(cmds, 0);
 
-    // Wait for the compute queue to be idle, as we assume the buffer to be copied from may
-    // be modified by compute shaders.
-    // TODO: more efficient synchronization (semaphores?)
-    // dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_COMPUTE);
 
-    // Submit the commands to the transfer queue.
-    DvzSubmit submit = dvz_submit(gpu);
-    dvz_submit_commands(&submit, cmds);
-    log_debug("copy %s to staging buffer", pretty_size(size));
-    dvz_submit_send(&submit, 0, NULL, 0);
+/*************************************************************************************************/
+/*  Staging buffer                                                                               */
+/*************************************************************************************************/
 
-    // Wait for the transfer queue to be idle.
-    // TODO: less brutal synchronization with semaphores. Here we wait for the
-    // transfer to be complete before we send new rendering commands.
-    // dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+// Get the staging buffer for a synchronous transfer of `size` bytes at offset 0, once all
+// in-flight transfer batches have completed.
+static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
+{
+    log_trace("requesting staging buffer of size %s", pretty_size(size));
+    DvzBuffer* staging = _ctx_default_buffer(context, DVZ_BUFFER_TYPE_STAGING);
+    ASSERT(staging != NULL);
+    ASSERT(staging->buffer != VK_NULL_HANDLE);
+
+    // Make sure the staging buffer is not used by the transfer batches.
+    ASSERT(!context->batch.is_recording);
+    _transfer_batch_complete(context, true);
+    ASSERT(context->batch.ring.used == 0);
+
+    // NOTE: the staging buffer has a fixed size, larger transfers must be split into chunks.
+    ASSERT(size <= staging->size);
+    return staging;
 }
 
 
 
 static void _copy_texture_from_staging(
-    DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
+    DvzContext* context, DvzCommands* cmds, DvzTexture* texture, uvec3 offset, uvec3 shape,
+    VkDeviceSize size)
 {
     ASSERT(context != NULL);
 
@@ -148,9 +257,8 @@ static void _copy_texture_from_staging(
     DvzBuffer* staging = staging_buffer(context, size);
     ASSERT(staging != NULL);
 
-    // Take transfer cmd buf.
-    DvzCommands cmds_ = dvz_commands(gpu, 0, 1);
-    DvzCommands* cmds = &cmds_;
+    // Reuse the transfer command buffer of the caller, which is allocated once for all chunks.
+    ASSERT(cmds != NULL);
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
@@ -160,13 +268,18 @@ static void _copy_texture_from_staging(
     ASSERT(texture != NULL);
     ASSERT(texture->image != NULL);
     dvz_barrier_images(&barrier, texture->image);
+    // NOTE: the previous image contents can only be discarded if the whole image is updated.
+    bool whole = offset[0] == 0 && offset[1] == 0 && offset[2] == 0 &&
+                 shape[0] == texture->image->width && shape[1] == texture->image->height &&
+                 shape[2] == texture->image->depth;
     dvz_barrier_images_layout(
-        &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        &barrier, whole ? VK_IMAGE_LAYOUT_UNDEFINED : texture->image->layout,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     dvz_barrier_images_access(&barrier, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
     dvz_cmd_barrier(cmds, 0, &barrier);
 
-    // Copy to staging buffer
-    dvz_cmd_copy_buffer_to_image(cmds, 0, staging, texture->image);
+    // Copy from the staging buffer
+    dvz_cmd_copy_buffer_to_image_region(cmds, 0, staging, 0, texture->image, offset, shape);
 
     // Image transition.
     dvz_barrier_images_layout(
@@ -193,7 +306,8 @@ static void _copy_texture_from_staging(
 
 
 static void _copy_texture_to_staging(
-    DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
+    DvzContext* context, DvzCommands* cmds, DvzTexture* texture, uvec3 offset, uvec3 shape,
+    VkDeviceSize size)
 {
     ASSERT(context != NULL);
 
@@ -203,9 +317,8 @@ static void _copy_texture_to_staging(
     DvzBuffer* staging = staging_buffer(context, size);
     ASSERT(staging != NULL);
 
-    // Take transfer cmd buf.
-    DvzCommands cmds_ = dvz_commands(gpu, 0, 1);
-    DvzCommands* cmds = &cmds_;
+    // Reuse the transfer command buffer of the caller, which is allocated once for all chunks.
+    ASSERT(cmds != NULL);
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
@@ -216,12 +329,12 @@ static void _copy_texture_to_staging(
     ASSERT(texture->image != NULL);
     dvz_barrier_images(&barrier, texture->image);
     dvz_barrier_images_layout(
-        &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        &barrier, texture->image->layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     dvz_barrier_images_access(&barrier, 0, VK_ACCESS_TRANSFER_READ_BIT);
     dvz_cmd_barrier(cmds, 0, &barrier);
 
     // Copy to staging buffer
-    dvz_cmd_copy_image_to_buffer(cmds, 0, texture->image, staging);
+    dvz_cmd_copy_image_to_buffer_region(cmds, 0, texture->image, offset, shape, staging, 0);
 
     // Image transition.
     dvz_barrier_images_layout(
@@ -247,6 +360,304 @@ static void _copy_texture_to_staging(
 
 
 
+/*************************************************************************************************/
+/*  Buffer allocator                                                                             */
+/*************************************************************************************************/
+
+// Return the first created buffer with the requested type.
+static DvzBuffer* _ctx_buffer(DvzContext* context, DvzBufferType buffer_type)
+{
+    ASSERT(context != NULL);
+    DvzContainerIterator iter = dvz_container_iterator(&context->buffers);
+    DvzBuffer* buffer = NULL;
+    while (iter.item != NULL)
+    {
+        buffer = iter.item;
+        if (dvz_obj_is_created(&buffer->obj) && buffer->type == buffer_type)
+            return buffer;
+        dvz_container_iter(&iter);
+    }
+    return NULL;
+}
+
+
+
+// Insert a block at a given position in an array of blocks.
+static void _block_insert(
+    DvzBufferBlock** blocks, uint32_t* count, uint32_t* capacity, uint32_t pos,
+    DvzBufferBlock block)
+{
+    ASSERT(blocks != NULL);
+    ASSERT(count != NULL);
+    ASSERT(capacity != NULL);
+    ASSERT(pos <= *count);
+
+    if (*count >= *capacity)
+    {
+        *capacity = *capacity > 0 ? 2 * *capacity : DVZ_BUFFER_ALLOCATOR_DEFAULT_CAPACITY;
+        REALLOC(*blocks, *capacity * sizeof(DvzBufferBlock));
+    }
+    ASSERT(*count < *capacity);
+    memmove(&(*blocks)[pos + 1], &(*blocks)[pos], (*count - pos) * sizeof(DvzBufferBlock));
+    (*blocks)[pos] = block;
+    (*count)++;
+}
+
+
+
+// Remove the block at a given position in an array of blocks.
+static void _block_remove(DvzBufferBlock* blocks, uint32_t* count, uint32_t pos)
+{
+    ASSERT(blocks != NULL);
+    ASSERT(count != NULL);
+    ASSERT(pos < *count);
+    memmove(&blocks[pos], &blocks[pos + 1], (*count - pos - 1) * sizeof(DvzBufferBlock));
+    (*count)--;
+}
+
+
+
+// Return the position of the first block whose offset is not lower than a given offset.
+static uint32_t _block_search(DvzBufferBlock* blocks, uint32_t count, VkDeviceSize offset)
+{
+    uint32_t lo = 0, hi = count, mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (blocks[mid].offset < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+
+// Return the position of the live allocation starting at a given offset, or UINT32_MAX.
+static uint32_t _allocator_live(DvzBufferAllocator* alloc, VkDeviceSize offset)
+{
+    ASSERT(alloc != NULL);
+    uint32_t pos = _block_search(alloc->live, alloc->live_count, offset);
+    if (pos < alloc->live_count && alloc->live[pos].offset == offset)
+        return pos;
+    return UINT32_MAX;
+}
+
+
+
+// Add a free block, merged with the adjacent free blocks and with the end of the allocated space.
+static void _allocator_release(
+    DvzBufferAllocator* alloc, DvzBuffer* buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(alloc != NULL);
+    ASSERT(buffer != NULL);
+    if (size == 0)
+        return;
+    ASSERT(offset + size <= buffer->allocated_size);
+
+    uint32_t pos = _block_search(alloc->free, alloc->free_count, offset);
+    DvzBufferBlock* prev = pos > 0 ? &alloc->free[pos - 1] : NULL;
+    if (prev != NULL && prev->offset + prev->size == offset)
+    {
+        offset = prev->offset;
+        size += prev->size;
+        _block_remove(alloc->free, &alloc->free_count, --pos);
+    }
+    DvzBufferBlock* next = pos < alloc->free_count ? &alloc->free[pos] : NULL;
+    if (next != NULL && offset + size == next->offset)
+    {
+        size += next->size;
+        _block_remove(alloc->free, &alloc->free_count, pos);
+    }
+
+    // The space at the end of the buffer is not tracked in the free list.
+    if (offset + size == buffer->allocated_size)
+    {
+        buffer->allocated_size = offset;
+        return;
+    }
+    DvzBufferBlock block = {.offset = offset, .size = size};
+    _block_insert(&alloc->free, &alloc->free_count, &alloc->free_capacity, pos, block);
+}
+
+
+
+// Allocate an aligned region in the smallest free block that fits, or at the end of the
+// allocated space. The buffer may need to be resized afterwards.
+static VkDeviceSize _allocator_alloc(
+    DvzBufferAllocator* alloc, DvzBuffer* buffer, VkDeviceSize size, VkDeviceSize alignment)
+{
+    ASSERT(alloc != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(size > 0);
+    VkDeviceSize align = alignment > 0 ? alignment : 1;
+
+    uint32_t best = UINT32_MAX;
+    VkDeviceSize offset = 0;
+    DvzBufferBlock* block = NULL;
+    for (uint32_t i = 0; i < alloc->free_count; i++)
+    {
+        block = &alloc->free[i];
+        offset = (block->offset + align - 1) / align * align;
+        if (offset + size <= block->offset + block->size &&
+            (best == UINT32_MAX || block->size < alloc->free[best].size))
+            best = i;
+    }
+
+    if (best != UINT32_MAX)
+    {
+        DvzBufferBlock free_block = alloc->free[best];
+        _block_remove(alloc->free, &alloc->free_count, best);
+        offset = (free_block.offset + align - 1) / align * align;
+        // Give back the parts of the free block that are not used.
+        _allocator_release(alloc, buffer, free_block.offset, offset - free_block.offset);
+        _allocator_release(
+            alloc, buffer, offset + size, free_block.offset + free_block.size - offset - size);
+    }
+    else
+    {
+        VkDeviceSize end = buffer->allocated_size;
+        offset = (end + align - 1) / align * align;
+        buffer->allocated_size = offset + size;
+        _allocator_release(alloc, buffer, end, offset - end);
+    }
+
+    DvzBufferBlock live = {.offset = offset, .size = size};
+    uint32_t pos = _block_search(alloc->live, alloc->live_count, offset);
+    _block_insert(&alloc->live, &alloc->live_count, &alloc->live_capacity, pos, live);
+    return offset;
+}
+
+
+
+// Try to resize a live allocation in place, return false if it is not followed by enough space.
+static bool
+_allocator_grow(DvzBufferAllocator* alloc, DvzBuffer* buffer, uint32_t pos, VkDeviceSize size)
+{
+    ASSERT(alloc != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(pos < alloc->live_count);
+
+    DvzBufferBlock* block = &alloc->live[pos];
+    VkDeviceSize end = block->offset + block->size;
+    if (size <= block->size)
+    {
+        block->size = size;
+        _allocator_release(alloc, buffer, block->offset + size, end - block->offset - size);
+        return true;
+    }
+
+    VkDeviceSize extra = size - block->size;
+    if (end == buffer->allocated_size)
+    {
+        buffer->allocated_size += extra;
+        block->size = size;
+        return true;
+    }
+
+    uint32_t next = _block_search(alloc->free, alloc->free_count, end);
+    if (next < alloc->free_count && alloc->free[next].offset == end &&
+        alloc->free[next].size >= extra)
+    {
+        DvzBufferBlock free_block = alloc->free[next];
+        _block_remove(alloc->free, &alloc->free_count, next);
+        block->size = size;
+        _allocator_release(alloc, buffer, end + extra, free_block.size - extra);
+        return true;
+    }
+    return false;
+}
+
+
+
+// Copy the moved blocks of a buffer to their new offsets, through a temporary buffer as the
+// source and destination regions may overlap.
+static void _allocator_relocate(
+    DvzContext* context, DvzBuffer* buffer, DvzBufferAllocator* alloc, VkDeviceSize* targets,
+    VkDeviceSize moved_size)
+{
+    ASSERT(context != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(alloc != NULL);
+    ASSERT(targets != NULL);
+    ASSERT(moved_size > 0);
+    DvzGpu* gpu = context->gpu;
+    ASSERT(gpu != NULL);
+
+    DvzBuffer tmp = dvz_buffer(gpu);
+    dvz_buffer_queue_access(&tmp, DVZ_DEFAULT_QUEUE_TRANSFER);
+    dvz_buffer_size(&tmp, moved_size);
+    dvz_buffer_usage(&tmp, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    dvz_buffer_memory(&tmp, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    dvz_buffer_create(&tmp);
+
+    DvzCommands cmds_ = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
+    DvzCommands* cmds = &cmds_;
+    dvz_cmd_reset(cmds, 0);
+    dvz_cmd_begin(cmds, 0);
+
+    DvzBufferBlock* block = NULL;
+    VkDeviceSize tmp_offset = 0;
+    for (uint32_t i = 0; i < alloc->live_count; i++)
+    {
+        block = &alloc->live[i];
+        if (targets[i] == block->offset)
+            continue;
+        dvz_cmd_copy_buffer(cmds, 0, buffer, block->offset, &tmp, tmp_offset, block->size);
+        tmp_offset += block->size;
+    }
+    ASSERT(tmp_offset == moved_size);
+
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        cmds->cmds[0], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+        &barrier, 0, NULL, 0, NULL);
+
+    tmp_offset = 0;
+    for (uint32_t i = 0; i < alloc->live_count; i++)
+    {
+        block = &alloc->live[i];
+        if (targets[i] == block->offset)
+            continue;
+        dvz_cmd_copy_buffer(cmds, 0, &tmp, tmp_offset, buffer, targets[i], block->size);
+        tmp_offset += block->size;
+    }
+    dvz_cmd_end(cmds, 0);
+
+    DvzSubmit submit = dvz_submit(gpu);
+    dvz_submit_commands(&submit, cmds);
+    dvz_submit_send(&submit, 0, NULL, 0);
+    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+
+    dvz_commands_destroy(cmds);
+    dvz_buffer_destroy(&tmp);
+}
+
+
+
+static void _allocator_reset(DvzBufferAllocator* alloc)
+{
+    ASSERT(alloc != NULL);
+    alloc->free_count = 0;
+    alloc->live_count = 0;
+}
+
+
+
+static void _allocator_destroy(DvzBufferAllocator* alloc)
+{
+    ASSERT(alloc != NULL);
+    FREE(alloc->free);
+    FREE(alloc->live);
+    memset(alloc, 0, sizeof(DvzBufferAllocator));
+}
+
+
+
 /*************************************************************************************************/
 /*  Default resources                                                                            */
 /*************************************************************************************************/
@@ -45,6 +45,7 @@ static void _fifo_resize(DvzFifo* fifo)
 
         fifo->capacity *= 2;
         log_debug("FIFO queue is full, enlarging it to %d", fifo->capacity);
+        dvz_alloc_track((uint32_t)fifo->capacity * sizeof(void*));
         REALLOC(fifo->items, (uint32_t)fifo->capacity * sizeof(void*));
     }
 
@@ -224,6 +225,182 @@ void dvz_fifo_destroy(DvzFifo* fifo)
 
 
 
+/*************************************************************************************************/
+/*  Lock-free ring                                                                               */
+/*************************************************************************************************/
+
+// NOTE: every slot has a sequence number. A slot at position `pos` can be written by a producer
+// when its sequence number is `pos`, and read by the consumer when it is `pos + 1`. Once read,
+// its sequence number becomes `pos + capacity`, the position of its next use.
+
+DvzRing dvz_ring(uint32_t capacity, size_t item_size)
+{
+    ASSERT(capacity >= 2);
+    ASSERT(item_size > 0);
+    capacity = (uint32_t)dvz_next_pow2(capacity);
+    log_trace(
+        "creating lock-free ring queue with %d slots of %d bytes", capacity, (int)item_size);
+
+    DvzRing ring = {0};
+    ring.capacity = capacity;
+    ring.item_size = item_size;
+    ring.items = (uint8_t*)calloc(capacity, item_size);
+    ring.seqs = calloc(capacity, sizeof(*ring.seqs));
+    ASSERT(ring.items != NULL);
+    ASSERT(ring.seqs != NULL);
+    for (uint32_t i = 0; i < capacity; i++)
+        atomic_init(&ring.seqs[i], i);
+    atomic_init(&ring.tail, 0);
+    atomic_init(&ring.head, 0);
+    atomic_init(&ring.is_waiting, false);
+
+    if (pthread_mutex_init(&ring.lock, NULL) != 0)
+        log_error("mutex creation failed");
+    if (pthread_cond_init(&ring.cond, NULL) != 0)
+        log_error("cond creation failed");
+
+    return ring;
+}
+
+
+
+// Whether the item at the head of the ring has been written.
+static inline bool _ring_ready(DvzRing* ring, uint64_t pos)
+{
+    uint64_t seq =
+        atomic_load_explicit(&ring->seqs[pos & (ring->capacity - 1)], memory_order_acquire);
+    return seq == pos + 1;
+}
+
+
+
+// Block the consumer until the item at the head of the ring has been written.
+static void _ring_wait(DvzRing* ring, uint64_t pos)
+{
+    pthread_mutex_lock(&ring->lock);
+    atomic_store(&ring->is_waiting, true);
+    // NOTE: pairs with the fence in dvz_ring_enqueue(), so that either the consumer sees the new
+    // item, or the producer sees the waiting consumer and signals it.
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!_ring_ready(ring, pos))
+        pthread_cond_wait(&ring->cond, &ring->lock);
+    atomic_store(&ring->is_waiting, false);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+
+
+bool dvz_ring_enqueue(DvzRing* ring, const void* item)
+{
+    ASSERT(ring != NULL);
+    ASSERT(item != NULL);
+
+    uint64_t mask = ring->capacity - 1;
+    uint64_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t seq = 0;
+    int64_t diff = 0;
+
+    // Claim a slot.
+    while (true)
+    {
+        seq = atomic_load_explicit(&ring->seqs[pos & mask], memory_order_acquire);
+        diff = (int64_t)seq - (int64_t)pos;
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                    &ring->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The slot has not been read yet since the previous turn: the ring is full.
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+
+    // Copy the item and publish it.
+    memcpy(&ring->items[(pos & mask) * ring->item_size], item, ring->item_size);
+    atomic_store_explicit(&ring->seqs[pos & mask], pos + 1, memory_order_release);
+
+    // Wake up the consumer if it is waiting.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->is_waiting, memory_order_relaxed))
+    {
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_signal(&ring->cond);
+        pthread_mutex_unlock(&ring->lock);
+    }
+    return true;
+}
+
+
+
+uint32_t dvz_ring_dequeue_batch(DvzRing* ring, void* items, uint32_t max_count, bool wait)
+{
+    ASSERT(ring != NULL);
+    ASSERT(items != NULL);
+    ASSERT(max_count > 0);
+
+    uint64_t mask = ring->capacity - 1;
+    uint64_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (!_ring_ready(ring, pos))
+    {
+        if (!wait)
+            return 0;
+        _ring_wait(ring, pos);
+    }
+
+    // Read the successive items that have been written.
+    uint8_t* out = (uint8_t*)items;
+    uint32_t count = 0;
+    while (count < max_count && _ring_ready(ring, pos))
+    {
+        memcpy(out, &ring->items[(pos & mask) * ring->item_size], ring->item_size);
+        // Release the slot for the next turn.
+        atomic_store_explicit(&ring->seqs[pos & mask], pos + ring->capacity, memory_order_release);
+        out += ring->item_size;
+        pos++;
+        count++;
+    }
+    atomic_store_explicit(&ring->head, pos, memory_order_relaxed);
+    return count;
+}
+
+
+
+bool dvz_ring_dequeue(DvzRing* ring, void* item, bool wait)
+{
+    return dvz_ring_dequeue_batch(ring, item, 1, wait) == 1;
+}
+
+
+
+uint32_t dvz_ring_size(DvzRing* ring)
+{
+    ASSERT(ring != NULL);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    // NOTE: the tail counts the claimed slots, some of which may not be written yet.
+    return tail > head ? (uint32_t)MIN(tail - head, ring->capacity) : 0;
+}
+
+
+
+void dvz_ring_destroy(DvzRing* ring)
+{
+    ASSERT(ring != NULL);
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->cond);
+    FREE(ring->items);
+    FREE(ring->seqs);
+}
+
+
+
 /*************************************************************************************************/
 /*  Dequeues                                                                                     */
 /*************************************************************************************************/
@@ -7,6 +7,15 @@ layout (location = 1) in vec4 color;
 layout (location = 0) out vec4 out_color;
 
 void main() {
-    gl_Position = transform(pos);
+    vec3 p = pos;
+
+    // Streamed visual: the x coordinate is given by the position of the item in the window.
+    if (viewport.ring_size > 0) {
+        p.x = ring_x(gl_VertexIndex);
+        if (viewport.data_norm > 0)
+            p.x = (p.x - mvp.data_shift.x) / mvp.data_scale.x;
+    }
+
+    gl_Position = transform(p);
     out_color = color;
 }
@@ -27,6 +27,16 @@ layout (location = 3) out vec2 out_texcoord;
 layout (location = 4) out vec2 out_bevel_distance;
 
 
+// Position of a point of a streamed path, whose x coordinate holds its ring buffer slot.
+vec3 ring_pos(vec3 p) {
+    if (viewport.ring_size == 0)
+        return p;
+    p.x = ring_x(uint(p.x));
+    if (viewport.data_norm > 0)
+        p.x = (p.x - mvp.data_shift.x) / mvp.data_scale.x;
+    return p;
+}
+
 float compute_u(vec2 p0, vec2 p1, vec2 p) {
     // Projection p' of p such that p' = p0 + u*(p1-p0)
     // Then  u *= lenght(p1-p0)
@@ -58,10 +68,10 @@ void main() {
     mat4 ortho_inv = inverse(ortho);
 
     // Screen coordinates.
-    vec4 p0_ = ortho_inv * transform(p0_ndc);
-    vec4 p1_ = ortho_inv * transform(p1_ndc);
-    vec4 p2_ = ortho_inv * transform(p2_ndc);
-    vec4 p3_ = ortho_inv * transform(p3_ndc);
+    vec4 p0_ = ortho_inv * transform(ring_pos(p0_ndc));
+    vec4 p1_ = ortho_inv * transform(ring_pos(p1_ndc));
+    vec4 p2_ = ortho_inv * transform(ring_pos(p2_ndc));
+    vec4 p3_ = ortho_inv * transform(ring_pos(p3_ndc));
 
     vec2 p0 = p0_.xy / p0_.w;
     vec2 p1 = p1_.xy / p1_.w;
@@ -271,7 +271,7 @@ static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count,
 
     ASSERT(item_count > 0);
     dvz_array_resize(data->vertices, 4 * item_count);
-    DvzFontAtlas* atlas = &data->graphics->gpu->context->font_atlas;
+    DvzFontAtlas* atlas = dvz_context_font_atlas(data->graphics->gpu->context);
     ASSERT(atlas != NULL);
 
     if (item == NULL)
@@ -721,49 +721,170 @@ void dvz_graphics_append(DvzGraphicsData* data, const void* item)
 
 
 /*************************************************************************************************/
-/*  Graphics builtin                                                                             */
+/*  Graphics registry                                                                            */
 /*************************************************************************************************/
 
-static DvzGraphics* _find_graphics(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+static inline DvzGraphicsKey _graphics_key(DvzCanvas* canvas, DvzGraphicsType type, int flags)
 {
     ASSERT(canvas != NULL);
-    ASSERT(type != DVZ_GRAPHICS_CUSTOM);
+    // NOTE: all builtin graphics are created on the first subpass of the canvas renderpass.
+    DvzGraphicsKey key = {0};
+    key.type = type;
+    key.flags = flags;
+    key.renderpass = &canvas->renderpass;
+    key.subpass = 0;
+    return key;
+}
+
+
+
+static inline bool _graphics_key_equal(DvzGraphicsKey* a, DvzGraphicsKey* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    return a->type == b->type && a->flags == b->flags && a->renderpass == b->renderpass &&
+           a->subpass == b->subpass;
+}
+
+
 
-    DvzContainerIterator iter = dvz_container_iterator(&canvas->graphics);
-    DvzGraphics* graphics = NULL;
-    if (iter.item != NULL)
+static inline uint32_t _graphics_key_hash(DvzGraphicsKey* key)
+{
+    ASSERT(key != NULL);
+    // splitmix64 finalizer on the packed key fields.
+    uint64_t h = (uint64_t)key->type | ((uint64_t)(uint32_t)key->flags << 32);
+    h ^= (uint64_t)(uintptr_t)key->renderpass + 0x9e3779b97f4a7c15ULL + key->subpass;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h = h ^ (h >> 31);
+    return (uint32_t)h;
+}
+
+
+
+// Return the slot of a key: either the slot holding the key, or the empty slot where it would be
+// inserted.
+static uint32_t _registry_slot(DvzGraphicsRegistry* registry, DvzGraphicsKey* key)
+{
+    ASSERT(registry != NULL);
+    ASSERT(registry->capacity > 0);
+    uint32_t mask = registry->capacity - 1;
+    uint32_t idx = _graphics_key_hash(key) & mask;
+    DvzGraphicsEntry* entry = NULL;
+    while (true)
     {
-        graphics = iter.item;
-        if (graphics->type == type && graphics->flags == flags)
-            return graphics;
-        dvz_container_iter(&iter);
+        entry = &registry->entries[idx];
+        if (entry->graphics == NULL || _graphics_key_equal(&entry->key, key))
+            return idx;
+        idx = (idx + 1) & mask;
     }
-    return NULL;
 }
 
 
 
-DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+static DvzGraphicsEntry* _registry_find(DvzGraphicsRegistry* registry, DvzGraphicsKey* key)
 {
-    ASSERT(canvas != NULL);
-    ASSERT(canvas->gpu != NULL);
-    ASSERT(type != DVZ_GRAPHICS_NONE);
-    ASSERT(canvas->graphics.capacity > 0);
+    ASSERT(registry != NULL);
+    if (registry->count == 0)
+        return NULL;
+    DvzGraphicsEntry* entry = &registry->entries[_registry_slot(registry, key)];
+    return entry->graphics != NULL ? entry : NULL;
+}
 
-    // Try to find an existing graphics with the requested type and flags.
-    DvzGraphics* graphics = _find_graphics(canvas, type, flags);
-    if (graphics != NULL)
-        return graphics;
 
-    // If there is none, create a new one.
-    graphics = dvz_container_alloc(&canvas->graphics);
+
+static DvzGraphicsEntry*
+_registry_insert(DvzGraphicsRegistry* registry, DvzGraphicsKey* key, DvzGraphics* graphics)
+{
+    ASSERT(registry != NULL);
+    ASSERT(graphics != NULL);
+
+    // Keep the load factor below 1/2, rehashing into a table twice as large.
+    if (2 * (registry->count + 1) > registry->capacity)
+    {
+        uint32_t old_capacity = registry->capacity;
+        DvzGraphicsEntry* old_entries = registry->entries;
+        registry->capacity = old_capacity > 0 ? 2 * old_capacity : DVZ_GRAPHICS_REGISTRY_SIZE;
+        registry->entries =
+            (DvzGraphicsEntry*)calloc(registry->capacity, sizeof(DvzGraphicsEntry));
+        for (uint32_t i = 0; i < old_capacity; i++)
+        {
+            if (old_entries[i].graphics != NULL)
+                registry->entries[_registry_slot(registry, &old_entries[i].key)] = old_entries[i];
+        }
+        FREE(old_entries);
+    }
+
+    DvzGraphicsEntry* entry = &registry->entries[_registry_slot(registry, key)];
+    ASSERT(entry->graphics == NULL);
+    entry->key = *key;
+    entry->graphics = graphics;
+    entry->ref_count = 0;
+    registry->count++;
+    return entry;
+}
+
+
+
+// Remove an entry with backward-shift deletion, so that the probe sequences stay unbroken
+// without tombstones.
+static void _registry_remove(DvzGraphicsRegistry* registry, DvzGraphicsEntry* entry)
+{
+    ASSERT(registry != NULL);
+    ASSERT(entry != NULL);
+    ASSERT(registry->count > 0);
+    uint32_t mask = registry->capacity - 1;
+    uint32_t hole = (uint32_t)(entry - registry->entries);
+    uint32_t idx = hole;
+    uint32_t home = 0;
+    while (true)
+    {
+        idx = (idx + 1) & mask;
+        if (registry->entries[idx].graphics == NULL)
+            break;
+        // Move the entry into the hole if its home slot is not between the hole and itself.
+        home = _graphics_key_hash(&registry->entries[idx].key) & mask;
+        if (((idx - home) & mask) >= ((idx - hole) & mask))
+        {
+            registry->entries[hole] = registry->entries[idx];
+            hole = idx;
+        }
+    }
+    memset(&registry->entries[hole], 0, sizeof(DvzGraphicsEntry));
+    registry->count--;
+}
+
+
+
+/*************************************************************************************************/
+/*  Graphics builtin                                                                             */
+/*************************************************************************************************/
+
+// Allocate a builtin graphics in the canvas container and register it. Must be called from the
+// main thread. The returned entry is only valid until the next registry insertion.
+static DvzGraphicsEntry* _graphics_builtin_alloc(DvzCanvas* canvas, DvzGraphicsKey* key)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(key != NULL);
+    DvzGraphics* graphics = dvz_container_alloc(&canvas->graphics);
     ASSERT(graphics != NULL);
     ASSERT(!dvz_obj_is_created(&graphics->obj));
     *graphics = dvz_graphics(canvas->gpu);
-    graphics->type = type;
-    graphics->flags = flags;
+    graphics->type = key->type;
+    graphics->flags = key->flags;
+    return _registry_insert(&canvas->graphics_registry, key, graphics);
+}
+
+
 
-    switch (type)
+// Set up and create the pipeline of an allocated builtin graphics. This function only touches
+// the graphics itself, so it may be called from a worker thread.
+static void _graphics_builtin_create(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(graphics != NULL);
+
+    switch (graphics->type)
     {
 
         // Basic graphics types.
@@ -843,12 +964,195 @@ DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int f
         log_error("no graphics type specified");
         break;
     }
+}
+
+
+
+/*************************************************************************************************/
+/*  Graphics warm-up                                                                             */
+/*************************************************************************************************/
 
+static void* _warmup_thread(void* user_data)
+{
+    DvzCanvas* canvas = (DvzCanvas*)user_data;
+    ASSERT(canvas != NULL);
+    DvzGraphicsWarmup* warmup = &canvas->warmup;
+    uint32_t idx = 0;
+    while (true)
+    {
+        pthread_mutex_lock(&warmup->lock);
+        idx = warmup->next++;
+        pthread_mutex_unlock(&warmup->lock);
+        if (idx >= warmup->count)
+            break;
+
+        _graphics_builtin_create(canvas, warmup->graphics[idx]);
+
+        pthread_mutex_lock(&warmup->lock);
+        warmup->done[idx] = true;
+        pthread_cond_broadcast(&warmup->cond);
+        pthread_mutex_unlock(&warmup->lock);
+    }
+    return NULL;
+}
+
+
+
+// Wait until a graphics being created by the current warm-up, if any, is ready.
+static void _warmup_wait_graphics(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    ASSERT(canvas != NULL);
+    DvzGraphicsWarmup* warmup = &canvas->warmup;
+    if (warmup->thread_count == 0)
+        return;
+    for (uint32_t i = 0; i < warmup->count; i++)
+    {
+        if (warmup->graphics[i] != graphics)
+            continue;
+        pthread_mutex_lock(&warmup->lock);
+        while (!warmup->done[i])
+            pthread_cond_wait(&warmup->cond, &warmup->lock);
+        pthread_mutex_unlock(&warmup->lock);
+        return;
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Graphics builtin API                                                                         */
+/*************************************************************************************************/
+
+DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(type != DVZ_GRAPHICS_NONE);
+    ASSERT(canvas->graphics.capacity > 0);
+
+    // Reuse the existing pipeline with the same type, flags and renderpass, if any.
+    DvzGraphicsRegistry* registry = &canvas->graphics_registry;
+    DvzGraphicsKey key = _graphics_key(canvas, type, flags);
+    DvzGraphicsEntry* entry = _registry_find(registry, &key);
+    if (entry != NULL)
+    {
+        registry->hits++;
+        entry->ref_count++;
+        // The graphics may still be being created by a background warm-up.
+        _warmup_wait_graphics(canvas, entry->graphics);
+        return entry->graphics;
+    }
+
+    // If there is none, create a new one.
+    registry->misses++;
+    log_debug("create new graphics pipeline with type %d and flags %d", type, flags);
+    entry = _graphics_builtin_alloc(canvas, &key);
+    entry->ref_count = 1;
+    DvzGraphics* graphics = entry->graphics;
+    _graphics_builtin_create(canvas, graphics);
     return graphics;
 }
 
 
 
+void dvz_graphics_release(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(graphics != NULL);
+
+    // Custom graphics are not registered and are owned by the caller.
+    if (graphics->type == DVZ_GRAPHICS_CUSTOM)
+        return;
+
+    DvzGraphicsRegistry* registry = &canvas->graphics_registry;
+    DvzGraphicsKey key = _graphics_key(canvas, graphics->type, graphics->flags);
+    DvzGraphicsEntry* entry = _registry_find(registry, &key);
+    if (entry == NULL || entry->graphics != graphics || entry->ref_count == 0)
+    {
+        log_warn("releasing a graphics pipeline that was not acquired from the registry");
+        return;
+    }
+
+    entry->ref_count--;
+    if (entry->ref_count > 0)
+        return;
+
+    // Destroy the pipeline when the last user goes. The frames in flight may still use it.
+    log_debug(
+        "destroy graphics pipeline with type %d and flags %d", graphics->type, graphics->flags);
+    _registry_remove(registry, entry);
+    dvz_gpu_wait(canvas->gpu);
+    dvz_graphics_destroy(graphics);
+}
+
+
+
+void dvz_graphics_warmup(
+    DvzCanvas* canvas, uint32_t count, DvzGraphicsSpec* specs, bool background)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(specs != NULL);
+
+    // Only one warm-up at a time.
+    dvz_graphics_warmup_wait(canvas);
+
+    // Allocate, on the main thread, the graphics that do not exist yet.
+    DvzGraphicsWarmup* warmup = &canvas->warmup;
+    warmup->graphics = (DvzGraphics**)calloc(count, sizeof(DvzGraphics*));
+    warmup->done = (bool*)calloc(count, sizeof(bool));
+    warmup->count = 0;
+    warmup->next = 0;
+    DvzGraphicsKey key = {0};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ASSERT(specs[i].type != DVZ_GRAPHICS_NONE);
+        ASSERT(specs[i].type != DVZ_GRAPHICS_CUSTOM);
+        key = _graphics_key(canvas, specs[i].type, specs[i].flags);
+        if (_registry_find(&canvas->graphics_registry, &key) != NULL)
+            continue;
+        warmup->graphics[warmup->count++] = _graphics_builtin_alloc(canvas, &key)->graphics;
+    }
+    if (warmup->count == 0)
+    {
+        FREE(warmup->graphics);
+        FREE(warmup->done);
+        return;
+    }
+    log_debug("warming up %d graphics pipeline(s)", warmup->count);
+
+    // Start the worker threads.
+    pthread_mutex_init(&warmup->lock, NULL);
+    pthread_cond_init(&warmup->cond, NULL);
+    warmup->thread_count = MIN(warmup->count, DVZ_MAX_WARMUP_THREADS);
+    for (uint32_t i = 0; i < warmup->thread_count; i++)
+        warmup->threads[i] = dvz_thread(_warmup_thread, canvas);
+
+    if (!background)
+        dvz_graphics_warmup_wait(canvas);
+}
+
+
+
+void dvz_graphics_warmup_wait(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzGraphicsWarmup* warmup = &canvas->warmup;
+    if (warmup->thread_count == 0)
+        return;
+
+    for (uint32_t i = 0; i < warmup->thread_count; i++)
+        dvz_thread_join(&warmup->threads[i]);
+    pthread_cond_destroy(&warmup->cond);
+    pthread_mutex_destroy(&warmup->lock);
+    FREE(warmup->graphics);
+    FREE(warmup->done);
+    warmup->count = 0;
+    warmup->thread_count = 0;
+}
+
+
+
 void dvz_mvp_camera(DvzViewport viewport, vec3 eye, vec3 center, vec2 near_far, DvzMVP* mvp)
 {
     vec3 up = {0, 1, 0};
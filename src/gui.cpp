@@ -200,7 +200,7 @@ static void _imgui_context(DvzCanvas* canvas)
 
     // Retrieve the pointer to the color texture.
     log_debug("creating the Dear ImGui context, with the colormap texture");
-    DvzTexture* texture = canvas->gpu->context->color_texture.texture;
+    DvzTexture* texture = dvz_context_color_texture(canvas->gpu->context);
 
     ASSERT(texture != NULL);
     ASSERT(texture->sampler != NULL);
@@ -310,7 +310,7 @@ static void _imgui_canvas_enable(DvzCanvas* canvas)
         init_info.QueueFamily = gpu->queues.queue_families[DVZ_DEFAULT_QUEUE_RENDER];
         init_info.Queue = gpu->queues.queues[DVZ_DEFAULT_QUEUE_RENDER];
         init_info.DescriptorPool = gpu->dset_pool;
-        // init_info.PipelineCache = gpu->pipeline_cache;
+        init_info.PipelineCache = gpu->pipeline_cache;
         // init_info.Allocator = gpu->allocator;
         init_info.MinImageCount = canvas->swapchain.img_count;
         init_info.ImageCount = canvas->swapchain.img_count;
@@ -484,5 +484,18 @@ void dvz_panel_destroy(DvzPanel* panel)
     {
         dvz_visual_destroy(panel->visuals[i]);
     }
+
+    // Release the MVP uniform buffer.
+    ASSERT(panel->grid != NULL);
+    DvzContext* ctx = panel->grid->canvas->gpu->context;
+    if (ctx != NULL)
+        dvz_ctx_buffers_free(ctx, &panel->br_mvp);
+
+    // Free the secondary command buffers back to their command pool.
+    // NOTE: the GPU must not execute them anymore, dvz_scene_destroy() waits for it.
+    if (panel->cmds_panel.count > 0)
+        dvz_cmd_free(&panel->cmds_panel);
+    memset(&panel->cmds_panel, 0, sizeof(DvzCommands));
+
     dvz_obj_destroyed(&panel->obj);
 }
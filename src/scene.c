@@ -33,6 +33,7 @@ DvzScene* dvz_scene(DvzCanvas* canvas, uint32_t n_rows, uint32_t n_cols)
 
     // Scene update FIFO queue.
     canvas->scene->update_fifo = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    canvas->scene->update_pool = dvz_pool(sizeof(DvzSceneUpdate), DVZ_SCENE_UPDATE_POOL_SIZE);
 
     // INIT callback
     dvz_event_callback(canvas, DVZ_EVENT_INIT, 0, DVZ_EVENT_MODE_SYNC, _scene_init, canvas->scene);
@@ -246,6 +247,9 @@ static void _add_visual(DvzPanel* panel, DvzVisual* visual)
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
         visual->clip[pidx] = DVZ_VIEWPORT_INNER;
 
+    // Use indirect draws, uploaded at every frame by the scene if they have changed.
+    _visual_draw_args_alloc(visual);
+
     // Update the panel data coords as a function of the visual's data.
     // if (panel->scene->canvas->app->is_running)
     // log_info("%d %d", visual->graphics[0]->type, visual->clip[0]);
@@ -418,6 +422,13 @@ void dvz_scene_destroy(DvzScene* scene)
     DvzGrid* grid = &scene->grid;
     ASSERT(grid != NULL);
 
+    // Stop the recording threads.
+    _recorder_stop(&scene->recorder);
+
+    // The panel command buffers are freed below, and may still be executed by the GPU.
+    ASSERT(scene->canvas != NULL);
+    dvz_app_wait(scene->canvas->app);
+
     // Destroy all panels.
     DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
     DvzPanel* panel = NULL;
@@ -436,6 +447,7 @@ void dvz_scene_destroy(DvzScene* scene)
     dvz_container_destroy(&scene->controllers);
 
     dvz_fifo_destroy(&scene->update_fifo);
+    dvz_pool_destroy(&scene->update_pool);
 
     CONTAINER_DESTROY_ITEMS(DvzVisual, scene->visuals, dvz_visual_destroy)
     dvz_container_destroy(&scene->visuals);
@@ -443,3 +455,33 @@ void dvz_scene_destroy(DvzScene* scene)
     dvz_obj_destroyed(&scene->obj);
     FREE(scene);
 }
+
+
+
+void dvz_scene_record_threads(DvzScene* scene, uint32_t thread_count)
+{
+    ASSERT(scene != NULL);
+    ASSERT(thread_count <= DVZ_MAX_RECORD_THREADS);
+    DvzCanvas* canvas = scene->canvas;
+    ASSERT(canvas != NULL);
+
+    thread_count = MIN(thread_count, DVZ_MAX_RECORD_THREADS);
+    if (thread_count == scene->recorder.thread_count)
+        return;
+    log_debug("record the panel command buffers with %d thread(s)", thread_count);
+
+    // The panel command buffers must be allocated again from the command pools of the new
+    // threads, which requires them not to be in use.
+    dvz_app_wait(canvas->app);
+    _recorder_stop(&scene->recorder);
+
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    while (iter.item != NULL)
+    {
+        _panel_cmds_free((DvzPanel*)iter.item);
+        dvz_container_iter(&iter);
+    }
+
+    _recorder_start(scene, thread_count);
+    dvz_canvas_to_refill(canvas);
+}
@@ -2,6 +2,7 @@
 #define DVZ_SCENE_UTILS_HEADER
 
 #include "../include/datoviz/scene.h"
+#include "transforms_utils.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +50,9 @@ static bool _has_item_count_changed(DvzVisual* visual)
         source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, pidx);
         if (source != NULL && source->arr.item_count != visual->prev_index_count[pidx])
         {
+            // Switching between indexed and non-indexed draws requires a refill.
+            if ((source->arr.item_count == 0) != (visual->prev_index_count[pidx] == 0))
+                visual->draw_layout_changed = true;
             // log_debug("automatic detection of a change in index count, will trigger full
             // refill");
             has_changed = true;
@@ -60,6 +64,19 @@ static bool _has_item_count_changed(DvzVisual* visual)
 
 
 
+// Streamed visuals: the draw ranges depend on the head of the ring buffers, which moves without
+// any change in the number of items once the ring buffers are full.
+static bool _has_stream_head_changed(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->stream_head == visual->prev_stream_head)
+        return false;
+    visual->prev_stream_head = visual->stream_head;
+    return true;
+}
+
+
+
 static inline bool _has_obj_changed(DvzObject* obj)
 {
     ASSERT(obj != NULL);
@@ -159,6 +176,25 @@ static void _transform_pos_prop(DvzDataCoords coords, DvzProp* prop)
         return;
     }
 
+    // Only transform the modified items if the transformed array is up to date otherwise.
+    DvzDirtyRanges* dirty = &prop->dirty;
+    if (!dirty->all && dirty->count > 0 && arr_tr->item_count == arr->item_count &&
+        arr_tr->dtype == arr->dtype)
+    {
+        log_trace("normalizing %d modified ranges of POS prop", dirty->count);
+        DvzArray in = {0}, out = {0};
+        uint32_t first = 0, count = 0;
+        for (uint32_t i = 0; i < dirty->count; i++)
+        {
+            first = dirty->first[i];
+            count = MIN(dirty->last[i], arr->item_count) - first;
+            in = dvz_array_wrap(count, arr->dtype, dvz_array_item(arr, first));
+            out = dvz_array_wrap(count, arr_tr->dtype, dvz_array_item(arr_tr, first));
+            dvz_transform_pos(coords, &in, &out, false);
+        }
+        return;
+    }
+
     // Create the transformed prop array.
     log_trace("normalizing POS prop, %d items", arr->item_count);
     // _box_print(coords.box);
@@ -234,7 +270,14 @@ static void _init_item_count_change_detection(DvzVisual* visual)
 // Update the GPU viewport struct of a visual.
 static void _update_visual_viewport(DvzPanel* panel, DvzVisual* visual)
 {
+    // Keep the ring buffer position of streamed visuals.
+    uint32_t ring_base = visual->viewport.ring_base;
+    uint32_t ring_size = visual->viewport.ring_size;
     visual->viewport = panel->viewport;
+    visual->viewport.ring_base = ring_base;
+    visual->viewport.ring_size = ring_size;
+    visual->viewport.data_norm =
+        _is_data_gpu(&panel->data_coords) && _is_visual_to_transform(visual) ? 1 : 0;
     log_trace("update visual viewport");
     // Each graphics pipeline in the visual has its own transform/clip viewport options
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
@@ -296,9 +339,12 @@ static void _scene_update_enqueue(DvzScene* scene, DvzSceneUpdate update)
     ASSERT(scene != NULL);
     DvzFifo* fifo = &scene->update_fifo;
     ASSERT(fifo != NULL);
-    DvzSceneUpdate* up = (DvzSceneUpdate*)calloc(1, sizeof(DvzSceneUpdate));
+    DvzSceneUpdate* up = (DvzSceneUpdate*)dvz_pool_alloc(&scene->update_pool);
     *up = update;
     dvz_fifo_enqueue(fifo, up);
+    // The scene update will be processed at the next frame.
+    ASSERT(scene->canvas != NULL);
+    dvz_canvas_dirty(scene->canvas);
 }
 
 
@@ -382,6 +428,25 @@ static void _enqueue_item_count_changed(DvzPanel* panel, DvzVisual* visual)
 
 
 
+static void _enqueue_stream_changed(DvzPanel* panel, DvzVisual* visual)
+{
+    log_trace("enqueue stream changed");
+    ASSERT(panel != NULL);
+    DvzScene* scene = panel->scene;
+    ASSERT(scene != NULL);
+    ASSERT(visual != NULL);
+
+    DvzSceneUpdate up = {0};
+    up.type = DVZ_SCENE_UPDATE_STREAM_CHANGED;
+    up.scene = scene;
+    up.canvas = scene->canvas;
+    up.panel = panel;
+    up.visual = visual;
+    _scene_update_enqueue(scene, up);
+}
+
+
+
 static void _enqueue_panel_changed(DvzPanel* panel)
 {
     log_trace("enqueue panel changed");
@@ -488,8 +553,15 @@ static void _process_coords_changed(DvzSceneUpdate up)
     DvzProp* prop = NULL;
     DvzContainerIterator iter;
 
+    // With GPU normalization, the new box only goes to the MVP uniform at the next frame, the
+    // positions are uploaded again only if the data origin has to move.
+    bool renormalize =
+        !_is_data_gpu(&panel->data_coords) || _data_origin_update(&panel->data_coords);
+    if (!renormalize)
+        log_trace("skip POS props renormalization with GPU data normalization");
+
     // Go through all visuals in the panel.
-    for (uint32_t i = 0; i < panel->visual_count; i++)
+    for (uint32_t i = 0; i < panel->visual_count && renormalize; i++)
     {
         visual = panel->visuals[i];
         ASSERT(visual != NULL);
@@ -511,6 +583,7 @@ static void _process_coords_changed(DvzSceneUpdate up)
             // Transform all POS props with the panel data coordinates.
             if (prop->prop_type == DVZ_PROP_POS)
             {
+                _dirty_all(&prop->dirty);
                 _enqueue_prop_changed(panel, visual, prop);
             }
 
@@ -585,12 +658,19 @@ static void _process_visual_changed(DvzSceneUpdate up)
     // Visual data GPU upload.
     dvz_visual_update(visual, panel->viewport, panel->data_coords, NULL);
 
-    // Detect whether the number of vertices/indices has changed, in which case a command buffer
-    // refill will be needed.
-    if (_has_item_count_changed(visual))
+    // Detect whether the number of vertices/indices, or the head of the ring buffers of a
+    // streamed visual, has changed, in which case the draw arguments, or the command buffers,
+    // need to be updated.
+    bool count_changed = _has_item_count_changed(visual);
+    bool head_changed = _has_stream_head_changed(visual);
+    if (count_changed || visual->draw_layout_changed)
     {
         _enqueue_item_count_changed(panel, visual);
     }
+    else if (head_changed)
+    {
+        _enqueue_stream_changed(panel, visual);
+    }
 
     // TODO: recompute the bounding box when changing the data?
     // // If the panel box has changed, renormalize all visuals.
@@ -603,12 +683,51 @@ static void _process_visual_changed(DvzSceneUpdate up)
 
 
 
+// Invalidate the cached command buffers of a panel, or of all panels if the panel is NULL, and
+// refill the canvas command buffers.
+static void _panel_to_refill(DvzCanvas* canvas, DvzPanel* panel)
+{
+    ASSERT(canvas != NULL);
+    if (panel == NULL)
+    {
+        dvz_canvas_to_refill(canvas);
+        return;
+    }
+    memset(panel->cmds_valid, 0, sizeof(panel->cmds_valid));
+    dvz_canvas_to_refill_partial(canvas);
+}
+
+
+
+// Update the draw arguments of a visual, and refill the command buffers only if the draw
+// commands cannot read the new arguments from the indirect draw buffer.
+static void _visual_draws_changed(DvzCanvas* canvas, DvzPanel* panel, DvzVisual* visual)
+{
+    ASSERT(canvas != NULL);
+    if (visual == NULL)
+    {
+        _panel_to_refill(canvas, panel);
+        return;
+    }
+
+    _visual_draw_args(visual);
+    if (_visual_is_indirect(visual) && !visual->draw_layout_changed)
+    {
+        // The new draw arguments are uploaded by _upload_draw_args() at the next frames.
+        dvz_canvas_dirty(canvas);
+        return;
+    }
+    visual->draw_layout_changed = false;
+    _panel_to_refill(canvas, panel);
+}
+
+
+
 // Called when the visibility of a visual has changed.
 static void _process_visibility_changed(DvzSceneUpdate up)
 {
     ASSERT(up.canvas != NULL);
-    // Refill command buffer.
-    dvz_canvas_to_refill(up.canvas);
+    _visual_draws_changed(up.canvas, up.panel, up.visual);
 }
 
 
@@ -617,8 +736,16 @@ static void _process_visibility_changed(DvzSceneUpdate up)
 static void _process_item_count_changed(DvzSceneUpdate up)
 {
     ASSERT(up.canvas != NULL);
-    // Refill command buffer.
-    dvz_canvas_to_refill(up.canvas);
+    _visual_draws_changed(up.canvas, up.panel, up.visual);
+}
+
+
+
+// Called when the head of the ring buffers of a streamed visual has moved.
+static void _process_stream_changed(DvzSceneUpdate up)
+{
+    ASSERT(up.canvas != NULL);
+    _visual_draws_changed(up.canvas, up.panel, up.visual);
 }
 
 
@@ -643,7 +770,7 @@ static void _process_panel_changed(DvzSceneUpdate up)
 
     // Refill command buffer.
     ASSERT(up.canvas != NULL);
-    dvz_canvas_to_refill(up.canvas);
+    _panel_to_refill(up.canvas, panel);
 }
 
 
@@ -718,6 +845,10 @@ static void _process_scene_update(DvzSceneUpdate up)
         _process_coords_changed(up);
         break;
 
+    case DVZ_SCENE_UPDATE_STREAM_CHANGED:
+        _process_stream_changed(up);
+        break;
+
         // case DVZ_SCENE_UPDATE_CANVAS_RESIZED:
         //     _process_canvas_resized(up);
         //     break;
@@ -840,7 +971,7 @@ static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
         return out;
     ASSERT(item != NULL);
     out = *item;
-    FREE(item);
+    dvz_pool_free(&scene->update_pool, item);
     return out;
 }
 
@@ -879,6 +1010,222 @@ static void _process_scene_updates(DvzScene* scene)
 
 
 
+/*************************************************************************************************/
+/*  Panel recording                                                                              */
+/*************************************************************************************************/
+
+// Record the visuals of a panel into its secondary command buffer for a given swapchain image.
+static void _panel_fill(DvzCanvas* canvas, DvzPanel* panel, DvzEvent ev, uint32_t img_idx)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(panel != NULL);
+
+    DvzCommands* cmds = &panel->cmds_panel;
+    DvzViewport viewport = dvz_panel_viewport(panel);
+    DvzVisual* visual = NULL;
+
+    log_trace("record panel secondary command buffer %d", img_idx);
+    dvz_cmd_begin_secondary(cmds, img_idx, &canvas->renderpass);
+
+    // The dynamic viewport is not inherited from the primary command buffer.
+    dvz_cmd_viewport(cmds, img_idx, viewport.viewport);
+
+    // Go through all visuals in the panel.
+    for (int priority = -panel->prority_max; priority <= panel->prority_max; priority++)
+    {
+        for (uint32_t k = 0; k < panel->visual_count; k++)
+        {
+            visual = panel->visuals[k];
+            if (visual->priority != priority)
+                continue;
+
+            dvz_visual_fill_event(visual, ev.u.rf.clear_color, cmds, img_idx, viewport, NULL);
+        }
+    }
+
+    dvz_cmd_end(cmds, img_idx);
+    panel->cmds_valid[img_idx] = true;
+    panel->cmds_recorded++;
+}
+
+
+
+// Free the secondary command buffers of a panel.
+static void _panel_cmds_free(DvzPanel* panel)
+{
+    ASSERT(panel != NULL);
+    if (panel->cmds_panel.count > 0)
+        dvz_cmd_free(&panel->cmds_panel);
+    memset(&panel->cmds_panel, 0, sizeof(DvzCommands));
+    memset(panel->cmds_valid, 0, sizeof(panel->cmds_valid));
+}
+
+
+
+// Make sure the panel secondary command buffers match the primary command buffers, and are
+// allocated from the command pool of the thread recording them (UINT32_MAX for the main thread).
+static void _panel_cmds_alloc(DvzPanel* panel, DvzCommands* cmds, uint32_t thread_idx)
+{
+    ASSERT(panel != NULL);
+    ASSERT(cmds != NULL);
+    if (panel->cmds_panel.count == cmds->count && panel->cmds_thread == thread_idx)
+        return;
+
+    _panel_cmds_free(panel);
+    DvzGpu* gpu = cmds->gpu;
+    panel->cmds_panel =
+        thread_idx == UINT32_MAX
+            ? dvz_commands_secondary(gpu, cmds->queue_idx, cmds->count)
+            : dvz_commands_thread(gpu, cmds->queue_idx, cmds->count, thread_idx);
+    panel->cmds_thread = thread_idx;
+}
+
+
+
+// Recording thread of a panel (UINT32_MAX for the main thread). A panel keeps the thread it was
+// first assigned to, so that adding or removing panels never frees the command buffers of the
+// other panels while the GPU may still execute them. The new panels take the threads in turn.
+static uint32_t _panel_thread(DvzSceneRecorder* recorder, DvzPanel* panel)
+{
+    ASSERT(recorder != NULL);
+    ASSERT(panel != NULL);
+    uint32_t n = recorder->thread_count;
+    if (n == 0)
+        return UINT32_MAX;
+    if (panel->cmds_panel.count > 0 && panel->cmds_thread < n)
+        return panel->cmds_thread;
+    return recorder->next_thread++ % n;
+}
+
+
+
+// Record the invalidated panels assigned to a given recording thread.
+static void
+_panels_record(DvzCanvas* canvas, DvzGrid* grid, DvzEvent ev, uint32_t thread_idx, uint32_t n)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(grid != NULL);
+
+    uint32_t img_idx = ev.u.rf.img_idx;
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        if ((n == 0 || panel->cmds_thread == thread_idx) && !panel->cmds_valid[img_idx])
+            _panel_fill(canvas, panel, ev, img_idx);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Recording threads                                                                            */
+/*************************************************************************************************/
+
+static void* _recorder_thread(void* user_data)
+{
+    DvzSceneWorker* worker = (DvzSceneWorker*)user_data;
+    ASSERT(worker != NULL);
+    DvzScene* scene = worker->scene;
+    ASSERT(scene != NULL);
+    DvzSceneRecorder* recorder = &scene->recorder;
+
+    uint64_t job = 0;
+    pthread_mutex_lock(&recorder->lock);
+    while (true)
+    {
+        while (!recorder->stop && recorder->job == job)
+            pthread_cond_wait(&recorder->cond_start, &recorder->lock);
+        if (recorder->stop)
+            break;
+        job = recorder->job;
+        pthread_mutex_unlock(&recorder->lock);
+
+        // Record the panels assigned to this worker, with its own command pool.
+        _panels_record(
+            recorder->canvas, &scene->grid, recorder->ev, worker->idx, recorder->thread_count);
+
+        pthread_mutex_lock(&recorder->lock);
+        ASSERT(recorder->pending > 0);
+        if (--recorder->pending == 0)
+            pthread_cond_signal(&recorder->cond_done);
+    }
+    pthread_mutex_unlock(&recorder->lock);
+    return NULL;
+}
+
+
+
+static void _recorder_start(DvzScene* scene, uint32_t thread_count)
+{
+    ASSERT(scene != NULL);
+    ASSERT(thread_count <= DVZ_MAX_RECORD_THREADS);
+    DvzSceneRecorder* recorder = &scene->recorder;
+    ASSERT(recorder->thread_count == 0);
+    if (thread_count == 0)
+        return;
+
+    pthread_mutex_init(&recorder->lock, NULL);
+    pthread_cond_init(&recorder->cond_start, NULL);
+    pthread_cond_init(&recorder->cond_done, NULL);
+    recorder->job = 0;
+    recorder->pending = 0;
+    recorder->stop = false;
+    recorder->next_thread = 0;
+    recorder->thread_count = thread_count;
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        recorder->workers[i].scene = scene;
+        recorder->workers[i].idx = i;
+        recorder->threads[i] = dvz_thread(_recorder_thread, &recorder->workers[i]);
+    }
+}
+
+
+
+// Record the invalidated panels on the worker threads, and wait until they are done.
+static void _recorder_run(DvzScene* scene, DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(scene != NULL);
+    DvzSceneRecorder* recorder = &scene->recorder;
+    ASSERT(recorder->thread_count > 0);
+
+    pthread_mutex_lock(&recorder->lock);
+    recorder->canvas = canvas;
+    recorder->ev = ev;
+    recorder->pending = recorder->thread_count;
+    recorder->job++;
+    pthread_cond_broadcast(&recorder->cond_start);
+    while (recorder->pending > 0)
+        pthread_cond_wait(&recorder->cond_done, &recorder->lock);
+    pthread_mutex_unlock(&recorder->lock);
+}
+
+
+
+static void _recorder_stop(DvzSceneRecorder* recorder)
+{
+    ASSERT(recorder != NULL);
+    if (recorder->thread_count == 0)
+        return;
+
+    pthread_mutex_lock(&recorder->lock);
+    recorder->stop = true;
+    pthread_cond_broadcast(&recorder->cond_start);
+    pthread_mutex_unlock(&recorder->lock);
+
+    for (uint32_t i = 0; i < recorder->thread_count; i++)
+        dvz_thread_join(&recorder->threads[i]);
+    pthread_cond_destroy(&recorder->cond_start);
+    pthread_cond_destroy(&recorder->cond_done);
+    pthread_mutex_destroy(&recorder->lock);
+    recorder->thread_count = 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene callbacks                                                                              */
 /*************************************************************************************************/
@@ -919,6 +1266,9 @@ static void _scene_init(DvzCanvas* canvas, DvzEvent ev)
 
 
 // Refill the command buffer with all panels and visuals.
+// Each panel is recorded in its own secondary command buffer, executed by the primary command
+// buffer. A partial refill only records again the panels that have been invalidated. The panels
+// may be recorded by worker threads, but they are always executed in the same order.
 // NOTE: the panel viewports must have been updated first.
 static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
 {
@@ -928,50 +1278,57 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
     DvzScene* scene = (DvzScene*)ev.user_data;
     ASSERT(scene != NULL);
     DvzGrid* grid = &scene->grid;
+    ASSERT(ev.u.rf.cmd_count > 0);
 
-    DvzViewport viewport = {0};
-    DvzCommands* cmds = NULL;
+    DvzCommands* cmds = ev.u.rf.cmds[0];
     DvzPanel* panel = NULL;
     DvzContainerIterator iter;
-    DvzVisual* visual = NULL;
-    uint32_t img_idx = 0;
+    uint32_t img_idx = ev.u.rf.img_idx;
+    uint32_t n = scene->recorder.thread_count;
+    uint32_t to_record = 0;
+
+    // Allocate the panel secondary command buffers lazily, one per swapchain image, and find the
+    // panels to record again.
+    iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        _panel_cmds_alloc(panel, cmds, _panel_thread(&scene->recorder, panel));
+        if (ev.u.rf.full)
+            panel->cmds_valid[img_idx] = false;
+        if (!panel->cmds_valid[img_idx])
+            to_record++;
+        dvz_container_iter(&iter);
+    }
+
+    // Record the invalidated panels, on the worker threads if there are several of them.
+    if (n > 0 && to_record > 1)
+        _recorder_run(scene, canvas, ev);
+    else if (to_record > 0)
+        _panels_record(canvas, grid, ev, 0, 0);
 
     // Go through all the current command buffers.
     for (uint32_t i = 0; i < ev.u.rf.cmd_count; i++)
     {
         cmds = ev.u.rf.cmds[i];
-        img_idx = ev.u.rf.img_idx;
 
         log_trace("visual fill cmd %d begin %d", i, img_idx);
-        dvz_visual_fill_begin(canvas, cmds, img_idx);
+        dvz_cmd_begin(cmds, img_idx);
+        dvz_cmd_begin_renderpass_secondary(
+            cmds, img_idx, &canvas->renderpass, &canvas->framebuffers);
 
+        // Execute the panel command buffers in the panel order.
         iter = dvz_container_iterator(&grid->panels);
         while (iter.item != NULL)
         {
             panel = iter.item;
-
-            // Find the panel viewport.
-            viewport = dvz_panel_viewport(panel);
-            dvz_cmd_viewport(cmds, img_idx, viewport.viewport);
-
-            // Go through all visuals in the panel.
-            visual = NULL;
-            for (int priority = -panel->prority_max; priority <= panel->prority_max; priority++)
-            {
-                for (uint32_t k = 0; k < panel->visual_count; k++)
-                {
-                    visual = panel->visuals[k];
-                    if (visual->priority != priority)
-                        continue;
-
-                    dvz_visual_fill_event(
-                        visual, ev.u.rf.clear_color, cmds, img_idx, viewport, NULL);
-                }
-            }
-
+            ASSERT(panel->cmds_valid[img_idx]);
+            dvz_cmd_execute(cmds, img_idx, &panel->cmds_panel);
             dvz_container_iter(&iter);
         }
-        dvz_visual_fill_end(canvas, cmds, img_idx);
+
+        dvz_cmd_end_renderpass(cmds, img_idx);
+        dvz_cmd_end(cmds, img_idx);
     }
 }
 
@@ -998,12 +1355,34 @@ static void _scene_resize(DvzCanvas* canvas, DvzEvent ev)
         ASSERT(panel != NULL);
         up.panel = panel;
         _process_panel_changed(up);
+        // Upload the MVPs again after the swapchain recreation.
+        panel->mvp_valid = 0;
         dvz_container_iter(&iter);
     }
 }
 
 
 
+// Upload the changed draw arguments of all visuals to the current swapchain image.
+// NOTE: the command buffers of the current image are not in use, and every swapchain image
+// receives the new arguments at the next frame it is rendered.
+static void _upload_draw_args(DvzCanvas* canvas, DvzScene* scene)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(scene != NULL);
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    for (; iter.item != NULL; dvz_container_iter(&iter))
+    {
+        panel = iter.item;
+        for (uint32_t k = 0; k < panel->visual_count; k++)
+            _visual_draw_args_upload(panel->visuals[k], img_idx);
+    }
+}
+
+
+
 // Called at every frame, this important function checks if there are any scene updates, and
 // processes them if so. It also calls the controller callbacks for every panel.
 static void _scene_frame(DvzCanvas* canvas, DvzEvent ev)
@@ -1019,6 +1398,28 @@ static void _scene_frame(DvzCanvas* canvas, DvzEvent ev)
 
     // Process the scene updates.
     _process_scene_updates(scene);
+
+    // Upload the draw arguments that have changed, once the updates have been processed.
+    _upload_draw_args(canvas, scene);
+}
+
+
+
+// Whether the MVP of a panel needs to be uploaded to the current swapchain image.
+static bool _mvp_changed(DvzCanvas* canvas, DvzPanel* panel, DvzMVP* mvp, uint32_t img_idx)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(panel != NULL);
+    ASSERT(mvp != NULL);
+    ASSERT(img_idx < DVZ_MAX_SWAPCHAIN_IMAGES);
+    if ((panel->mvp_valid & (1u << img_idx)) == 0)
+        return true;
+    DvzMVP tmp = *mvp;
+    // NOTE: in on-demand mode, the time alone does not trigger an upload, so that a static scene
+    // does not upload anything. Otherwise, the shaders may animate with MVP.time.
+    if (canvas->on_demand)
+        tmp.time = panel->mvp_uploaded[img_idx].time;
+    return memcmp(&tmp, &panel->mvp_uploaded[img_idx], sizeof(DvzMVP)) != 0;
 }
 
 
@@ -1035,11 +1436,12 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
 
     DvzInteract* interact = NULL;
     DvzController* controller = NULL;
+    uint32_t img_idx = canvas->swapchain.img_idx;
 
     // Go through all panels that need to be updated.
     DvzPanel* panel = NULL;
     DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
-    while (iter.item != NULL)
+    for (; iter.item != NULL; dvz_container_iter(&iter))
     {
         panel = iter.item;
         if (panel->controller == NULL)
@@ -1057,10 +1459,19 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
             // NOTE: update MVP.time here.
             interact->mvp.time = canvas->clock.elapsed;
 
-            // IMPORTANT: we **must** update the uniform buffer at every frame.
+            // Box to NDC normalization done in the vertex shader.
+            if (_is_data_gpu(&panel->data_coords))
+                _data_gpu_affine(
+                    &panel->data_coords, interact->mvp.data_scale, interact->mvp.data_shift);
+
+            // NOTE: every swapchain image has its own copy of the uniform buffer, which only
+            // needs to be updated when the interact state has changed since its last upload.
+            if (!_mvp_changed(canvas, panel, &interact->mvp, img_idx))
+                continue;
             dvz_canvas_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, &interact->mvp);
+            panel->mvp_uploaded[img_idx] = interact->mvp;
+            panel->mvp_valid |= 1u << img_idx;
         }
-        dvz_container_iter(&iter);
     }
 }
 
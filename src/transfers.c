@@ -10,19 +10,32 @@
 /*  FIFO                                                                                         */
 /*************************************************************************************************/
 
-static void _transfer_enqueue(DvzFifo* fifo, DvzTransfer transfer)
+static uint64_t _transfer_enqueue(DvzContext* context, DvzTransfer transfer)
 {
+    ASSERT(context != NULL);
+    DvzFifo* fifo = &context->transfers;
     ASSERT(fifo->capacity > 0);
     ASSERT(0 <= fifo->tail && fifo->tail < fifo->capacity);
-    DvzTransfer* tr = (DvzTransfer*)calloc(1, sizeof(DvzTransfer));
+    DvzTransfer* tr = (DvzTransfer*)dvz_pool_alloc(&context->transfer_pool);
     *tr = transfer;
+
+    // The tickets must be enqueued in increasing order.
+    DvzTransferBatch* batch = &context->batch;
+    pthread_mutex_lock(&batch->lock);
+    uint64_t ticket = ++batch->ticket;
+    tr->ticket = ticket;
     dvz_fifo_enqueue(fifo, tr);
+    pthread_mutex_unlock(&batch->lock);
+
+    return ticket;
 }
 
 
 
-static DvzTransfer _transfer_dequeue(DvzFifo* fifo, bool wait)
+static DvzTransfer _transfer_dequeue(DvzContext* context, bool wait)
 {
+    ASSERT(context != NULL);
+    DvzFifo* fifo = &context->transfers;
     DvzTransfer* item = (DvzTransfer*)dvz_fifo_dequeue(fifo, wait);
     DvzTransfer out;
     out.type = DVZ_TRANSFER_NONE;
@@ -30,12 +43,187 @@ static DvzTransfer _transfer_dequeue(DvzFifo* fifo, bool wait)
         return out;
     ASSERT(item != NULL);
     out = *item;
-    FREE(item);
+    dvz_pool_free(&context->transfer_pool, item);
     return out;
 }
 
 
 
+/*************************************************************************************************/
+/*  Transfer batch                                                                               */
+/*************************************************************************************************/
+
+static void _batch_begin(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    DvzTransferBatch* batch = &context->batch;
+    if (batch->is_recording)
+        return;
+
+    // The slot of the new batch may still be used by the oldest in-flight batch.
+    uint32_t cur = batch->cur;
+    _transfer_slot_complete(context, cur, true);
+
+    dvz_cmd_reset(&batch->cmds, cur);
+    dvz_cmd_begin(&batch->cmds, cur);
+    batch->is_recording = true;
+    batch->transfer_count = 0;
+
+    // NOTE: the staging ring is shared with _transfer_slot_complete(), which may run on another
+    // thread with dvz_transfer_done(), so it is only accessed with the batch lock.
+    pthread_mutex_lock(&batch->lock);
+    batch->ring_end[cur] = batch->ring.head;
+    batch->ring_used[cur] = 0;
+    pthread_mutex_unlock(&batch->lock);
+}
+
+
+
+static void _batch_barrier(
+    DvzTransferBatch* batch, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    ASSERT(batch != NULL);
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(
+        batch->cmds.cmds[batch->cur], VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 1, &barrier,
+        0, NULL, 0, NULL);
+}
+
+
+
+// Called before recording a new copy command in the batch.
+static void _batch_next(DvzTransferBatch* batch)
+{
+    ASSERT(batch != NULL);
+    ASSERT(batch->is_recording);
+
+    // Successive transfers may touch the same buffer regions, and they must be executed in order.
+    if (batch->transfer_count > 0)
+        _batch_barrier(
+            batch, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    batch->transfer_count++;
+}
+
+
+
+static void _batch_submit(DvzContext* context, bool wait)
+{
+    ASSERT(context != NULL);
+    DvzTransferBatch* batch = &context->batch;
+    uint32_t cur = batch->cur;
+
+    if (batch->is_recording)
+    {
+        // Make the downloaded data visible to the CPU.
+        if (batch->download_count[cur] > 0)
+            _batch_barrier(batch, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+        dvz_cmd_end(&batch->cmds, cur);
+        batch->is_recording = false;
+
+        DvzSubmit submit = dvz_submit(context->gpu);
+        dvz_submit_commands(&submit, &batch->cmds);
+
+        // The batch waits on the last frame of every canvas, as the buffers to update may be used
+        // by the frames in flight. The next frame of every canvas waits on the batch, rather than
+        // the CPU waiting here.
+        DvzContainerIterator iterator = dvz_container_iterator(&context->gpu->app->canvases);
+        DvzCanvas* canvas = NULL;
+        while (iterator.item != NULL)
+        {
+            canvas = (DvzCanvas*)iterator.item;
+            if (canvas->gpu == context->gpu && dvz_obj_is_created(&canvas->obj))
+            {
+                dvz_transfer_sync_wait(
+                    &canvas->sync_frame, &submit, VK_PIPELINE_STAGE_TRANSFER_BIT);
+                if (!wait)
+                    dvz_transfer_sync_signal(&canvas->sync_transfer, &submit);
+            }
+            dvz_container_iter(&iterator);
+        }
+
+        log_debug(
+            "submit %d transfer(s) using %s of staging buffer", batch->transfer_count,
+            pretty_size(batch->ring_used[cur]));
+        dvz_fences_reset(&batch->fences, cur);
+        dvz_submit_send(&submit, cur, &batch->fences, cur);
+        pthread_mutex_lock(&batch->lock);
+        batch->in_flight[cur] = true;
+        batch->ticket_flight[cur] = batch->ticket_batch;
+        batch->cur = (cur + 1) % DVZ_TRANSFER_BATCH_COUNT;
+        pthread_mutex_unlock(&batch->lock);
+    }
+
+    if (wait)
+        _transfer_batch_complete(context, true);
+}
+
+
+
+// Allocate a region of the staging ring for the batch being recorded, and return its offset.
+// When the ring is full, the batch is submitted, and the CPU waits for the oldest batch to release
+// its staging regions, so that large transfers are streamed through the ring.
+static VkDeviceSize
+_batch_staging(DvzContext* context, VkDeviceSize size, bool download, DvzBuffer** staging)
+{
+    ASSERT(context != NULL);
+    ASSERT(staging != NULL);
+    ASSERT(size <= DVZ_TRANSFER_CHUNK_SIZE);
+    DvzTransferBatch* batch = &context->batch;
+
+    *staging = _ctx_default_buffer(context, DVZ_BUFFER_TYPE_STAGING);
+    ASSERT(*staging != NULL);
+    ASSERT((*staging)->size == batch->ring.size);
+
+    if (download && batch->is_recording &&
+        batch->download_count[batch->cur] >= DVZ_MAX_TRANSFER_DOWNLOADS)
+        _batch_submit(context, false);
+
+    VkDeviceSize offset = 0;
+    uint32_t slot = 0;
+    bool allocated = false;
+    while (true)
+    {
+        _batch_begin(context);
+
+        pthread_mutex_lock(&batch->lock);
+        VkDeviceSize used = batch->ring.used;
+        allocated = _staging_ring_alloc(&batch->ring, size, &offset);
+        if (allocated)
+        {
+            batch->ring_end[batch->cur] = batch->ring.head;
+            batch->ring_used[batch->cur] += batch->ring.used - used;
+        }
+        pthread_mutex_unlock(&batch->lock);
+        if (allocated)
+            break;
+
+        // The regions of a batch are only released once it has completed.
+        if (batch->transfer_count > 0)
+        {
+            _batch_submit(context, false);
+            continue;
+        }
+
+        // Wait for the oldest in-flight batch, if it has not completed in the meantime.
+        pthread_mutex_lock(&batch->lock);
+        for (uint32_t i = 1; i < DVZ_TRANSFER_BATCH_COUNT; i++)
+        {
+            slot = (batch->cur + i) % DVZ_TRANSFER_BATCH_COUNT;
+            if (batch->in_flight[slot])
+                break;
+        }
+        pthread_mutex_unlock(&batch->lock);
+        _transfer_slot_complete(context, slot, true);
+    }
+    return offset;
+}
+
+
+
 /*************************************************************************************************/
 /*  Buffer transfers                                                                             */
 /*************************************************************************************************/
@@ -55,20 +243,27 @@ static void _process_buffer_upload(DvzContext* context, DvzTransfer tr)
     ASSERT(tr.u.buf.regions.buffer != VK_NULL_HANDLE);
     ASSERT(
         br.buffer->type != DVZ_BUFFER_TYPE_STAGING &&
-        br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
-
-    // Take the staging buffer and ensure it is big enough.
-    DvzBuffer* staging = staging_buffer(context, tr.u.buf.size);
-
-    // Memcpy into the staging buffer.
-    dvz_buffer_upload(staging, 0, tr.u.buf.size, tr.u.buf.data);
+        br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE &&
+        br.buffer->type != DVZ_BUFFER_TYPE_INDIRECT);
+
+    // Upload the data in chunks, through the staging ring.
+    DvzTransferBatch* batch = &context->batch;
+    DvzBuffer* staging = NULL;
+    VkDeviceSize offset = 0, chunk = 0;
+    for (VkDeviceSize pos = 0; pos < tr.u.buf.size; pos += chunk)
+    {
+        chunk = MIN(DVZ_TRANSFER_CHUNK_SIZE, tr.u.buf.size - pos);
+        offset = _batch_staging(context, chunk, false, &staging);
 
-    // Copy from the staging buffer to the target buffer.
-    _copy_buffer_from_staging(context, tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
+        // Memcpy into the staging buffer.
+        dvz_buffer_upload(staging, offset, chunk, (const uint8_t*)tr.u.buf.data + pos);
 
-    // IMPORTANT: need to wait for the texture to be copied to the staging buffer, *before*
-    // downloading the data from the staging buffer.
-    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+        // Record the copy from the staging buffer to the target buffer.
+        _batch_next(batch);
+        dvz_cmd_copy_buffer(
+            &batch->cmds, batch->cur, staging, offset, br.buffer,
+            br.offsets[0] + tr.u.buf.offset + pos, chunk);
+    }
 }
 
 
@@ -86,20 +281,32 @@ static void _process_buffer_download(DvzContext* context, DvzTransfer tr)
     ASSERT(tr.u.buf.regions.buffer != VK_NULL_HANDLE);
     ASSERT(
         br.buffer->type != DVZ_BUFFER_TYPE_STAGING &&
-        br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
-
-    // Take the staging buffer and ensure it is big enough.
-    DvzBuffer* staging = staging_buffer(context, tr.u.buf.size);
-
-    // Copy from the source buffer to the staging buffer.
-    _copy_buffer_to_staging(context, tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
-
-    // IMPORTANT: need to wait for the texture to be copied to the staging buffer, *before*
-    // downloading the data from the staging buffer.
-    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
-
-    // Memcpy into the staging buffer.
-    dvz_buffer_download(staging, 0, tr.u.buf.size, tr.u.buf.data);
+        br.buffer->type != DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE &&
+        br.buffer->type != DVZ_BUFFER_TYPE_INDIRECT);
+
+    // Download the data in chunks, through the staging ring.
+    DvzTransferBatch* batch = &context->batch;
+    DvzBuffer* staging = NULL;
+    DvzTransferDownload* download = NULL;
+    VkDeviceSize offset = 0, chunk = 0;
+    for (VkDeviceSize pos = 0; pos < tr.u.buf.size; pos += chunk)
+    {
+        chunk = MIN(DVZ_TRANSFER_CHUNK_SIZE, tr.u.buf.size - pos);
+        offset = _batch_staging(context, chunk, true, &staging);
+
+        // Record the copy from the source buffer to the staging buffer.
+        _batch_next(batch);
+        dvz_cmd_copy_buffer(
+            &batch->cmds, batch->cur, br.buffer, br.offsets[0] + tr.u.buf.offset + pos, staging,
+            offset, chunk);
+
+        // The memcpy from the staging buffer happens once the batch has completed.
+        ASSERT(batch->download_count[batch->cur] < DVZ_MAX_TRANSFER_DOWNLOADS);
+        download = &batch->downloads[batch->cur][batch->download_count[batch->cur]++];
+        download->staging_offset = offset;
+        download->size = chunk;
+        download->data = (uint8_t*)tr.u.buf.data + pos;
+    }
 }
 
 
@@ -117,7 +324,16 @@ static void _process_buffer_copy(DvzContext* context, DvzTransfer tr)
     VkDeviceSize src_offset = tr.u.buf_copy.src_offset;
     VkDeviceSize dst_offset = tr.u.buf_copy.dst_offset;
 
-    dvz_buffer_regions_copy(src, src_offset, dst, dst_offset, size);
+    // Record the copy of all buffer regions.
+    DvzTransferBatch* batch = &context->batch;
+    _batch_begin(context);
+    _batch_next(batch);
+    for (uint32_t i = 0; i < src->count; i++)
+    {
+        dvz_cmd_copy_buffer(
+            &batch->cmds, batch->cur, src->buffer, src->offsets[i] + src_offset, dst->buffer,
+            dst->offsets[i] + dst_offset, size);
+    }
 }
 
 
@@ -166,31 +382,31 @@ static void _process_texture_copy(DvzContext* context, DvzTransfer tr)
 
 void dvz_process_transfers(DvzContext* context)
 {
-    // WARNING: comment below OBSOLETE.
-
-    // This function is to be called at every frame, after the FRAME callbacks (so that FRAME
-    // callbacks calling dvz_upload_buffer() have their transfers processed immediately in the
-    // same frame), but before queue submit, so that we may get a chance to ask for a command
-    // buffer refill before submission (if a transfer requires a refill, e.g. after a vertex buffer
-    // count change)
+    // This function is called at every frame, after all canvases have submitted their frame. The
+    // buffer transfers are recorded into a single command buffer, submitted once to the transfer
+    // queue after the frames in flight. The next frame submissions wait for them on the GPU with
+    // semaphores, except when the transfers are synchronous (outside of the event loop, or with
+    // dvz_transfers_sync()).
 
     ASSERT(context != NULL);
     DvzGpu* gpu = context->gpu;
     ASSERT(gpu != NULL);
+    ASSERT(gpu->app != NULL);
 
     DvzFifo* fifo = &context->transfers;
     // Do nothing if there are no pending transfers.
     if (fifo->is_empty)
         return;
 
-    // NOTE: wait until all render tasks have finished.
-    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+    DvzTransferBatch* batch = &context->batch;
+    bool sync = batch->sync || !gpu->app->is_running;
 
     // Process all pending transfer tasks.
     DvzTransfer tr = {0};
+    bool is_texture = false;
     while (true)
     {
-        tr = _transfer_dequeue(fifo, false);
+        tr = _transfer_dequeue(context, false);
         if (tr.type == DVZ_TRANSFER_NONE)
             break;
         fifo->is_processing = true;
@@ -203,6 +419,18 @@ void dvz_process_transfers(DvzContext* context)
         if (tr.type == DVZ_TRANSFER_BUFFER_COPY)
             _process_buffer_copy(context, tr);
 
+        // NOTE: the texture transfers are synchronous and use the staging buffer, so the
+        // transfers recorded before must be completed first. The textures may also be used by
+        // the frames in flight.
+        is_texture = tr.type == DVZ_TRANSFER_TEXTURE_UPLOAD ||
+                     tr.type == DVZ_TRANSFER_TEXTURE_DOWNLOAD ||
+                     tr.type == DVZ_TRANSFER_TEXTURE_COPY;
+        if (is_texture)
+        {
+            _batch_submit(context, true);
+            dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+        }
+
         // Process texture transfers.
         if (tr.type == DVZ_TRANSFER_TEXTURE_UPLOAD)
             _process_texture_upload(context, tr);
@@ -211,11 +439,48 @@ void dvz_process_transfers(DvzContext* context)
         if (tr.type == DVZ_TRANSFER_TEXTURE_COPY)
             _process_texture_copy(context, tr);
 
+        if (is_texture)
+            atomic_store(&batch->done, tr.ticket);
+        else
+            batch->ticket_batch = tr.ticket;
+
         fifo->is_processing = false;
     }
 
-    // NOTE: wait until all transfer tasks have finished.
-    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+    // Submit the recorded buffer transfers.
+    _batch_submit(context, sync);
+}
+
+
+
+void dvz_transfers_sync(DvzContext* context, bool sync)
+{
+    ASSERT(context != NULL);
+    context->batch.sync = sync;
+}
+
+
+
+bool dvz_transfer_done(DvzContext* context, uint64_t ticket)
+{
+    ASSERT(context != NULL);
+    _transfer_batch_complete(context, false);
+    return ticket <= atomic_load(&context->batch.done);
+}
+
+
+
+void dvz_transfer_wait(DvzContext* context, uint64_t ticket)
+{
+    ASSERT(context != NULL);
+    DvzTransferBatch* batch = &context->batch;
+    ASSERT(ticket <= batch->ticket);
+
+    // The transfer may still be in the FIFO queue.
+    if (ticket > atomic_load(&batch->done))
+        dvz_process_transfers(context);
+    _transfer_batch_complete(context, true);
+    ASSERT(ticket <= atomic_load(&batch->done));
 }
 
 
@@ -224,7 +489,7 @@ void dvz_process_transfers(DvzContext* context)
 /*  Canvas buffer transfers                                                                      */
 /*************************************************************************************************/
 
-static void _enqueue_buffer_transfer(
+static uint64_t _enqueue_buffer_transfer(
     DvzContext* context, DvzDataTransferType type, DvzBufferRegions br, //
     VkDeviceSize offset, VkDeviceSize size, void* data)
 {
@@ -244,35 +509,39 @@ static void _enqueue_buffer_transfer(
     tr.u.buf.size = size;
     tr.u.buf.data = data;
 
-    _transfer_enqueue(&context->transfers, tr);
+    return _transfer_enqueue(context, tr);
 }
 
 
 
 // WARNING: these functions require that the pointer lives through the next frame (no copy)
-void dvz_upload_buffer(
+uint64_t dvz_upload_buffer(
     DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
 {
-    _enqueue_buffer_transfer(context, DVZ_TRANSFER_BUFFER_UPLOAD, br, offset, size, data);
+    uint64_t ticket =
+        _enqueue_buffer_transfer(context, DVZ_TRANSFER_BUFFER_UPLOAD, br, offset, size, data);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
 }
 
 
 
-void dvz_download_buffer(
+uint64_t dvz_download_buffer(
     DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
 {
-    _enqueue_buffer_transfer(context, DVZ_TRANSFER_BUFFER_DOWNLOAD, br, offset, size, data);
+    uint64_t ticket =
+        _enqueue_buffer_transfer(context, DVZ_TRANSFER_BUFFER_DOWNLOAD, br, offset, size, data);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
 }
 
 
 
-void dvz_copy_buffer(
+uint64_t dvz_copy_buffer(
     DvzContext* context, DvzBufferRegions src, VkDeviceSize src_offset, //
     DvzBufferRegions dst, VkDeviceSize dst_offset, VkDeviceSize size)
 {
@@ -294,10 +563,11 @@ void dvz_copy_buffer(
     tr.u.buf_copy.dst_offset = dst_offset;
     tr.u.buf_copy.size = size;
 
-    _transfer_enqueue(&context->transfers, tr);
+    uint64_t ticket = _transfer_enqueue(context, tr);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
 }
 
 
@@ -306,7 +576,7 @@ void dvz_copy_buffer(
 /*  Canvas texture transfers                                                                     */
 /*************************************************************************************************/
 
-static void _enqueue_texture_transfer(
+static uint64_t _enqueue_texture_transfer(
     DvzContext* context, DvzDataTransferType type, DvzTexture* texture, //
     uvec3 offset, uvec3 shape, VkDeviceSize size, void* data)
 {
@@ -338,38 +608,40 @@ static void _enqueue_texture_transfer(
     tr.u.tex.data = data;
     tr.u.tex.texture = texture;
 
-    _transfer_enqueue(&context->transfers, tr);
+    return _transfer_enqueue(context, tr);
 }
 
 
 
-void dvz_upload_texture(
+uint64_t dvz_upload_texture(
     DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size,
     void* data)
 {
-    _enqueue_texture_transfer(
+    uint64_t ticket = _enqueue_texture_transfer(
         context, DVZ_TRANSFER_TEXTURE_UPLOAD, texture, offset, shape, size, data);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
 }
 
 
 
-void dvz_download_texture(
+uint64_t dvz_download_texture(
     DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size,
     void* data)
 {
-    _enqueue_texture_transfer(
+    uint64_t ticket = _enqueue_texture_transfer(
         context, DVZ_TRANSFER_TEXTURE_DOWNLOAD, texture, offset, shape, size, data);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
 }
 
 
 
-void dvz_copy_texture(
+uint64_t dvz_copy_texture(
     DvzContext* context, DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset,
     uvec3 shape, VkDeviceSize size)
 {
@@ -392,8 +664,61 @@ void dvz_copy_texture(
     memcpy(tr.u.tex_copy.dst_offset, dst_offset, sizeof(uvec3));
     memcpy(tr.u.tex_copy.shape, shape, sizeof(uvec3));
 
-    _transfer_enqueue(&context->transfers, tr);
+    uint64_t ticket = _transfer_enqueue(context, tr);
 
     if (!context->gpu->app->is_running)
         dvz_process_transfers(context);
+    return ticket;
+}
+
+
+
+/*************************************************************************************************/
+/*  Transfer synchronization                                                                     */
+/*************************************************************************************************/
+
+DvzTransferSync dvz_transfer_sync(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    DvzTransferSync sync = {0};
+    sync.semaphores = dvz_semaphores(gpu, 2);
+    return sync;
+}
+
+
+
+void dvz_transfer_sync_wait(DvzTransferSync* sync, DvzSubmit* submit, VkPipelineStageFlags stage)
+{
+    ASSERT(sync != NULL);
+    ASSERT(submit != NULL);
+    if (!sync->pending)
+        return;
+    dvz_submit_wait_semaphores(submit, stage, &sync->semaphores, sync->idx);
+    sync->pending = false;
+}
+
+
+
+void dvz_transfer_sync_signal(DvzTransferSync* sync, DvzSubmit* submit)
+{
+    ASSERT(sync != NULL);
+    ASSERT(submit != NULL);
+
+    // A binary semaphore cannot be signaled again before it has been waited on. If no submission
+    // has waited on the previous semaphore, this one consumes it, and the other one is signaled.
+    if (sync->pending)
+    {
+        dvz_transfer_sync_wait(sync, submit, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        sync->idx = (sync->idx + 1) % sync->semaphores.count;
+    }
+    dvz_submit_signal_semaphores(submit, &sync->semaphores, sync->idx);
+    sync->pending = true;
+}
+
+
+
+void dvz_transfer_sync_destroy(DvzTransferSync* sync)
+{
+    ASSERT(sync != NULL);
+    dvz_semaphores_destroy(&sync->semaphores);
 }
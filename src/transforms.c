@@ -4,59 +4,374 @@
 
 
 
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzTransformBatch DvzTransformBatch;
+
+typedef void (*DvzTransformKernel)(DvzTransformBatch* batch, uint32_t first, uint32_t count);
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+// A position transformation applied on a range of items of an input array, written to an output
+// array. The non-cartesian transform (if any) is fused with the final affine transform.
+struct DvzTransformBatch
+{
+    DvzTransformType type; // NONE/CARTESIAN, or EARTH_MERCATOR_WEB before the affine transform
+    dmat4 mat;             // affine transform
+    bool diagonal;         // whether the affine transform only scales and translates
+    dvec3 scale, shift;    // diagonal affine transform coefficients
+
+    const uint8_t* src;
+    VkDeviceSize src_stride;
+    uint32_t src_components;
+    bool src_double;
+
+    uint8_t* dst;
+    VkDeviceSize dst_stride;
+    uint32_t dst_components;
+    bool dst_double;
+
+    DvzTransformKernel kernel;
+    uint32_t first, count; // range processed by one worker
+};
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static inline bool _is_pos_dtype(DvzDataType dtype)
+{
+    switch (dtype)
+    {
+    case DVZ_DTYPE_FLOAT:
+    case DVZ_DTYPE_VEC2:
+    case DVZ_DTYPE_VEC3:
+    case DVZ_DTYPE_DOUBLE:
+    case DVZ_DTYPE_DVEC2:
+    case DVZ_DTYPE_DVEC3:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+
+static inline bool _is_double_dtype(DvzDataType dtype)
+{
+    return dtype == DVZ_DTYPE_DOUBLE || dtype == DVZ_DTYPE_DVEC2 || dtype == DVZ_DTYPE_DVEC3;
+}
+
+
+
+// Whether an affine transform only has diagonal scaling and translation coefficients.
+static bool _is_diagonal(dmat4 mat)
+{
+    for (uint32_t i = 0; i < 3; i++)
+        for (uint32_t j = 0; j < 4; j++)
+            if (i != j && mat[i][j] != 0)
+                return false;
+    return mat[3][3] == 1;
+}
+
+
+
+static inline void _batch_load(DvzTransformBatch* batch, uint32_t i, dvec3 pos)
+{
+    const uint8_t* src = batch->src + i * batch->src_stride;
+    pos[0] = pos[1] = pos[2] = 0;
+    if (batch->src_double)
+    {
+        memcpy(pos, src, batch->src_components * sizeof(double));
+    }
+    else
+    {
+        vec3 posf = {0};
+        memcpy(posf, src, batch->src_components * sizeof(float));
+        for (uint32_t k = 0; k < batch->src_components; k++)
+            pos[k] = posf[k];
+    }
+}
+
+
+
+static inline void _batch_store(DvzTransformBatch* batch, uint32_t i, dvec3 pos)
+{
+    uint8_t* dst = batch->dst + i * batch->dst_stride;
+    if (batch->dst_double)
+    {
+        memcpy(dst, pos, batch->dst_components * sizeof(double));
+    }
+    else
+    {
+        vec3 posf = {(float)pos[0], (float)pos[1], (float)pos[2]};
+        memcpy(dst, posf, batch->dst_components * sizeof(float));
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Kernels                                                                                      */
+/*************************************************************************************************/
+
+// Generic kernel: any supported input and output dtypes, any affine transform.
+static void _transform_kernel_generic(DvzTransformBatch* batch, uint32_t first, uint32_t count)
+{
+    dvec3 pos = {0};
+    dvec3 out = {0};
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        _batch_load(batch, i, pos);
+        if (batch->type == DVZ_TRANSFORM_EARTH_MERCATOR_WEB)
+        {
+            // NOTE: 2D transform, the last component is discarded.
+            _project_lonlat(pos[0], pos[1], pos);
+            pos[2] = 0;
+        }
+        if (batch->diagonal)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+                out[k] = batch->scale[k] * pos[k] + batch->shift[k];
+        }
+        else
+        {
+            _dmat4_mulv3(batch->mat, pos, 1, out);
+        }
+        _batch_store(batch, i, out);
+    }
+}
+
+
+
+#if DVZ_SIMD_X86
+
+// dvec3 to dvec3 or vec3, diagonal affine transform, SSE2.
+static void _transform_kernel_dvec3_sse2(DvzTransformBatch* batch, uint32_t first, uint32_t count)
+{
+    const __m128d sxy = _mm_loadu_pd(batch->scale);
+    const __m128d txy = _mm_loadu_pd(batch->shift);
+    const double sz = batch->scale[2], tz = batch->shift[2];
+    const double* s = NULL;
+    __m128d xy;
+    double z = 0;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        s = (const double*)(const void*)(batch->src + i * batch->src_stride);
+        xy = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(s), sxy), txy);
+        z = s[2] * sz + tz;
+        if (batch->dst_double)
+        {
+            double* d = (double*)(void*)(batch->dst + i * batch->dst_stride);
+            _mm_storeu_pd(d, xy);
+            d[2] = z;
+        }
+        else
+        {
+            float* d = (float*)(void*)(batch->dst + i * batch->dst_stride);
+            _mm_storel_pi((__m64*)(void*)d, _mm_cvtpd_ps(xy));
+            d[2] = (float)z;
+        }
+    }
+}
+
+#if DVZ_SIMD_AVX
+
+// dvec3 to dvec3 or vec3, diagonal affine transform, AVX with masked 3-lane loads and stores.
+__attribute__((target("avx"))) static void
+_transform_kernel_dvec3_avx(DvzTransformBatch* batch, uint32_t first, uint32_t count)
+{
+    const __m256i mask_d = _mm256_setr_epi64x(-1, -1, -1, 0);
+    const __m128i mask_f = _mm_setr_epi32(-1, -1, -1, 0);
+    const __m256d scale = _mm256_setr_pd(batch->scale[0], batch->scale[1], batch->scale[2], 0);
+    const __m256d shift = _mm256_setr_pd(batch->shift[0], batch->shift[1], batch->shift[2], 0);
+    const uint8_t* src = batch->src + first * batch->src_stride;
+    uint8_t* dst = batch->dst + first * batch->dst_stride;
+    __m256d pos;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pos = _mm256_maskload_pd((const double*)(const void*)src, mask_d);
+        pos = _mm256_add_pd(_mm256_mul_pd(pos, scale), shift);
+        if (batch->dst_double)
+            _mm256_maskstore_pd((double*)(void*)dst, mask_d, pos);
+        else
+            _mm_maskstore_ps((float*)(void*)dst, mask_f, _mm256_cvtpd_ps(pos));
+        src += batch->src_stride;
+        dst += batch->dst_stride;
+    }
+}
+
+#endif
+
+#elif DVZ_SIMD_NEON
+
+// dvec3 to dvec3 or vec3, diagonal affine transform, NEON.
+static void _transform_kernel_dvec3_neon(DvzTransformBatch* batch, uint32_t first, uint32_t count)
+{
+    const float64x2_t sxy = vld1q_f64(batch->scale);
+    const float64x2_t txy = vld1q_f64(batch->shift);
+    const double sz = batch->scale[2], tz = batch->shift[2];
+    const double* s = NULL;
+    float64x2_t xy;
+    double z = 0;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        s = (const double*)(const void*)(batch->src + i * batch->src_stride);
+        xy = vaddq_f64(vmulq_f64(vld1q_f64(s), sxy), txy);
+        z = s[2] * sz + tz;
+        if (batch->dst_double)
+        {
+            double* d = (double*)(void*)(batch->dst + i * batch->dst_stride);
+            vst1q_f64(d, xy);
+            d[2] = z;
+        }
+        else
+        {
+            float* d = (float*)(void*)(batch->dst + i * batch->dst_stride);
+            vst1_f32(d, vcvt_f32_f64(xy));
+            d[2] = (float)z;
+        }
+    }
+}
+
+#endif
+
+
+
+// Select the kernel once per transformation.
+static DvzTransformKernel _transform_kernel(DvzTransformBatch* batch)
+{
+    ASSERT(batch != NULL);
+    bool fast = batch->type != DVZ_TRANSFORM_EARTH_MERCATOR_WEB && batch->diagonal &&
+                batch->src_double && batch->src_components == 3 && batch->dst_components == 3;
+    if (!fast)
+        return _transform_kernel_generic;
+
+#if DVZ_SIMD_X86
+#if DVZ_SIMD_AVX
+    if (_cpu_has_avx())
+        return _transform_kernel_dvec3_avx;
+#endif
+    return _transform_kernel_dvec3_sse2;
+#elif DVZ_SIMD_NEON
+    return _transform_kernel_dvec3_neon;
+#else
+    return _transform_kernel_generic;
+#endif
+}
+
+
+
+/*************************************************************************************************/
+/*  Parallel dispatch                                                                            */
+/*************************************************************************************************/
+
+static void* _transform_worker(void* user_data)
+{
+    DvzTransformBatch* batch = (DvzTransformBatch*)user_data;
+    ASSERT(batch != NULL);
+    batch->kernel(batch, batch->first, batch->count);
+    return NULL;
+}
+
+
+
+static uint32_t _transform_thread_count(uint32_t item_count)
+{
+    if (item_count < DVZ_TRANSFORM_PARALLEL_THRESHOLD)
+        return 1;
+    long n = 1;
+#if OS_WIN32
+    n = 4;
+#else
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    n = CLIP(n, 1, DVZ_TRANSFORM_MAX_THREADS);
+    // Keep at least DVZ_TRANSFORM_PARALLEL_THRESHOLD / 2 items per thread.
+    n = MIN(n, (long)(2 * item_count / DVZ_TRANSFORM_PARALLEL_THRESHOLD));
+    return (uint32_t)MAX(n, 1);
+}
+
+
+
+// Split the items across worker threads, the calling thread processes the last chunk.
+static void _transform_run(DvzTransformBatch* batch, uint32_t item_count)
+{
+    ASSERT(batch != NULL);
+    ASSERT(batch->kernel != NULL);
+
+    uint32_t n_threads = _transform_thread_count(item_count);
+    if (n_threads <= 1)
+    {
+        batch->kernel(batch, 0, item_count);
+        return;
+    }
+
+    log_trace("transform %d items on %d threads", item_count, n_threads);
+    DvzTransformBatch batches[DVZ_TRANSFORM_MAX_THREADS];
+    DvzThread threads[DVZ_TRANSFORM_MAX_THREADS];
+    uint32_t chunk = (item_count + n_threads - 1) / n_threads;
+    for (uint32_t t = 0; t < n_threads; t++)
+    {
+        batches[t] = *batch;
+        batches[t].first = t * chunk;
+        batches[t].count = t < n_threads - 1 ? chunk : item_count - t * chunk;
+        if (t < n_threads - 1)
+            threads[t] = dvz_thread(_transform_worker, &batches[t]);
+    }
+    _transform_worker(&batches[n_threads - 1]);
+    for (uint32_t t = 0; t < n_threads - 1; t++)
+        dvz_thread_join(&threads[t]);
+}
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
 
 void dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out, bool inverse)
 {
-    // NOTE: this CPU transformation function is not optimized at all
-
     ASSERT(pos_in != NULL);
     ASSERT(pos_out != NULL);
     ASSERT(pos_out->item_count == pos_in->item_count);
-    ASSERT(pos_out->item_size == pos_in->item_size);
-    ASSERT(pos_out->dtype == pos_in->dtype);
+
+    if (!_is_pos_dtype(pos_in->dtype) || !_is_pos_dtype(pos_out->dtype))
+    {
+        log_error(
+            "unsupported dtypes %d and %d for position transformation", pos_in->dtype,
+            pos_out->dtype);
+        return;
+    }
 
     log_debug(
         "data normalization on %d position elements, transform %d", pos_in->item_count,
         coords.transform);
+    if (pos_in->item_count == 0)
+        return;
 
     // Default transform.
     DvzTransform tr = _transform(DVZ_TRANSFORM_CARTESIAN);
 
-    // // HACK: for now we only support DVEC3. For axes we need support for FLOAT just for linear
-    // so
-    // // we do that here.
-    // if (pos_out->dtype == DVZ_DTYPE_DOUBLE && coords.transform == DVZ_TRANSFORM_CARTESIAN)
-    // {
-    //     _box_print(coords.box);
-    //     double a = 2. / (coords.box.p1[0] - coords.box.p0[0]);
-    //     double b = -1 - 2 * coords.box.p0[0] / (coords.box.p1[0] - coords.box.p0[0]);
-    //     double x = 0;
-    //     for (uint32_t i = 0; i < pos_in->item_count; i++)
-    //     {
-    //         x = ((double*)pos_in->data)[i];
-    //         ((double*)pos_out->data)[i] = a * x + b;
-    //         log_debug("%f %f", x, ((double*)pos_out->data)[i]);
-    //     }
-    //     return;
-    //     // -1 + 2 * (t - u) / (v - u);
-    // }
-
-    // TODO: support other dtypes
-    ASSERT(pos_out->dtype == DVZ_DTYPE_DVEC3);
-
-    DvzArray* pos_temp = pos_in;
-
-    // First, handle non-cartesian transforms.
+    DvzTransformBatch batch = {0};
+    batch.type = DVZ_TRANSFORM_CARTESIAN;
+
+    // First, handle non-cartesian transforms, which are fused with the affine transform below.
     if (coords.transform == DVZ_TRANSFORM_EARTH_MERCATOR_WEB)
     {
         tr = _transform(coords.transform);
+        // NOTE: the inverse Mercator transform is not implemented yet, the flag is ignored.
         if (inverse)
             tr = _transform_inv(&tr);
-        _transform_array(&tr, pos_in, pos_out);
-        pos_temp = pos_out;
+        batch.type = coords.transform;
     }
     // TODO: more non-cartesian transforms.
 
@@ -69,10 +384,41 @@ void dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out
     // Then, linearly rescale to NDC, using the transformed box.
     tr = _transform_interp(box, DVZ_BOX_NDC);
 
-    // Apply the transformation.
-    _transform_array(&tr, pos_temp, pos_out);
-    // dvz_array_print(pos_temp);
-    // dvz_array_print(pos_out);
+    // With GPU normalization, only translate the positions by the data origin, the vertex shader
+    // does the rest.
+    if (_is_data_gpu(&coords))
+    {
+        tr = _transform(DVZ_TRANSFORM_CARTESIAN);
+        for (uint32_t k = 0; k < 3; k++)
+            tr.mat[3][k] = -coords.origin[k];
+    }
+
+    memcpy(batch.mat, tr.mat, sizeof(dmat4));
+    batch.diagonal = _is_diagonal(tr.mat);
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        batch.scale[k] = tr.mat[k][k];
+        batch.shift[k] = tr.mat[3][k];
+    }
+
+    // Input and output layouts.
+    batch.src = (const uint8_t*)pos_in->data;
+    batch.src_stride = pos_in->item_size;
+    batch.src_components = _get_components(pos_in->dtype);
+    batch.src_double = _is_double_dtype(pos_in->dtype);
+
+    batch.dst = (uint8_t*)pos_out->data;
+    batch.dst_stride = pos_out->item_size;
+    batch.dst_components = _get_components(pos_out->dtype);
+    batch.dst_double = _is_double_dtype(pos_out->dtype);
+
+    ASSERT(batch.src != NULL);
+    ASSERT(batch.dst != NULL);
+    ASSERT(batch.src_stride >= batch.src_components * (batch.src_double ? 8 : 4));
+    ASSERT(batch.dst_stride >= batch.dst_components * (batch.dst_double ? 8 : 4));
+
+    batch.kernel = _transform_kernel(&batch);
+    _transform_run(&batch, pos_in->item_count);
 }
 
 
@@ -167,6 +167,63 @@ static inline void _project_lonlat(double lon, double lat, dvec2 out)
 
 
 
+/*************************************************************************************************/
+/*  GPU data normalization                                                                       */
+/*************************************************************************************************/
+
+// Whether the box to NDC normalization is done in the vertex shader. Only cartesian transforms
+// are supported, other transforms fall back to CPU normalization.
+static inline bool _is_data_gpu(DvzDataCoords* coords)
+{
+    ASSERT(coords != NULL);
+    return (coords->flags & DVZ_TRANSFORM_FLAGS_GPU) != 0 &&
+           (coords->transform == DVZ_TRANSFORM_CARTESIAN ||
+            coords->transform == DVZ_TRANSFORM_NONE);
+}
+
+
+
+// Move the data origin to the center of the box if it falls outside the box, in which case the
+// positions need to be uploaded again. Return whether the origin has changed.
+static bool _data_origin_update(DvzDataCoords* coords)
+{
+    ASSERT(coords != NULL);
+    bool inside = true;
+    for (uint32_t j = 0; j < 3; j++)
+        inside = inside && coords->box.p0[j] <= coords->origin[j] &&
+                 coords->origin[j] <= coords->box.p1[j];
+    if (inside)
+        return false;
+    for (uint32_t j = 0; j < 3; j++)
+        coords->origin[j] = .5 * (coords->box.p0[j] + coords->box.p1[j]);
+    log_debug(
+        "move the data origin to %f %f %f", coords->origin[0], coords->origin[1],
+        coords->origin[2]);
+    return true;
+}
+
+
+
+// Affine transform applied in the vertex shader on the positions relative to the origin.
+static void _data_gpu_affine(DvzDataCoords* coords, vec4 scale, vec4 shift)
+{
+    ASSERT(coords != NULL);
+    DvzBox box = coords->box;
+    double a = 0, b = 0;
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        // NDC = a * (pos + origin) + b with a = 2 / (p1 - p0), b = -(p0 + p1) / (p1 - p0)
+        a = 2. / (box.p1[j] - box.p0[j]);
+        b = -(box.p0[j] + box.p1[j]) / (box.p1[j] - box.p0[j]);
+        scale[j] = (float)a;
+        shift[j] = (float)(a * coords->origin[j] + b);
+    }
+    scale[3] = 1;
+    shift[3] = 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Internal transform API                                                                       */
 /*************************************************************************************************/
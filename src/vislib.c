@@ -196,7 +196,13 @@ static void _line_strip_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         ASSERT(dst_offset == n_vertices_new);
     }
 
-    _default_visual_bake(visual, ev);
+    // A single line strip is copied as is, so that only the modified items need to be copied
+    // (for instance when streaming), unless staging arrays remain from several line strips.
+    if (n_strips < 2 && prop_pos->arr_staging.item_count == 0 &&
+        prop_color->arr_staging.item_count == 0)
+        _visual_bake_sources(visual, true);
+    else
+        _default_visual_bake(visual, ev);
 }
 
 static void _visual_line_strip(DvzVisual* visual)
@@ -712,6 +718,94 @@ static void _visual_polygon(DvzVisual* visual)
 /*  Path                                                                                         */
 /*************************************************************************************************/
 
+// Bake the item of a streamed path at the chronological position `c` in the ring buffer, which
+// starts at `base`. The streamed points form a single open path, with caps at the oldest and
+// newest points. The x coordinate of each point holds its ring buffer slot, which the vertex
+// shader replaces by the position of the point in the window.
+static void _path_stream_item(
+    DvzArray* arr_pos, DvzArray* arr_color, DvzArray* arr_vertex, uint32_t base, uint32_t c)
+{
+    uint32_t n = arr_pos->item_count;
+    ASSERT(c < n);
+    ASSERT(base < n);
+
+    DvzGraphicsPathVertex item = {0};
+    vec3* points[] = {&item.p0, &item.p1, &item.p2, &item.p3};
+    dvec3* point = NULL;
+    int32_t j = 0;
+    uint32_t slot = 0;
+    for (int32_t i = 0; i < 4; i++)
+    {
+        j = CLIP((int32_t)c + i - 1, 0, (int32_t)n - 1);
+        slot = (base + (uint32_t)j) % n;
+        point = dvz_array_item(arr_pos, slot);
+        _vec3_cast((const dvec3*)point, points[i]);
+        (*points[i])[0] = slot;
+    }
+
+    slot = (base + c) % n;
+    memcpy(item.color, dvz_array_item(arr_color, slot), sizeof(cvec4));
+    dvz_array_data(arr_vertex, 4 * slot, 4, 1, &item);
+}
+
+
+
+// Bake a streamed path. Once the ring buffer is full, only the items of the modified points and
+// of their neighbors are baked again, as well as the oldest item, which gets a cap.
+static void _path_stream_bake(DvzVisual* visual, DvzSource* src_vertex)
+{
+    ASSERT(visual != NULL);
+    ASSERT(src_vertex != NULL);
+
+    DvzProp* props[] = {
+        dvz_prop_get(visual, DVZ_PROP_POS, 0), dvz_prop_get(visual, DVZ_PROP_COLOR, 0)};
+    DvzArray* arr_pos = _prop_array(props[0], DVZ_PROP_ARRAY_DEFAULT);
+    DvzArray* arr_color = _prop_array(props[1], DVZ_PROP_ARRAY_DEFAULT);
+    DvzArray* arr_vertex = &src_vertex->arr;
+
+    uint32_t n = arr_pos->item_count;
+    ASSERT(n > 0);
+    uint32_t base = visual->viewport.ring_base;
+    ASSERT(base < n);
+
+    // 4 vertices per point, and one extra item mirroring the first one.
+    uint32_t old_count = arr_vertex->item_count;
+    dvz_array_resize(arr_vertex, 4 * (n + 1));
+
+    if (old_count != arr_vertex->item_count || props[0]->dirty.all || props[1]->dirty.all)
+    {
+        for (uint32_t c = 0; c < n; c++)
+            _path_stream_item(arr_pos, arr_color, arr_vertex, base, c);
+        _dirty_all(&src_vertex->dirty);
+        _stream_mirror(src_vertex, 4);
+        return;
+    }
+
+    // The items from c-2 to c+1 depend on the point at the chronological position c.
+    _dirty_clear(&src_vertex->dirty);
+    DvzDirtyRanges* dirty = NULL;
+    uint32_t c = 0, d = 0;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        dirty = &props[i]->dirty;
+        for (uint32_t r = 0; r < dirty->count; r++)
+        {
+            for (uint32_t slot = dirty->first[r]; slot < MIN(dirty->last[r], n); slot++)
+            {
+                c = (slot + n - base) % n;
+                for (d = c >= 2 ? c - 2 : 0; d <= MIN(c + 1, n - 1); d++)
+                {
+                    _path_stream_item(arr_pos, arr_color, arr_vertex, base, d);
+                    _dirty_add(&src_vertex->dirty, 4 * ((base + d) % n), 4);
+                }
+            }
+        }
+    }
+    _path_stream_item(arr_pos, arr_color, arr_vertex, base, 0);
+    _dirty_add(&src_vertex->dirty, 4 * base, 4);
+    _stream_mirror(src_vertex, 4);
+}
+
 static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     ASSERT(visual != NULL);
@@ -749,6 +843,13 @@ static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         log_debug("empty path visual");
         return;
     }
+
+    // Streamed path: the lengths and topology are ignored.
+    if (_source_is_streamed(visual, src_vertex))
+    {
+        _path_stream_bake(visual, src_vertex);
+        return;
+    }
     uint32_t n_paths = arr_length->item_count; // number of paths
     if (n_paths == 0)
         n_paths = 1;
@@ -1028,7 +1129,7 @@ static void _text_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
     DvzGraphicsTextItem item = {0};
     // Add all of the strings.
-    cvec4* colors = calloc(n_chars, sizeof(cvec4));
+    cvec4* colors = (cvec4*)dvz_arena_alloc(&visual->arena, n_chars * sizeof(cvec4));
     cvec4* color = NULL;
     uint32_t string_len = 0;
     uint32_t k = 0;
@@ -1071,7 +1172,6 @@ static void _text_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
         dvz_graphics_append(&data, &item);
     }
-    FREE(colors);
 }
 
 static void _visual_text(DvzVisual* visual)
@@ -1149,7 +1249,7 @@ static void _visual_text(DvzVisual* visual)
     // Text params.
     ASSERT(canvas->gpu != NULL);
     ASSERT(canvas->gpu->context != NULL);
-    DvzFontAtlas* atlas = &canvas->gpu->context->font_atlas;
+    DvzFontAtlas* atlas = dvz_context_font_atlas(canvas->gpu->context);
     ASSERT(atlas != NULL);
     ASSERT(strlen(atlas->font_str) > 0);
     dvz_visual_texture(visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, atlas->texture);
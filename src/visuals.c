@@ -50,6 +50,7 @@ static void dvz_source_destroy(DvzSource* source)
 {
     ASSERT(source != NULL);
     log_trace("destroy source");
+    _source_free_buffer(source);
     dvz_array_destroy(&source->arr);
     dvz_obj_destroyed(&source->obj);
 }
@@ -71,6 +72,21 @@ void dvz_visual_destroy(DvzVisual* visual)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings_comp, dvz_bindings_destroy)
     dvz_container_destroy(&visual->bindings_comp);
 
+    // Release the shared graphics pipelines, unless the canvas has already destroyed them.
+    DvzCanvas* canvas = visual->canvas;
+    if (canvas != NULL && dvz_obj_is_created(&canvas->obj))
+    {
+        for (uint32_t i = 0; i < visual->graphics_count; i++)
+            dvz_graphics_release(canvas, visual->graphics[i]);
+    }
+    visual->graphics_count = 0;
+
+    dvz_arena_destroy(&visual->arena);
+
+    // Release the indirect draw buffer.
+    if (visual->br_draw.buffer != NULL && canvas != NULL && canvas->gpu->context != NULL)
+        dvz_ctx_buffers_free(canvas->gpu->context, &visual->br_draw);
+
     dvz_obj_destroyed(&visual->obj);
 }
 
@@ -322,14 +338,23 @@ static void _visual_data(
     }
 
     // Make sure the array has the right size.
+    uint32_t old_count = prop->arr_orig.item_count;
     if (!do_resize)
-        count = MAX(count, prop->arr_orig.item_count);
+        count = MAX(count, old_count);
     dvz_array_resize(&prop->arr_orig, count);
 
     // Copy the specified array to the prop array.
     dvz_array_data(&prop->arr_orig, first_item, item_count, data_item_count, data);
 
+    // Keep track of the modified items, unless the number of items has changed.
+    if (count == old_count)
+        _dirty_add(&prop->dirty, first_item, item_count);
+    else
+        _dirty_all(&prop->dirty);
+
     prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+    if (visual->canvas != NULL)
+        dvz_canvas_dirty(visual->canvas);
 
     if (source != NULL)
     {
@@ -368,12 +393,74 @@ void dvz_visual_data_append(
     ASSERT(visual != NULL);
     DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
     ASSERT(prop != NULL);
+
+    // Streamed visual: write the new items at the head of the ring buffer.
+    DvzSource* source = prop->source;
+    if (source != NULL && _source_is_streamed(visual, source))
+    {
+        ASSERT(count > 0);
+        _stream_write(prop, visual->stream_capacity, count, data);
+        _stream_viewport(visual, prop);
+        prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+        source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        _source_set_changed(source, true);
+        return;
+    }
+
     uint32_t first_item = prop->arr_orig.item_count;
     dvz_visual_data_partial(visual, prop_type, prop_idx, first_item, count, count, data);
 }
 
 
 
+void dvz_visual_stream(DvzVisual* visual, uint32_t capacity)
+{
+    ASSERT(visual != NULL);
+    ASSERT(capacity > 0);
+
+    // The visual is left unchanged if it cannot be streamed.
+    if (!_stream_supported(visual))
+        return;
+
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source != NULL && prop->source->source_kind == DVZ_SOURCE_KIND_VERTEX)
+        {
+            // The existing items beyond the capacity are discarded.
+            if (prop->arr_orig.item_count > capacity)
+            {
+                log_warn(
+                    "discarding %d items of prop %d #%d beyond the stream capacity",
+                    prop->arr_orig.item_count - capacity, prop->prop_type, prop->prop_idx);
+                dvz_array_resize(&prop->arr_orig, capacity);
+                _dirty_all(&prop->dirty);
+            }
+            prop->stream_head = prop->arr_orig.item_count % capacity;
+        }
+        dvz_container_iter(&iter);
+    }
+
+    log_debug("stream visual with a capacity of %d items", capacity);
+    visual->stream_capacity = capacity;
+    prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    if (prop != NULL)
+        _stream_viewport(visual, prop);
+
+    // The ring buffers are reallocated with their full capacity at the next update.
+    DvzSource* source = NULL;
+    for (uint32_t i = 0; i < visual->graphics_count; i++)
+    {
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, i);
+        if (source != NULL && source->origin == DVZ_SOURCE_ORIGIN_LIB)
+            _source_set_changed(source, true);
+    }
+}
+
+
+
 static DvzSource*
 _assert_source_exists(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx)
 {
@@ -448,6 +535,7 @@ void dvz_visual_buffer(
     ASSERT(size > 0);
     ASSERT(br.buffer != VK_NULL_HANDLE);
 
+    _source_free_buffer(source);
     source->u.br = br;
     source->origin = DVZ_SOURCE_ORIGIN_USER;
     _source_set_changed(source, true);
@@ -493,6 +581,26 @@ void dvz_visual_flags(DvzVisual* visual, int flags)
 
 
 
+void dvz_visual_visible(DvzVisual* visual, bool is_visible)
+{
+    ASSERT(visual != NULL);
+    ASSERT(visual->canvas != NULL);
+    if (visual->hidden == !is_visible)
+        return;
+    visual->hidden = !is_visible;
+
+    // Indirect draws only need new draw arguments, direct draws need a refill.
+    if (_visual_is_indirect(visual))
+    {
+        _visual_draw_args(visual);
+        dvz_canvas_dirty(visual->canvas);
+    }
+    else
+        dvz_canvas_to_refill(visual->canvas);
+}
+
+
+
 uint32_t dvz_visual_item_count(DvzVisual* visual)
 {
     DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
@@ -676,6 +784,7 @@ void dvz_visual_update(
         // 2. Resize the VERTEX and INDEX array sources accordingly.
         // 3. Possibly resize other sources.
         // 4. Take the props and fill the array sources.
+        dvz_arena_reset(&visual->arena);
         visual->callback_bake(visual, ev);
     }
     // NOTE: we bake the UNIFORM sources here.
@@ -811,7 +920,12 @@ void dvz_visual_update(
             ASSERT(arr->item_size > 0);
 
             // Make sure the GPU buffer exists and is allocated with the right size.
+            DvzBuffer* old_buffer = br->buffer;
+            VkDeviceSize old_offset = br->offsets[0];
             _source_buffer(visual, source);
+            // A new buffer region must be entirely uploaded.
+            if (br->buffer != old_buffer || br->offsets[0] != old_offset)
+                _dirty_all(&source->dirty);
 
             ASSERT(br->size > 0);
             VkDeviceSize size = arr->item_count * arr->item_size;
@@ -831,8 +945,24 @@ void dvz_visual_update(
                 for (uint32_t i = 0; i < canvas->swapchain.img_count; i++)
                     dvz_buffer_upload(br->buffer, br->offsets[i], size, arr->data);
             }
-            else
+            else if (source->dirty.all)
                 dvz_upload_buffer(ctx, *br, 0, size, arr->data);
+            else
+            {
+                // Only upload the modified items.
+                VkDeviceSize offset = 0, range = 0;
+                for (uint32_t i = 0; i < source->dirty.count; i++)
+                {
+                    offset = source->dirty.first[i] * arr->item_size;
+                    range = source->dirty.last[i] * arr->item_size - offset;
+                    if (offset >= size)
+                        break;
+                    range = MIN(range, size - offset);
+                    log_trace("upload modified range of %s", pretty_size(range));
+                    dvz_upload_buffer(ctx, *br, offset, range, (uint8_t*)arr->data + offset);
+                }
+            }
+            _dirty_clear(&source->dirty);
             _source_set(source);
             // source->obj.status = DVZ_OBJECT_STATUS_CREATED;
             // visual->obj.status = DVZ_OBJECT_STATUS_CREATED;
@@ -868,6 +998,16 @@ void dvz_visual_update(
         dvz_container_iter(&iter);
     }
 
+    // The modified prop items have been copied to the sources.
+    iter = dvz_container_iterator(&visual->props);
+    DvzProp* prop = NULL;
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        _dirty_clear(&prop->dirty);
+        dvz_container_iter(&iter);
+    }
+
     // Update the bindings that need to be updated.
     for (uint32_t i = 0; i < visual->graphics_count; i++)
     {
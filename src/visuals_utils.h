@@ -5,6 +5,96 @@
 
 
 
+/*************************************************************************************************/
+/*  Dirty ranges                                                                                 */
+/*************************************************************************************************/
+
+// Mark all items as modified.
+static void _dirty_all(DvzDirtyRanges* dirty)
+{
+    ASSERT(dirty != NULL);
+    dirty->all = true;
+    dirty->count = 0;
+}
+
+
+
+static void _dirty_clear(DvzDirtyRanges* dirty)
+{
+    ASSERT(dirty != NULL);
+    dirty->all = false;
+    dirty->count = 0;
+}
+
+
+
+// Merge the two successive ranges separated by the smallest gap.
+static void _dirty_merge_closest(DvzDirtyRanges* dirty)
+{
+    ASSERT(dirty != NULL);
+    ASSERT(dirty->count >= 2);
+    uint32_t k = 0;
+    for (uint32_t i = 1; i + 1 < dirty->count; i++)
+    {
+        if (dirty->first[i + 1] - dirty->last[i] < dirty->first[k + 1] - dirty->last[k])
+            k = i;
+    }
+    dirty->last[k] = dirty->last[k + 1];
+    uint32_t n = dirty->count - k - 2;
+    memmove(&dirty->first[k + 1], &dirty->first[k + 2], n * sizeof(uint32_t));
+    memmove(&dirty->last[k + 1], &dirty->last[k + 2], n * sizeof(uint32_t));
+    dirty->count--;
+}
+
+
+
+// Add a range of modified items, merged with the overlapping and adjacent ranges.
+static void _dirty_add(DvzDirtyRanges* dirty, uint32_t first, uint32_t count)
+{
+    ASSERT(dirty != NULL);
+    if (dirty->all || count == 0)
+        return;
+    uint32_t last = first + count;
+
+    // Ranges [i, j) overlap or touch the new range.
+    uint32_t i = 0;
+    while (i < dirty->count && dirty->last[i] < first)
+        i++;
+    uint32_t j = i;
+    while (j < dirty->count && dirty->first[j] <= last)
+    {
+        first = MIN(first, dirty->first[j]);
+        last = MAX(last, dirty->last[j]);
+        j++;
+    }
+
+    if (j == i)
+    {
+        // The number of ranges is bounded, the closest ranges are merged when it is reached.
+        if (dirty->count == DVZ_MAX_DIRTY_RANGES)
+        {
+            _dirty_merge_closest(dirty);
+            _dirty_add(dirty, first, last - first);
+            return;
+        }
+        uint32_t n = dirty->count - i;
+        memmove(&dirty->first[i + 1], &dirty->first[i], n * sizeof(uint32_t));
+        memmove(&dirty->last[i + 1], &dirty->last[i], n * sizeof(uint32_t));
+        dirty->count++;
+    }
+    else if (j > i + 1)
+    {
+        uint32_t n = dirty->count - j;
+        memmove(&dirty->first[i + 1], &dirty->first[j], n * sizeof(uint32_t));
+        memmove(&dirty->last[i + 1], &dirty->last[j], n * sizeof(uint32_t));
+        dirty->count -= j - i - 1;
+    }
+    dirty->first[i] = first;
+    dirty->last[i] = last;
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual utils                                                                                 */
 /*************************************************************************************************/
@@ -26,6 +116,28 @@ static bool _source_is_buffer(DvzSourceKind source_kind)
 
 
 
+// Whether a source is a ring buffer of a streamed visual.
+static bool _source_is_streamed(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    return visual->stream_capacity > 0 && source->source_kind == DVZ_SOURCE_KIND_VERTEX;
+}
+
+
+
+// Number of vertices per item in the ring buffer of a streamed visual: the path graphics repeat
+// each point 4 times, the other streamable graphics have one vertex per item.
+static uint32_t _stream_item_vertices(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    ASSERT(visual->graphics_count > 0);
+    ASSERT(visual->graphics[0] != NULL);
+    return visual->graphics[0]->type == DVZ_GRAPHICS_PATH ? 4 : 1;
+}
+
+
+
 static bool _source_needs_binding(DvzSourceKind source_kind)
 {
     return source_kind == DVZ_SOURCE_KIND_UNIFORM || //
@@ -84,9 +196,15 @@ static void _source_set_changed(DvzSource* source, bool value)
     ASSERT(source != NULL);
     int req = value ? DVZ_VISUAL_REQUEST_UPLOAD : DVZ_VISUAL_REQUEST_NOT_SET;
     source->obj.request = req;
+    // NOTE: the baking of the source may restrict the upload to the modified items.
+    if (value)
+        _dirty_all(&source->dirty);
     ASSERT(source->visual != NULL);
     // Mark the visual as to be changed to.
     source->visual->obj.request = req;
+    // The visual will be updated at the next frame.
+    if (value && source->visual->canvas != NULL)
+        dvz_canvas_dirty(source->visual->canvas);
 }
 
 
@@ -214,10 +332,10 @@ static DvzTexture* _default_source_texture(DvzContext* ctx, DvzSourceKind kind)
     switch (ndims)
     {
     case 1:
-        tex = ctx->transfer_texture;
+        tex = dvz_context_transfer_texture(ctx);
         break;
     case 2:
-        tex = ctx->color_texture.texture;
+        tex = dvz_context_color_texture(ctx);
         break;
     case 3:
         log_warn("not implemented yet: default 3D texture");
@@ -329,6 +447,55 @@ static void _set_source_bindings(DvzVisual* visual, DvzSource* source)
 
 
 
+// Called when the buffer regions of a source have been moved by the compaction of the buffer.
+static void _source_relocated(DvzBufferRegions* br, void* user_data)
+{
+    DvzSource* source = (DvzSource*)user_data;
+    ASSERT(source != NULL);
+    ASSERT(br == &source->u.br);
+    DvzVisual* visual = source->visual;
+    ASSERT(visual != NULL);
+
+    _set_source_bindings(visual, source);
+
+    // NOTE: the GPU is idle during the compaction, the bindings can be updated right away.
+    DvzBindings* bindings = NULL;
+    for (uint32_t i = 0; i < visual->graphics_count; i++)
+    {
+        bindings = dvz_container_get(&visual->bindings, i);
+        if (bindings != NULL && bindings->obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+            dvz_bindings_update(bindings);
+    }
+    for (uint32_t i = 0; i < visual->compute_count; i++)
+    {
+        bindings = dvz_container_get(&visual->bindings_comp, i);
+        if (bindings != NULL && bindings->obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+            dvz_bindings_update(bindings);
+    }
+
+    // The vertex and index buffers are bound in the command buffers.
+    dvz_canvas_to_refill(visual->canvas);
+}
+
+
+
+// Free the buffer regions of a source, if they were allocated by the library.
+static void _source_free_buffer(DvzSource* source)
+{
+    ASSERT(source != NULL);
+    if (!_source_is_buffer(source->source_kind) || source->u.br.buffer == NULL)
+        return;
+    if (source->origin != DVZ_SOURCE_ORIGIN_LIB && source->origin != DVZ_SOURCE_ORIGIN_NOBAKE)
+        return;
+    ASSERT(source->visual != NULL);
+    ASSERT(source->visual->canvas != NULL);
+    DvzContext* ctx = source->visual->canvas->gpu->context;
+    if (ctx != NULL)
+        dvz_ctx_buffers_free(ctx, &source->u.br);
+}
+
+
+
 static void _create_source_buffer(DvzCanvas* canvas, DvzSource* source, VkDeviceSize size)
 {
     DvzContext* ctx = canvas->gpu->context;
@@ -354,7 +521,11 @@ static void _create_source_buffer(DvzCanvas* canvas, DvzSource* source, VkDevice
         break;
     }
     uint32_t buf_count = source->source_type == mappable ? canvas->swapchain.img_count : 1;
+
+    // Release the previous, smaller, buffer regions.
+    _source_free_buffer(source);
     source->u.br = dvz_ctx_buffers(ctx, type, buf_count, size);
+    dvz_ctx_buffers_owner(ctx, &source->u.br, _source_relocated, source);
 }
 
 
@@ -375,6 +546,12 @@ static void _source_buffer(DvzVisual* visual, DvzSource* source)
     if (source->u.br.buffer == VK_NULL_HANDLE || source->u.br.size < count * source->arr.item_size)
     {
         VkDeviceSize size = dvz_next_pow2(count * source->arr.item_size);
+        // The ring buffer of a streamed visual is allocated once, with the full capacity.
+        if (_source_is_streamed(visual, source))
+        {
+            uint32_t capacity = (visual->stream_capacity + 1) * _stream_item_vertices(visual);
+            size = MAX(count, capacity) * source->arr.item_size;
+        }
         ASSERT(size >= count * source->arr.item_size);
         log_debug(
             "need to %sallocate new buffer region to fit %d elements (%d bytes)",
@@ -382,6 +559,10 @@ static void _source_buffer(DvzVisual* visual, DvzSource* source)
         _create_source_buffer(canvas, source, size);
         // Set the pipeline bindings with the source buffer.
         _set_source_bindings(visual, source);
+        // The vertex and index buffers are bound in the command buffers.
+        if (source->source_kind == DVZ_SOURCE_KIND_VERTEX ||
+            source->source_kind == DVZ_SOURCE_KIND_INDEX)
+            visual->draw_layout_changed = true;
     }
     ASSERT(source->u.br.buffer != VK_NULL_HANDLE);
 }
@@ -439,11 +620,240 @@ static void _source_texture(DvzVisual* visual, DvzSource* source)
 
 
 
+/*************************************************************************************************/
+/*  Streaming                                                                                    */
+/*************************************************************************************************/
+
+// Whether a visual can be streamed: every VERTEX prop item must correspond to a single vertex,
+// or to a single point of a path, whose neighbors are resolved in the ring buffer order by the
+// path baking function. The vertices of the segments, text, images, meshes and volumes are built
+// from several items, which breaks at the wrap point of a ring buffer.
+static bool _stream_supported(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+
+    DvzGraphics* graphics = NULL;
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        graphics = visual->graphics[pidx];
+        ASSERT(graphics != NULL);
+        switch (graphics->type)
+        {
+        case DVZ_GRAPHICS_POINT:
+        case DVZ_GRAPHICS_LINE:
+        case DVZ_GRAPHICS_LINE_STRIP:
+        case DVZ_GRAPHICS_TRIANGLE:
+        case DVZ_GRAPHICS_TRIANGLE_STRIP:
+        case DVZ_GRAPHICS_TRIANGLE_FAN:
+        case DVZ_GRAPHICS_MARKER:
+        case DVZ_GRAPHICS_PATH:
+        case DVZ_GRAPHICS_CUSTOM:
+            break;
+        default:
+            log_error("cannot stream visual with graphics type %d", graphics->type);
+            return false;
+        }
+    }
+
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source != NULL && prop->source->source_kind == DVZ_SOURCE_KIND_VERTEX &&
+            prop->reps > 1)
+        {
+            log_error(
+                "cannot stream visual with prop %d #%d repeated over several vertices",
+                prop->prop_type, prop->prop_idx);
+            return false;
+        }
+        dvz_container_iter(&iter);
+    }
+    return true;
+}
+
+
+
+// Append items to a prop of a streamed visual. Once the prop array is full, the new items
+// overwrite the oldest ones, starting at the head of the ring buffer.
+static void _stream_write(DvzProp* prop, uint32_t capacity, uint32_t count, const void* data)
+{
+    ASSERT(prop != NULL);
+    ASSERT(capacity > 0);
+    ASSERT(data != NULL);
+
+    DvzArray* arr = &prop->arr_orig;
+    VkDeviceSize item_size = arr->item_size;
+    ASSERT(item_size > 0);
+    const uint8_t* items = (const uint8_t*)data;
+    uint32_t k = 0;
+
+    // Fill the array until it reaches the capacity.
+    uint32_t n = arr->item_count;
+    ASSERT(n <= capacity);
+    if (n < capacity)
+    {
+        k = MIN(count, capacity - n);
+        dvz_array_resize(arr, n + k);
+        dvz_array_data(arr, n, k, k, items);
+        _dirty_all(&prop->dirty);
+        prop->stream_head = (n + k) % capacity;
+        items += k * item_size;
+        count -= k;
+    }
+
+    // Only the last `capacity` items are kept.
+    if (count > capacity)
+    {
+        prop->stream_head = (prop->stream_head + count - capacity) % capacity;
+        items += (count - capacity) * item_size;
+        count = capacity;
+    }
+
+    // Overwrite the oldest items, wrapping around the end of the array.
+    while (count > 0)
+    {
+        k = MIN(count, capacity - prop->stream_head);
+        dvz_array_data(arr, prop->stream_head, k, k, items);
+        _dirty_add(&prop->dirty, prop->stream_head, k);
+        prop->stream_head = (prop->stream_head + k) % capacity;
+        items += k * item_size;
+        count -= k;
+    }
+}
+
+
+
+// Update the ring buffer position in the viewport uniforms of a streamed visual, after an append
+// to the given prop.
+static void _stream_viewport(DvzVisual* visual, DvzProp* prop)
+{
+    ASSERT(visual != NULL);
+    ASSERT(prop != NULL);
+
+    bool full = prop->arr_orig.item_count == visual->stream_capacity;
+    visual->stream_head = prop->stream_head;
+    visual->viewport.ring_base = full ? prop->stream_head : 0;
+    visual->viewport.ring_size = visual->stream_capacity;
+
+    // NOTE: the viewport uniforms of the graphics pipelines differ in their other options, so
+    // only the ring buffer fields are patched.
+    DvzSource* source = NULL;
+    DvzViewport* viewport = NULL;
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VIEWPORT, pidx);
+        if (source == NULL || source->arr.item_count == 0)
+            continue;
+        viewport = dvz_array_item(&source->arr, 0);
+        viewport->ring_base = visual->viewport.ring_base;
+        viewport->ring_size = visual->viewport.ring_size;
+        _source_set_changed(source, true);
+    }
+}
+
+
+
+// Copy the first item of a ring buffer, made of `k` vertices, to the extra item after its end.
+static void _stream_mirror(DvzSource* source, uint32_t k)
+{
+    ASSERT(source != NULL);
+    ASSERT(k > 0);
+    DvzArray* arr = &source->arr;
+    uint32_t n = arr->item_count;
+    ASSERT(n >= 2 * k);
+    memcpy(dvz_array_item(arr, n - k), dvz_array_item(arr, 0), k * arr->item_size);
+    _dirty_add(&source->dirty, n - k, k);
+}
+
+
+
+// Vertex ranges of the ring buffer of a streamed visual, from the oldest to the newest item. The
+// extra item after the end of the ring buffer mirrors the first one, so that line strips and
+// paths are continuous. A path item draws the segment to its next point, so the second range
+// starts after the mirrored item. Return the number of ranges.
+static uint32_t
+_stream_ranges(DvzVisual* visual, uint32_t vertex_count, uint32_t* first, uint32_t* count)
+{
+    ASSERT(visual != NULL);
+    ASSERT(first != NULL);
+    ASSERT(count != NULL);
+    uint32_t k = _stream_item_vertices(visual);
+    uint32_t capacity = visual->stream_capacity;
+    uint32_t head = visual->stream_head;
+    uint32_t n = vertex_count / k;
+    ASSERT(n >= 2);
+    ASSERT(n <= capacity + 1);
+
+    first[0] = 0;
+    count[0] = (n - 1) * k;
+    if (n <= capacity || head == 0)
+        return 1;
+
+    first[0] = head * k;
+    count[0] = (capacity + 1 - head) * k;
+    first[1] = k > 1 ? k : 0;
+    count[1] = head * k - first[1];
+    return count[1] > 0 ? 2 : 1;
+}
+
+
+
+// Draw the ring buffer of a streamed visual from the oldest to the newest item.
+static void
+_stream_draw(DvzVisual* visual, DvzCommands* cmds, uint32_t idx, uint32_t vertex_count)
+{
+    ASSERT(visual != NULL);
+    uint32_t first[2] = {0}, count[2] = {0};
+    uint32_t n = _stream_ranges(visual, vertex_count, first, count);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        log_debug("draw %d streamed vertices from %d", count[i], first[i]);
+        dvz_cmd_draw(cmds, idx, first[i], count[i]);
+    }
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual baking helpers                                                                        */
 /*************************************************************************************************/
 
-static void _prop_copy(DvzVisual* visual, DvzProp* prop)
+// Copy a range of prop items to the source array, and mark the source items as modified.
+static void _prop_copy_range(DvzProp* prop, DvzArray* arr, uint32_t first, uint32_t count)
+{
+    ASSERT(prop != NULL);
+    ASSERT(arr != NULL);
+    DvzSource* source = prop->source;
+    ASSERT(source != NULL);
+    if (count == 0 || first >= arr->item_count)
+        return;
+    count = MIN(count, arr->item_count - first);
+
+    // Each prop item is copied to `reps` source items, and the last prop item is repeated until
+    // the end of the source array.
+    uint32_t reps = MAX(prop->reps, 1);
+    uint32_t src_count = source->arr.item_count;
+    uint32_t dst_first = first * reps;
+    if (dst_first >= src_count)
+        return;
+    uint32_t dst_count = MIN(count * reps, src_count - dst_first);
+    if (first + count == arr->item_count)
+        dst_count = src_count - dst_first;
+
+    dvz_array_column(
+        &source->arr, prop->offset, prop->item_size, dst_first, dst_count, //
+        count, (const uint8_t*)arr->data + first * prop->item_size,        //
+        prop->arr_orig.dtype, prop->target_dtype,                          // optional cast
+        prop->copy_type, prop->reps);
+    _dirty_add(&source->dirty, dst_first, dst_count);
+}
+
+
+
+// Copy a prop to the source array, or only the items that were modified if `partial` is set.
+static void _prop_copy_items(DvzVisual* visual, DvzProp* prop, bool partial)
 {
     ASSERT(prop != NULL);
 
@@ -475,21 +885,35 @@ static void _prop_copy(DvzVisual* visual, DvzProp* prop)
         if (arr->item_count == 0)
             arr = _prop_array(prop, DVZ_PROP_ARRAY_ORIGINAL);
 
-        prop->arr_staging = dvz_array_copy(arr);
+        // NOTE: the staging array is reused across bakes.
+        dvz_array_copy_into(arr, &prop->arr_staging);
         arr = _prop_array(prop, DVZ_PROP_ARRAY_STAGING);
         dvz_array_scale(arr, prop->dpi_scaling);
     }
 
-    log_debug("copy prop type %d to source buffer", prop->prop_type);
-    dvz_array_column(
-        &source->arr, prop->offset, col_size, 0, source->arr.item_count, //
-        arr->item_count, arr->data,                                      //
-        prop->arr_orig.dtype, prop->target_dtype,                        // optional cast
-        prop->copy_type, prop->reps);
+    if (!partial)
+    {
+        log_debug("copy prop type %d to source buffer", prop->prop_type);
+        _prop_copy_range(prop, arr, 0, arr->item_count);
+        return;
+    }
+
+    DvzDirtyRanges* dirty = &prop->dirty;
+    ASSERT(!dirty->all);
+    if (dirty->count > 0)
+        log_debug(
+            "copy %d modified ranges of prop type %d to source buffer", //
+            dirty->count, prop->prop_type);
+    for (uint32_t i = 0; i < dirty->count; i++)
+        _prop_copy_range(prop, arr, dirty->first[i], dirty->last[i] - dirty->first[i]);
 }
 
 
 
+static void _prop_copy(DvzVisual* visual, DvzProp* prop) { _prop_copy_items(visual, prop, false); }
+
+
+
 static void _source_alloc(DvzVisual* visual, DvzSource* source, uint32_t count)
 {
     ASSERT(visual != NULL);
@@ -505,21 +929,36 @@ static void _source_alloc(DvzVisual* visual, DvzSource* source, uint32_t count)
 
 
 
-static void _source_fill(DvzVisual* visual, DvzSource* source)
+// Fill the source array with its props. If `partial` is set, the source array holds the props of
+// the previous baking, and only the items that were modified since then may be copied.
+static void _source_fill(DvzVisual* visual, DvzSource* source, bool partial)
 {
     ASSERT(visual != NULL);
     ASSERT(source != NULL);
 
-    // Copy all associated props to the source array.
     DvzProp* prop = NULL;
     DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL && partial)
+    {
+        prop = iter.item;
+        if (prop->source == source && prop->copy_type != DVZ_ARRAY_COPY_NONE)
+            partial = !prop->dirty.all;
+        dvz_container_iter(&iter);
+    }
+    if (partial)
+        _dirty_clear(&source->dirty);
+
+    // Copy all associated props to the source array.
+    iter = dvz_container_iterator(&visual->props);
     while (iter.item != NULL)
     {
         prop = iter.item;
         if (prop->source == source)
-            _prop_copy(visual, prop);
+            _prop_copy_items(visual, prop, partial);
         dvz_container_iter(&iter);
     }
+    if (!partial)
+        _dirty_all(&source->dirty);
 }
 
 
@@ -543,7 +982,7 @@ _get_pipeline_source(DvzVisual* visual, DvzSourceType source_type, uint32_t pipe
 
 
 
-static void _bake_source(DvzVisual* visual, DvzSource* source)
+static void _bake_source(DvzVisual* visual, DvzSource* source, bool partial)
 {
     ASSERT(visual != NULL);
     if (source == NULL)
@@ -569,11 +1008,20 @@ static void _bake_source(DvzVisual* visual, DvzSource* source)
 
     log_debug("baking source %d", source->source_kind);
 
+    // The ring buffer of a streamed visual has an extra item mirroring its first item.
+    bool streamed = _source_is_streamed(visual, source);
+    if (streamed)
+        count++;
+
     // Allocate the source array.
+    uint32_t old_count = source->arr.item_count;
     _source_alloc(visual, source, count);
 
-    // Copy all corresponding props to the array.
-    _source_fill(visual, source);
+    // Copy all corresponding props to the array. The unmodified items can be kept if the number
+    // of items has not changed.
+    _source_fill(visual, source, partial && count == old_count);
+    if (streamed)
+        _stream_mirror(source, 1);
 }
 
 
@@ -602,7 +1050,7 @@ static void _bake_uniforms(DvzVisual* visual)
             uint32_t count = _source_size(visual, source);
             ASSERT(count > 0);
             _source_alloc(visual, source, count);
-            _source_fill(visual, source);
+            _source_fill(visual, source, false);
         }
         dvz_container_iter(&iter);
     }
@@ -610,11 +1058,125 @@ static void _bake_uniforms(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Indirect draws                                                                               */
+/*************************************************************************************************/
+
+// Whether the draw commands of a visual read their arguments from the indirect draw buffer.
+// NOTE: graphics pipelines added after the allocation of the buffer fall back to direct draws.
+static inline bool _visual_is_indirect(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    return visual->br_draw.buffer != NULL &&
+           visual->br_draw.size >= 2 * visual->graphics_count * sizeof(DvzDrawArgs);
+}
+
+
+
+// Compute the indirect draw arguments of all graphics pipelines from the current item counts.
+static void _visual_draw_args(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    memset(visual->draw_args, 0, sizeof(visual->draw_args));
+    visual->draw_args_valid = 0;
+    if (visual->hidden)
+        return;
+
+    DvzSource* vertex_source = NULL;
+    DvzSource* index_source = NULL;
+    DvzDrawArgs* args = NULL;
+    uint32_t vertex_count = 0, index_count = 0;
+    for (uint32_t pipeline_idx = 0; pipeline_idx < visual->graphics_count; pipeline_idx++)
+    {
+        vertex_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, pipeline_idx);
+        if (vertex_source == NULL)
+            continue;
+        vertex_count = vertex_source->arr.item_count;
+        index_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, pipeline_idx);
+        index_count = index_source != NULL ? index_source->arr.item_count : 0;
+        args = &visual->draw_args[2 * pipeline_idx];
+
+        if (index_count > 0)
+        {
+            args[0].draw_indexed.indexCount = index_count;
+            args[0].draw_indexed.instanceCount = 1;
+        }
+        else if (
+            _source_is_streamed(visual, vertex_source) &&
+            vertex_count >= 2 * _stream_item_vertices(visual))
+        {
+            // Same draws as _stream_draw(), from the oldest to the newest item.
+            uint32_t first[2] = {0}, count[2] = {0};
+            uint32_t n = _stream_ranges(visual, vertex_count, first, count);
+            for (uint32_t i = 0; i < n; i++)
+            {
+                args[i].draw.firstVertex = first[i];
+                args[i].draw.vertexCount = count[i];
+                args[i].draw.instanceCount = 1;
+            }
+        }
+        else if (!_source_is_streamed(visual, vertex_source))
+        {
+            args[0].draw.vertexCount = vertex_count;
+            args[0].draw.instanceCount = 1;
+        }
+    }
+}
+
+
+
+// Allocate the indirect draw buffer of a visual, one region per swapchain image.
+static void _visual_draw_args_alloc(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    if (visual->br_draw.buffer != NULL || visual->graphics_count == 0)
+        return;
+
+    VkDeviceSize size = 2 * visual->graphics_count * sizeof(DvzDrawArgs);
+    visual->br_draw = dvz_ctx_buffers(
+        canvas->gpu->context, DVZ_BUFFER_TYPE_INDIRECT, canvas->swapchain.img_count, size);
+    _visual_draw_args(visual);
+}
+
+
+
+// Upload the draw arguments to the current swapchain image, if they have changed.
+static void _visual_draw_args_upload(DvzVisual* visual, uint32_t img_idx)
+{
+    ASSERT(visual != NULL);
+    ASSERT(img_idx < DVZ_MAX_SWAPCHAIN_IMAGES);
+    if (!_visual_is_indirect(visual) || (visual->draw_args_valid & (1u << img_idx)) != 0)
+        return;
+    dvz_canvas_buffers(
+        visual->canvas, visual->br_draw, 0, visual->br_draw.size, visual->draw_args);
+    visual->draw_args_valid |= 1u << img_idx;
+}
+
+
+
+// Buffer regions of one of the draws of a visual in the indirect draw buffer.
+static DvzBufferRegions _visual_draw_regions(DvzVisual* visual, uint32_t draw_idx)
+{
+    ASSERT(visual != NULL);
+    ASSERT(draw_idx < 2 * visual->graphics_count);
+    DvzBufferRegions br = visual->br_draw;
+    for (uint32_t i = 0; i < br.count; i++)
+        br.offsets[i] += draw_idx * sizeof(DvzDrawArgs);
+    br.size = sizeof(DvzDrawArgs);
+    return br;
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual default callbacks                                                                     */
 /*************************************************************************************************/
 
-static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+// Bake the VERTEX and INDEX sources. If `partial` is set, only the modified prop items may be
+// copied to the source arrays.
+static void _visual_bake_sources(DvzVisual* visual, bool partial)
 {
     ASSERT(visual != NULL);
 
@@ -625,7 +1187,7 @@ static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, i);
         if (source == NULL)
             break;
-        _bake_source(visual, source);
+        _bake_source(visual, source, partial);
     }
 
     // INDEX source.
@@ -634,12 +1196,23 @@ static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, i);
         if (source == NULL)
             break;
-        _bake_source(visual, source);
+        _bake_source(visual, source, partial);
     }
 }
 
 
 
+static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+
+    // NOTE: custom baking callbacks may modify the prop arrays in place before calling this
+    // function, in which case the whole sources are copied again.
+    _visual_bake_sources(visual, visual->callback_bake == _default_visual_bake);
+}
+
+
+
 static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
 {
     ASSERT(visual != NULL);
@@ -653,6 +1226,12 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
     ASSERT(viewport.width > 0);
     ASSERT(viewport.height > 0);
 
+    // With indirect draws, the draw counts and the visibility are read from the indirect draw
+    // buffer, which is updated without recording the command buffers again.
+    bool indirect = _visual_is_indirect(visual);
+    if (visual->hidden && !indirect)
+        return;
+
     // Draw all valid graphics pipelines.
     DvzBindings* bindings = NULL;
     for (uint32_t pipeline_idx = 0; pipeline_idx < visual->graphics_count; pipeline_idx++)
@@ -668,12 +1247,11 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
         ASSERT(vertex_source->pipeline_idx == pipeline_idx);
 
         uint32_t vertex_count = vertex_source->arr.item_count;
-        if (vertex_count == 0)
+        if (vertex_count == 0 && (!indirect || vertex_source->u.br.buffer == NULL))
         {
             log_warn("skip this graphics pipeline as the vertex buffer is empty");
             continue;
         }
-        ASSERT(vertex_count > 0);
 
         // Bind the vertex buffer.
         DvzBufferRegions* vertex_buf = &vertex_source->u.br;
@@ -699,12 +1277,29 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
         // Draw command.
         dvz_cmd_bind_graphics(cmds, idx, visual->graphics[pipeline_idx], bindings, 0);
 
-        if (index_count == 0)
+        if (indirect)
+        {
+            log_debug("indirect draw of graphics pipeline #%d", pipeline_idx);
+            if (index_count > 0)
+            {
+                dvz_cmd_draw_indexed_indirect(
+                    cmds, idx, _visual_draw_regions(visual, 2 * pipeline_idx));
+                continue;
+            }
+            dvz_cmd_draw_indirect(cmds, idx, _visual_draw_regions(visual, 2 * pipeline_idx));
+            if (_source_is_streamed(visual, vertex_source))
+                dvz_cmd_draw_indirect(
+                    cmds, idx, _visual_draw_regions(visual, 2 * pipeline_idx + 1));
+        }
+        else if (index_count == 0)
         {
             log_debug("draw %d vertices", vertex_count);
             // Make sure the bound vertex buffer is large enough.
             ASSERT(vertex_buf->size >= vertex_count * vertex_source->arr.item_size);
-            dvz_cmd_draw(cmds, idx, 0, vertex_count);
+            if (_source_is_streamed(visual, vertex_source))
+                _stream_draw(visual, cmds, idx, vertex_count);
+            else
+                dvz_cmd_draw(cmds, idx, 0, vertex_count);
         }
         else
         {
@@ -134,6 +134,7 @@ DvzApp* dvz_app(DvzBackend backend)
             gpu->app = app;
             gpu->idx = i;
             discover_gpu(physical_devices[i], gpu);
+            _pipeline_cache_default_path(gpu);
             log_debug("found device #%d: %s", gpu->idx, gpu->name);
         }
 
@@ -199,7 +200,7 @@ DvzGpu* dvz_gpu(DvzApp* app, uint32_t idx)
         log_error("GPU index %d higher than number of GPUs %d", idx, app->gpus.count);
         idx = 0;
     }
-    DvzGpu* gpu = app->gpus.items[idx];
+    DvzGpu* gpu = dvz_container_get(&app->gpus, idx);
     return gpu;
 }
 
@@ -273,6 +274,17 @@ void dvz_gpu_queue(DvzGpu* gpu, uint32_t idx, DvzQueueType type)
 
 
 
+
+void dvz_gpu_pipeline_cache(DvzGpu* gpu, const char* path)
+{
+    ASSERT(gpu != NULL);
+    if (dvz_obj_is_created(&gpu->obj))
+        log_warn("the pipeline cache file must be set before creating the GPU");
+    snprintf(gpu->pipeline_cache_path, DVZ_PATH_MAX_LEN, "%s", path != NULL ? path : "");
+}
+
+
+
 void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
 {
     if (gpu->queues.queue_count == 0)
@@ -303,12 +315,44 @@ void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
     // Create descriptor pool.
     create_descriptor_pool(gpu->device, &gpu->dset_pool);
 
+    // Create the pipeline cache, loaded from disk if possible.
+    _pipeline_cache_create(gpu);
+
+    // Initialize the device memory allocator.
+    _allocator_init(gpu);
+
     dvz_obj_created(&gpu->obj);
     log_trace("GPU #%d created", gpu->idx);
 }
 
 
 
+DvzMemoryStats dvz_gpu_memory_stats(DvzGpu* gpu, uint32_t heap)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(heap < gpu->memory_properties.memoryHeapCount);
+
+    DvzMemoryStats stats = {0};
+    DvzAllocator* allocator = &gpu->allocator;
+    pthread_mutex_lock(&allocator->lock);
+    for (uint32_t i = 0; i < gpu->memory_properties.memoryTypeCount; i++)
+    {
+        if (gpu->memory_properties.memoryTypes[i].heapIndex != heap)
+            continue;
+        for (DvzMemoryBlock* block = allocator->blocks[i]; block != NULL; block = block->next)
+        {
+            stats.used += block->used;
+            stats.reserved += block->size;
+            stats.block_count++;
+            stats.allocation_count += block->allocation_count;
+        }
+    }
+    pthread_mutex_unlock(&allocator->lock);
+    return stats;
+}
+
+
+
 void dvz_queue_wait(DvzGpu* gpu, uint32_t queue_idx)
 {
     ASSERT(gpu != NULL);
@@ -376,8 +420,19 @@ void dvz_gpu_destroy(DvzGpu* gpu)
             vkDestroyCommandPool(device, gpu->queues.cmd_pools[i], NULL);
             gpu->queues.cmd_pools[i] = VK_NULL_HANDLE;
         }
+        for (uint32_t j = 0; j < DVZ_MAX_RECORD_THREADS; j++)
+        {
+            if (gpu->queues.thread_cmd_pools[j][i] != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(device, gpu->queues.thread_cmd_pools[j][i], NULL);
+                gpu->queues.thread_cmd_pools[j][i] = VK_NULL_HANDLE;
+            }
+        }
     }
 
+    // Save and destroy the pipeline cache.
+    _pipeline_cache_destroy(gpu);
+
     // Destroy the descriptor pools.
     if (gpu->dset_pool != VK_NULL_HANDLE)
     {
@@ -386,6 +441,9 @@ void dvz_gpu_destroy(DvzGpu* gpu)
         gpu->dset_pool = VK_NULL_HANDLE;
     }
 
+    // Free the remaining device memory blocks.
+    _allocator_destroy(gpu);
+
     // Destroy the device.
     log_trace("destroy device");
     if (gpu->device != VK_NULL_HANDLE)
@@ -739,7 +797,8 @@ void dvz_swapchain_destroy(DvzSwapchain* swapchain)
 /*  Commands                                                                                     */
 /*************************************************************************************************/
 
-DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
+static DvzCommands _commands(
+    DvzGpu* gpu, uint32_t queue, uint32_t count, VkCommandBufferLevel level, VkCommandPool pool)
 {
     ASSERT(gpu != NULL);
     ASSERT(dvz_obj_is_created(&gpu->obj));
@@ -747,16 +806,16 @@ DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
     ASSERT(count <= DVZ_MAX_COMMAND_BUFFERS_PER_SET);
     ASSERT(queue < gpu->queues.queue_count);
     ASSERT(count > 0);
-    uint32_t qf = gpu->queues.queue_families[queue];
-    ASSERT(qf < gpu->queues.queue_family_count);
-    ASSERT(gpu->queues.cmd_pools[qf] != VK_NULL_HANDLE);
-    log_trace("creating commands on queue #%d, queue family #%d", queue, qf);
+    ASSERT(pool != VK_NULL_HANDLE);
+    log_trace("creating commands on queue #%d", queue);
 
     DvzCommands commands = {0};
     commands.gpu = gpu;
     commands.queue_idx = queue;
     commands.count = count;
-    allocate_command_buffers(gpu->device, gpu->queues.cmd_pools[qf], count, commands.cmds);
+    commands.secondary = level == VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    commands.pool = pool;
+    allocate_command_buffers(gpu->device, pool, level, count, commands.cmds);
 
     dvz_obj_init(&commands.obj);
 
@@ -765,6 +824,56 @@ DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
 
 
 
+static VkCommandPool _queue_cmd_pool(DvzGpu* gpu, uint32_t queue)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(queue < gpu->queues.queue_count);
+    uint32_t qf = gpu->queues.queue_families[queue];
+    ASSERT(qf < gpu->queues.queue_family_count);
+    ASSERT(gpu->queues.cmd_pools[qf] != VK_NULL_HANDLE);
+    return gpu->queues.cmd_pools[qf];
+}
+
+
+
+DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
+{
+    return _commands(
+        gpu, queue, count, VK_COMMAND_BUFFER_LEVEL_PRIMARY, _queue_cmd_pool(gpu, queue));
+}
+
+
+
+DvzCommands dvz_commands_secondary(DvzGpu* gpu, uint32_t queue, uint32_t count)
+{
+    return _commands(
+        gpu, queue, count, VK_COMMAND_BUFFER_LEVEL_SECONDARY, _queue_cmd_pool(gpu, queue));
+}
+
+
+
+DvzCommands dvz_commands_thread(DvzGpu* gpu, uint32_t queue, uint32_t count, uint32_t thread_idx)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(dvz_obj_is_created(&gpu->obj));
+    ASSERT(queue < gpu->queues.queue_count);
+    ASSERT(thread_idx < DVZ_MAX_RECORD_THREADS);
+
+    // Create the thread command pool for the queue family if needed.
+    uint32_t qf = gpu->queues.queue_families[queue];
+    ASSERT(qf < gpu->queues.queue_family_count);
+    VkCommandPool* pool = &gpu->queues.thread_cmd_pools[thread_idx][qf];
+    if (*pool == VK_NULL_HANDLE)
+    {
+        log_trace("create command pool for recording thread #%d", thread_idx);
+        create_command_pool(gpu->device, qf, pool);
+    }
+
+    return _commands(gpu, queue, count, VK_COMMAND_BUFFER_LEVEL_SECONDARY, *pool);
+}
+
+
+
 void dvz_cmd_begin(DvzCommands* cmds, uint32_t idx)
 {
     ASSERT(cmds != NULL);
@@ -777,6 +886,30 @@ void dvz_cmd_begin(DvzCommands* cmds, uint32_t idx)
 
 
 
+void dvz_cmd_begin_secondary(DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass)
+{
+    ASSERT(cmds != NULL);
+    ASSERT(cmds->count > 0);
+    ASSERT(cmds->secondary);
+    ASSERT(renderpass != NULL);
+    ASSERT(renderpass->renderpass != VK_NULL_HANDLE);
+
+    // NOTE: the framebuffer is left unspecified, so that the recorded commands remain valid when
+    // the framebuffers are recreated.
+    VkCommandBufferInheritanceInfo inheritance = {0};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderpass->renderpass;
+    inheritance.subpass = 0;
+
+    VkCommandBufferBeginInfo begin_info = {0};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmds->cmds[idx], &begin_info));
+}
+
+
+
 void dvz_cmd_end(DvzCommands* cmds, uint32_t idx)
 {
     ASSERT(cmds != NULL);
@@ -810,9 +943,8 @@ void dvz_cmd_free(DvzCommands* cmds)
     ASSERT(cmds->gpu->device != VK_NULL_HANDLE);
 
     log_trace("free %d command buffer(s)", cmds->count);
-    vkFreeCommandBuffers(
-        cmds->gpu->device, cmds->gpu->queues.cmd_pools[cmds->queue_idx], //
-        cmds->count, cmds->cmds);
+    ASSERT(cmds->pool != VK_NULL_HANDLE);
+    vkFreeCommandBuffers(cmds->gpu->device, cmds->pool, cmds->count, cmds->cmds);
 
     dvz_obj_init(&cmds->obj);
 }
@@ -904,6 +1036,14 @@ void dvz_buffer_memory(DvzBuffer* buffer, VkMemoryPropertyFlags memory)
 
 
 
+void dvz_buffer_memory_strategy(DvzBuffer* buffer, DvzMemoryStrategy strategy)
+{
+    ASSERT(buffer != NULL);
+    buffer->strategy = strategy;
+}
+
+
+
 void dvz_buffer_queue_access(DvzBuffer* buffer, uint32_t queue_idx)
 {
     ASSERT(buffer != NULL);
@@ -917,10 +1057,9 @@ void dvz_buffer_queue_access(DvzBuffer* buffer, uint32_t queue_idx)
 static void _buffer_create(DvzBuffer* buffer)
 {
     create_buffer(
-        buffer->gpu->device,                                           //
-        &buffer->gpu->queues, buffer->queue_count, buffer->queues,     //
-        buffer->usage, buffer->memory, buffer->gpu->memory_properties, //
-        buffer->size, &buffer->buffer, &buffer->device_memory);
+        buffer->gpu, buffer->queue_count, buffer->queues,              //
+        buffer->usage, buffer->memory, buffer->size, buffer->strategy, //
+        &buffer->buffer, &buffer->allocation);
 }
 
 
@@ -939,14 +1078,11 @@ static void _buffer_destroy(DvzBuffer* buffer)
         vkDestroyBuffer(buffer->gpu->device, buffer->buffer, NULL);
         buffer->buffer = VK_NULL_HANDLE;
     }
-    if (buffer->device_memory != VK_NULL_HANDLE)
-    {
-        vkFreeMemory(buffer->gpu->device, buffer->device_memory, NULL);
-        buffer->device_memory = VK_NULL_HANDLE;
-    }
+    if (buffer->allocation.block != NULL)
+        _memory_free(buffer->gpu, &buffer->allocation);
 
     ASSERT(buffer->buffer == VK_NULL_HANDLE);
-    ASSERT(buffer->device_memory == VK_NULL_HANDLE);
+    ASSERT(buffer->allocation.block == NULL);
 }
 
 
@@ -961,6 +1097,7 @@ static void _buffer_copy(DvzBuffer* buffer0, DvzBuffer* buffer1)
     buffer1->size = buffer0->size;
     buffer1->usage = buffer0->usage;
     buffer1->memory = buffer0->memory;
+    buffer1->strategy = buffer0->strategy;
 }
 
 
@@ -1047,9 +1184,9 @@ void dvz_buffer_resize(DvzBuffer* buffer, VkDeviceSize size)
 
     // Update the existing DvzBuffer struct with the newly-created Vulkan objects.
     buffer->buffer = new_buffer.buffer;
-    buffer->device_memory = new_buffer.device_memory;
+    buffer->allocation = new_buffer.allocation;
     ASSERT(buffer->buffer != VK_NULL_HANDLE);
-    ASSERT(buffer->device_memory != VK_NULL_HANDLE);
+    ASSERT(buffer->allocation.block != NULL);
 
     // If the existing buffer was already mapped, we need to remap the new buffer.
     if (old_mmap != NULL)
@@ -1076,10 +1213,11 @@ void* dvz_buffer_map(DvzBuffer* buffer, VkDeviceSize offset, VkDeviceSize size)
 
     log_debug("memmap buffer %d", buffer->type);
     ASSERT(buffer->mmap == NULL);
-    void* cdata = NULL;
-    VK_CHECK_RESULT(
-        vkMapMemory(buffer->gpu->device, buffer->device_memory, offset, size, 0, &cdata));
-    return cdata;
+    // Host-visible memory blocks are persistently mapped by the allocator.
+    DvzMemoryBlock* block = buffer->allocation.block;
+    ASSERT(block != NULL);
+    ASSERT(block->mmap != NULL);
+    return (uint8_t*)block->mmap + buffer->allocation.offset + offset;
 }
 
 
@@ -1095,8 +1233,8 @@ void dvz_buffer_unmap(DvzBuffer* buffer)
         (buffer->memory & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && //
         (buffer->memory & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
 
+    // NOTE: the underlying memory block remains mapped until it is freed by the allocator.
     log_debug("unmap buffer %d", buffer->type);
-    vkUnmapMemory(buffer->gpu->device, buffer->device_memory);
 }
 
 
@@ -1401,6 +1539,14 @@ void dvz_images_memory(DvzImages* images, VkMemoryPropertyFlags memory)
 
 
 
+void dvz_images_memory_strategy(DvzImages* images, DvzMemoryStrategy strategy)
+{
+    ASSERT(images != NULL);
+    images->strategy = strategy;
+}
+
+
+
 void dvz_images_aspect(DvzImages* images, VkImageAspectFlags aspect)
 {
     ASSERT(images != NULL);
@@ -1441,10 +1587,9 @@ static void _images_create(DvzImages* images)
     {
         if (!images->is_swapchain)
             create_image(
-                gpu->device, &gpu->queues, images->queue_count, images->queues, images->image_type,
-                images->width, images->height, images->depth, images->format, images->tiling,
-                images->usage, images->memory, gpu->memory_properties, &images->images[i],
-                &images->memories[i]);
+                gpu, images->queue_count, images->queues, images->image_type, images->width,
+                images->height, images->depth, images->format, images->tiling, images->usage,
+                images->memory, images->strategy, &images->images[i], &images->allocations[i]);
 
         // HACK: staging images do not require an image view
         if (images->tiling != VK_IMAGE_TILING_LINEAR)
@@ -1479,11 +1624,8 @@ static void _images_destroy(DvzImages* images)
             vkDestroyImage(images->gpu->device, images->images[i], NULL);
             images->images[i] = VK_NULL_HANDLE;
         }
-        if (images->memories[i] != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(images->gpu->device, images->memories[i], NULL);
-            images->memories[i] = VK_NULL_HANDLE;
-        }
+        if (images->allocations[i].block != NULL)
+            _memory_free(images->gpu, &images->allocations[i]);
     }
 }
 
@@ -1557,10 +1699,11 @@ void dvz_images_download(
     vkGetImageSubresourceLayout(
         staging->gpu->device, staging->images[idx], &subResource, &subResourceLayout);
 
-    // Map image memory so we can start copying from it
-    void* data = NULL;
-    vkMapMemory(staging->gpu->device, staging->memories[idx], 0, VK_WHOLE_SIZE, 0, &data);
-    ASSERT(data != NULL);
+    // The staging image lives in a persistently mapped memory block.
+    DvzAllocation* allocation = &staging->allocations[idx];
+    ASSERT(allocation->block != NULL);
+    ASSERT(allocation->block->mmap != NULL);
+    const void* data = (const uint8_t*)allocation->block->mmap + allocation->offset;
     VkDeviceSize offset = subResourceLayout.offset;
     VkDeviceSize row_pitch = subResourceLayout.rowPitch;
     ASSERT(row_pitch > 0);
@@ -1581,61 +1724,17 @@ void dvz_images_download(
     // Ensure that the staging buffer has the right size.
     ASSERT(staging->size >= size);
 
-    // First, memcopy from the GPU to the CPU.
-    void* image = calloc(row_pitch * h, 1);
-    void* image_orig = image;
-    memcpy(image, data, size);
-    vkUnmapMemory(staging->gpu->device, staging->memories[idx]);
-
-    // Then, convert the image to the requested format, into a contiguous array of pixels.
-    image = (void*)((uint64_t)image + offset);
-    uint32_t src_offset = 0;
-    uint32_t dst_offset = 0;
-    uint32_t y, x, k, l;
-    for (y = 0; y < h; y++)
-    {
-        src_offset = 0;
-        for (x = 0; x < w; x++)
-        {
-            ASSERT(src_offset + 2 < w * h * 4);
-            for (k = 0; k < 4; k++)
-            {
-                l = k <= 2 ? (swizzle ? 2 - k : k) : 3;
-                ASSERT(k <= 3);
-                ASSERT(l <= 3);
-                ASSERT(k < 3 || l == 3);
-                if (k == 3 && n_components == 3)
-                    continue;
-                memcpy(
-                    (void*)((uint64_t)out + (dst_offset + k) * bytes_per_component),
-                    (void*)((uint64_t)image + (src_offset + l) * bytes_per_component),
-                    bytes_per_component);
-            }
-
-            // if (swizzle)
-            // {
-            // out[dst_offset + 0] = image[src_offset + 2];
-            // out[dst_offset + 1] = image[src_offset + 1];
-            // out[dst_offset + 2] = image[src_offset + 0];
-            // if (has_alpha)
-            //     out[dst_offset + 3] = 255;
-            // }
-            // else
-            // {
-            //     out[dst_offset + 0] = image[src_offset + 0];
-            //     out[dst_offset + 1] = image[src_offset + 1];
-            //     out[dst_offset + 2] = image[src_offset + 2];
-            //     if (has_alpha)
-            //         out[dst_offset + 3] = 255;
-            // }
-
-            src_offset += 4;            // we assume RGBA in the source array
-            dst_offset += n_components; // either RGB or RGBA in the target array
-        }
-        image = (void*)((uint64_t)image + row_pitch);
+    // Convert the image to the requested format, into a contiguous array of pixels, reading
+    // directly from the mapped memory.
+    const uint8_t* src = (const uint8_t*)data + offset;
+    uint8_t* dst = (uint8_t*)out;
+    VkDeviceSize dst_row_size = w * n_components * bytes_per_component;
+    for (uint32_t y = 0; y < h; y++)
+    {
+        _image_row_convert(dst, src, w, bytes_per_component, swizzle, n_components);
+        src += row_pitch;
+        dst += dst_row_size;
     }
-    ASSERT(dst_offset == w * h * n_components);
-    FREE(image_orig);
 }
 
 
@@ -2036,7 +2135,7 @@ void dvz_compute_create(DvzCompute* compute)
     }
 
     create_compute_pipeline(
-        compute->gpu->device, compute->shader_module, //
+        compute->gpu->device, compute->gpu->pipeline_cache, compute->shader_module, //
         compute->slots.pipeline_layout, &compute->pipeline);
 
     dvz_obj_created(&compute->obj);
@@ -2341,7 +2440,8 @@ void dvz_graphics_create(DvzGraphics* graphics)
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
     VK_CHECK_RESULT(vkCreateGraphicsPipelines(
-        graphics->gpu->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &graphics->pipeline));
+        graphics->gpu->device, graphics->gpu->pipeline_cache, 1, &pipelineInfo, NULL,
+        &graphics->pipeline));
     if (graphics->pipeline != VK_NULL_HANDLE)
     {
         log_trace("graphics pipeline created");
@@ -3224,7 +3324,45 @@ void dvz_cmd_begin_renderpass(
     ASSERT(framebuffers->framebuffers[iclip] != VK_NULL_HANDLE);
     begin_render_pass(
         renderpass->renderpass, cb, framebuffers->framebuffers[iclip], //
-        width, height, renderpass->clear_count, renderpass->clear_values);
+        width, height, renderpass->clear_count, renderpass->clear_values,
+        VK_SUBPASS_CONTENTS_INLINE);
+    CMD_END
+}
+
+
+
+void dvz_cmd_begin_renderpass_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers)
+{
+    ASSERT(renderpass != NULL);
+    ASSERT(framebuffers != NULL);
+
+    ASSERT(dvz_obj_is_created(&renderpass->obj));
+    ASSERT(dvz_obj_is_created(&framebuffers->obj));
+    ASSERT(renderpass->renderpass != VK_NULL_HANDLE);
+
+    ASSERT(framebuffers->attachment_count > 0);
+    uint32_t width = framebuffers->attachments[0]->width;
+    uint32_t height = framebuffers->attachments[0]->height;
+
+    CMD_START_CLIP(cmds->count)
+    ASSERT(framebuffers->framebuffers[iclip] != VK_NULL_HANDLE);
+    begin_render_pass(
+        renderpass->renderpass, cb, framebuffers->framebuffers[iclip], //
+        width, height, renderpass->clear_count, renderpass->clear_values,
+        VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    CMD_END
+}
+
+
+
+void dvz_cmd_execute(DvzCommands* cmds, uint32_t idx, DvzCommands* secondary)
+{
+    ASSERT(secondary != NULL);
+    ASSERT(secondary->secondary);
+    ASSERT(idx < secondary->count);
+    CMD_START
+    vkCmdExecuteCommands(cb, 1, &secondary->cmds[idx]);
     CMD_END
 }
 
@@ -3346,10 +3484,28 @@ void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* barrier)
 void dvz_cmd_copy_buffer_to_image(
     DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images)
 {
+    ASSERT(images != NULL);
+    uvec3 offset = {0, 0, 0};
+    uvec3 shape = {images->width, images->height, images->depth};
+    dvz_cmd_copy_buffer_to_image_region(cmds, idx, buffer, 0, images, offset, shape);
+}
+
+
+
+void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, VkDeviceSize buf_offset, //
+    DvzImages* images, uvec3 img_offset, uvec3 shape)
+{
+    ASSERT(buffer != NULL);
+    ASSERT(images != NULL);
+    ASSERT(img_offset[0] + shape[0] <= images->width);
+    ASSERT(img_offset[1] + shape[1] <= images->height);
+    ASSERT(img_offset[2] + shape[2] <= images->depth);
+
     CMD_START_CLIP(images->count)
 
     VkBufferImageCopy region = {0};
-    region.bufferOffset = 0;
+    region.bufferOffset = buf_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
@@ -3358,13 +3514,13 @@ void dvz_cmd_copy_buffer_to_image(
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
 
-    region.imageOffset.x = 0;
-    region.imageOffset.y = 0;
-    region.imageOffset.z = 0;
+    region.imageOffset.x = (int32_t)img_offset[0];
+    region.imageOffset.y = (int32_t)img_offset[1];
+    region.imageOffset.z = (int32_t)img_offset[2];
 
-    region.imageExtent.width = images->width;
-    region.imageExtent.height = images->height;
-    region.imageExtent.depth = images->depth;
+    region.imageExtent.width = shape[0];
+    region.imageExtent.height = shape[1];
+    region.imageExtent.depth = shape[2];
 
     vkCmdCopyBufferToImage(
         cb, buffer->buffer, images->images[iclip], //
@@ -3378,10 +3534,28 @@ void dvz_cmd_copy_buffer_to_image(
 void dvz_cmd_copy_image_to_buffer(
     DvzCommands* cmds, uint32_t idx, DvzImages* images, DvzBuffer* buffer)
 {
+    ASSERT(images != NULL);
+    uvec3 offset = {0, 0, 0};
+    uvec3 shape = {images->width, images->height, images->depth};
+    dvz_cmd_copy_image_to_buffer_region(cmds, idx, images, offset, shape, buffer, 0);
+}
+
+
+
+void dvz_cmd_copy_image_to_buffer_region(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, uvec3 img_offset, uvec3 shape, //
+    DvzBuffer* buffer, VkDeviceSize buf_offset)
+{
+    ASSERT(buffer != NULL);
+    ASSERT(images != NULL);
+    ASSERT(img_offset[0] + shape[0] <= images->width);
+    ASSERT(img_offset[1] + shape[1] <= images->height);
+    ASSERT(img_offset[2] + shape[2] <= images->depth);
+
     CMD_START_CLIP(images->count)
 
     VkBufferImageCopy region = {0};
-    region.bufferOffset = 0;
+    region.bufferOffset = buf_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
@@ -3390,13 +3564,13 @@ void dvz_cmd_copy_image_to_buffer(
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
 
-    region.imageOffset.x = 0;
-    region.imageOffset.y = 0;
-    region.imageOffset.z = 0;
+    region.imageOffset.x = (int32_t)img_offset[0];
+    region.imageOffset.y = (int32_t)img_offset[1];
+    region.imageOffset.z = (int32_t)img_offset[2];
 
-    region.imageExtent.width = images->width;
-    region.imageExtent.height = images->height;
-    region.imageExtent.depth = images->depth;
+    region.imageExtent.width = shape[0];
+    region.imageExtent.height = shape[1];
+    region.imageExtent.depth = shape[2];
 
     vkCmdCopyImageToBuffer(
         cb, images->images[iclip], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, //
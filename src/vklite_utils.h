@@ -4,6 +4,13 @@
 
 #include "../include/datoviz/vklite.h"
 
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#if OS_WIN32
+#include <direct.h>
+#endif
+
 
 
 /*************************************************************************************************/
@@ -242,7 +249,6 @@ static const char* VALIDATION_IGNORES[] = {
     "ELFCLASS32",
 
     "BestPractices-vkBindMemory-small-dedicated-allocation",
-    "BestPractices-vkAllocateMemory-small-allocation",
     "BestPractices-vkCreateCommandPool-command-buffer-reset",
     "BestPractices-vkCreateInstance-specialuse-extension",
 
@@ -429,6 +435,84 @@ static void backend_poll_events(DvzBackend backend, DvzWindow* window)
 
 
 
+// The offscreen backend has no event queue: the main thread waits on a condition variable that
+// backend_wake() signals. NOTE: the state is local to the translation unit including this header.
+typedef struct DvzOffscreenEvents DvzOffscreenEvents;
+struct DvzOffscreenEvents
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool woken;
+};
+
+static DvzOffscreenEvents* _offscreen_events(void)
+{
+    static DvzOffscreenEvents events = {
+        PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false};
+    return &events;
+}
+
+
+
+// Block until a window event arrives, or until the timeout (in seconds) expires.
+static void backend_wait_events(DvzBackend backend, double timeout)
+{
+    switch (backend)
+    {
+    case DVZ_BACKEND_GLFW:
+        glfwWaitEventsTimeout(timeout);
+        break;
+    default:
+    {
+        // Absolute deadline of the wait.
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)timeout;
+        deadline.tv_nsec += (long)((timeout - (time_t)timeout) * 1e9);
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        DvzOffscreenEvents* events = _offscreen_events();
+        pthread_mutex_lock(&events->lock);
+        while (!events->woken)
+        {
+            if (pthread_cond_timedwait(&events->cond, &events->lock, &deadline) != 0)
+                break;
+        }
+        events->woken = false;
+        pthread_mutex_unlock(&events->lock);
+        break;
+    }
+    }
+}
+
+
+
+// Wake up the main thread if it is blocked in backend_wait_events(). Thread-safe.
+static void backend_wake(DvzBackend backend)
+{
+    switch (backend)
+    {
+    case DVZ_BACKEND_GLFW:
+        glfwPostEmptyEvent();
+        break;
+    default:
+    {
+        DvzOffscreenEvents* events = _offscreen_events();
+        pthread_mutex_lock(&events->lock);
+        events->woken = true;
+        pthread_cond_signal(&events->cond);
+        pthread_mutex_unlock(&events->lock);
+        break;
+    }
+    }
+}
+
+
+
 static void
 backend_window_destroy(VkInstance instance, DvzBackend backend, void* window, VkSurfaceKHR surface)
 {
@@ -1011,6 +1095,239 @@ static void create_device(DvzGpu* gpu, VkSurfaceKHR surface)
 
 
 
+/*************************************************************************************************/
+/*  Pipeline cache                                                                               */
+/*************************************************************************************************/
+
+// Size of the VK_PIPELINE_CACHE_HEADER_VERSION_ONE header at the start of the cache data:
+// header size, header version, vendor ID, device ID (4 bytes each), pipeline cache UUID.
+#define DVZ_PIPELINE_CACHE_HEADER_SIZE (16 + VK_UUID_SIZE)
+
+
+
+static void _cache_dir(char* dir)
+{
+    ASSERT(dir != NULL);
+    dir[0] = 0;
+
+    // The DVZ_CACHE_DIR environment variable takes precedence over the platform default.
+    const char* s = getenv("DVZ_CACHE_DIR");
+    if (s != NULL && s[0] != 0)
+    {
+        snprintf(dir, DVZ_PATH_MAX_LEN, "%s", s);
+        return;
+    }
+
+#if OS_WIN32
+    s = getenv("LOCALAPPDATA");
+    if (s != NULL && s[0] != 0)
+        snprintf(dir, DVZ_PATH_MAX_LEN, "%s/datoviz", s);
+#elif OS_MACOS
+    s = getenv("HOME");
+    if (s != NULL && s[0] != 0)
+        snprintf(dir, DVZ_PATH_MAX_LEN, "%s/Library/Caches/datoviz", s);
+#else
+    s = getenv("XDG_CACHE_HOME");
+    if (s != NULL && s[0] != 0)
+    {
+        snprintf(dir, DVZ_PATH_MAX_LEN, "%s/datoviz", s);
+        return;
+    }
+    s = getenv("HOME");
+    if (s != NULL && s[0] != 0)
+        snprintf(dir, DVZ_PATH_MAX_LEN, "%s/.cache/datoviz", s);
+#endif
+}
+
+
+
+// Create a directory and all its missing parents. Only the failure to create the last component
+// is reported, as the intermediate ones may be drive letters or inaccessible existing parents.
+static int _mkdir_p(const char* dir)
+{
+    ASSERT(dir != NULL);
+    char tmp[DVZ_PATH_MAX_LEN];
+    snprintf(tmp, sizeof(tmp), "%s", dir);
+    size_t len = strlen(tmp);
+    for (size_t i = 1; i <= len; i++)
+    {
+        if (tmp[i] != '/' && tmp[i] != '\\' && tmp[i] != 0)
+            continue;
+        char c = tmp[i];
+        tmp[i] = 0;
+#if OS_WIN32
+        int res = _mkdir(tmp);
+#else
+        int res = mkdir(tmp, 0755);
+#endif
+        if (res != 0 && errno != EEXIST && c == 0)
+            return -1;
+        tmp[i] = c;
+    }
+    return 0;
+}
+
+
+
+// The cache file is keyed by vendor, device, driver version and pipeline cache UUID, so that a
+// driver update or a different GPU never gets a stale cache.
+static void _pipeline_cache_default_path(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    char dir[DVZ_PATH_MAX_LEN];
+    _cache_dir(dir);
+    if (dir[0] == 0)
+    {
+        gpu->pipeline_cache_path[0] = 0;
+        return;
+    }
+
+    VkPhysicalDeviceProperties* props = &gpu->device_properties;
+    char uuid[2 * VK_UUID_SIZE + 1];
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+        snprintf(&uuid[2 * i], 3, "%02x", props->pipelineCacheUUID[i]);
+    snprintf(
+        gpu->pipeline_cache_path, DVZ_PATH_MAX_LEN, "%s/pipelines_%04x_%04x_%08x_%s.bin", dir,
+        props->vendorID, props->deviceID, props->driverVersion, uuid);
+}
+
+
+
+// Check that some pipeline cache data was generated by the same device and driver.
+static bool _pipeline_cache_valid(DvzGpu* gpu, const uint8_t* data, size_t size)
+{
+    ASSERT(gpu != NULL);
+    if (data == NULL || size < DVZ_PIPELINE_CACHE_HEADER_SIZE)
+        return false;
+
+    uint32_t header[4] = {0};
+    memcpy(header, data, sizeof(header));
+    VkPhysicalDeviceProperties* props = &gpu->device_properties;
+    return header[0] >= DVZ_PIPELINE_CACHE_HEADER_SIZE &&     //
+           header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && //
+           header[2] == props->vendorID &&                      //
+           header[3] == props->deviceID &&                      //
+           memcmp(&data[16], props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+
+
+static void _pipeline_cache_create(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(gpu->device != VK_NULL_HANDLE);
+
+    // Try to load the cache from disk.
+    uint8_t* data = NULL;
+    size_t size = 0;
+    const char* path = gpu->pipeline_cache_path;
+    FILE* f = path[0] != 0 ? fopen(path, "rb") : NULL;
+    if (f != NULL)
+    {
+        fseek(f, 0, SEEK_END);
+        long length = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (length > 0)
+        {
+            data = (uint8_t*)malloc((size_t)length);
+            size = fread(data, 1, (size_t)length, f);
+        }
+        fclose(f);
+
+        if (!_pipeline_cache_valid(gpu, data, size))
+        {
+            log_warn("discarding invalid pipeline cache %s", path);
+            FREE(data);
+            size = 0;
+        }
+        else
+        {
+            log_debug("loaded pipeline cache %s (%s)", path, pretty_size(size));
+        }
+    }
+
+    gpu->pipeline_cache_loaded = size;
+
+    VkPipelineCacheCreateInfo info = {0};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = size;
+    info.pInitialData = data;
+    VK_CHECK_RESULT(vkCreatePipelineCache(gpu->device, &info, NULL, &gpu->pipeline_cache));
+    FREE(data);
+}
+
+
+
+static void _pipeline_cache_save(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    const char* path = gpu->pipeline_cache_path;
+    if (gpu->pipeline_cache == VK_NULL_HANDLE || path[0] == 0)
+        return;
+
+    size_t size = 0;
+    VK_CHECK_RESULT(vkGetPipelineCacheData(gpu->device, gpu->pipeline_cache, &size, NULL));
+    if (size == 0)
+        return;
+    uint8_t* data = (uint8_t*)malloc(size);
+    VK_CHECK_RESULT(vkGetPipelineCacheData(gpu->device, gpu->pipeline_cache, &size, data));
+    if (!_pipeline_cache_valid(gpu, data, size))
+    {
+        FREE(data);
+        return;
+    }
+
+    // Create the cache directory.
+    char dir[DVZ_PATH_MAX_LEN];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* sep = strrchr(dir, '/');
+    if (sep != NULL)
+    {
+        *sep = 0;
+        if (_mkdir_p(dir) != 0)
+            log_warn("unable to create the cache directory %s", dir);
+    }
+
+    // Write to a temporary file first, so that concurrent processes never read a partial cache.
+    char tmp[DVZ_PATH_MAX_LEN + 8];
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    FILE* f = fopen(tmp, "wb");
+    if (f == NULL)
+    {
+        log_warn("unable to write the pipeline cache %s", tmp);
+        FREE(data);
+        return;
+    }
+    size_t written = fwrite(data, 1, size, f);
+    fclose(f);
+    FREE(data);
+
+#if OS_WIN32
+    remove(path);
+#endif
+    if (written != size || rename(tmp, path) != 0)
+    {
+        log_warn("unable to save the pipeline cache %s", path);
+        remove(tmp);
+        return;
+    }
+    log_debug("saved pipeline cache %s (%s)", path, pretty_size(size));
+}
+
+
+
+static void _pipeline_cache_destroy(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    if (gpu->pipeline_cache == VK_NULL_HANDLE)
+        return;
+    _pipeline_cache_save(gpu);
+    vkDestroyPipelineCache(gpu->device, gpu->pipeline_cache, NULL);
+    gpu->pipeline_cache = VK_NULL_HANDLE;
+}
+
+
+
 /*************************************************************************************************/
 /*  Swapchain                                                                                    */
 /*************************************************************************************************/
@@ -1155,7 +1472,8 @@ static void create_swapchain(
 /*************************************************************************************************/
 
 static void allocate_command_buffers(
-    VkDevice device, VkCommandPool command_pool, uint32_t count, VkCommandBuffer* cmd_bufs)
+    VkDevice device, VkCommandPool command_pool, VkCommandBufferLevel level, uint32_t count,
+    VkCommandBuffer* cmd_bufs)
 {
     ASSERT(count > 0);
     log_trace("allocate %d command buffer(s)", count);
@@ -1165,7 +1483,7 @@ static void allocate_command_buffers(
     VkCommandBufferAllocateInfo info = {0};
     info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     info.commandPool = command_pool;
-    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    info.level = level;
     info.commandBufferCount = count;
     VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &info, cmd_bufs));
 }
@@ -1173,7 +1491,7 @@ static void allocate_command_buffers(
 
 
 /*************************************************************************************************/
-/*  Buffers                                                                                      */
+/*  Memory allocator                                                                             */
 /*************************************************************************************************/
 
 static uint32_t find_memory_type(
@@ -1192,6 +1510,345 @@ static uint32_t find_memory_type(
 
 
 
+static void _allocator_init(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    DvzAllocator* allocator = &gpu->allocator;
+    pthread_mutex_init(&allocator->lock, NULL);
+
+    // Use smaller blocks on small heaps, such as the host-visible device-local heap.
+    VkPhysicalDeviceMemoryProperties* props = &gpu->memory_properties;
+    VkDeviceSize heap_size = 0;
+    for (uint32_t i = 0; i < props->memoryTypeCount; i++)
+    {
+        heap_size = props->memoryHeaps[props->memoryTypes[i].heapIndex].size;
+        allocator->block_sizes[i] =
+            CLIP(heap_size / 8, (VkDeviceSize)DVZ_MEMORY_BLOCK_MIN_SIZE, //
+                 (VkDeviceSize)DVZ_MEMORY_BLOCK_SIZE);
+        allocator->blocks[i] = NULL;
+    }
+}
+
+
+
+static DvzMemoryBlock* _memory_block(
+    DvzGpu* gpu, uint32_t memory_type, VkDeviceSize size, DvzMemoryStrategy strategy,
+    bool optimal)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(size > 0);
+
+    VkMemoryAllocateInfo info = {0};
+    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.allocationSize = size;
+    info.memoryTypeIndex = memory_type;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult res = vkAllocateMemory(gpu->device, &info, NULL, &memory);
+    if (res != VK_SUCCESS)
+    {
+        log_error(
+            "unable to allocate %s of device memory with type #%d", pretty_size(size),
+            memory_type);
+        return NULL;
+    }
+    log_trace(
+        "allocate %s memory block of %s with type #%d",
+        strategy == DVZ_MEMORY_STRATEGY_DEDICATED ? "dedicated" : "shared", pretty_size(size),
+        memory_type);
+
+    DvzMemoryBlock* block = (DvzMemoryBlock*)calloc(1, sizeof(DvzMemoryBlock));
+    block->memory = memory;
+    block->memory_type = memory_type;
+    block->strategy = strategy;
+    block->optimal = optimal;
+    block->size = size;
+    if (strategy == DVZ_MEMORY_STRATEGY_FREE_LIST)
+    {
+        block->free_capacity = 16;
+        block->free_ranges = (DvzMemoryRange*)calloc(block->free_capacity, sizeof(DvzMemoryRange));
+        block->free_ranges[0].size = size;
+        block->free_count = 1;
+    }
+
+    // Host-visible blocks are mapped once for all, as a device memory object cannot be mapped
+    // several times at once by the resources it holds.
+    VkMemoryPropertyFlags flags = gpu->memory_properties.memoryTypes[memory_type].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+        VK_CHECK_RESULT(vkMapMemory(gpu->device, memory, 0, VK_WHOLE_SIZE, 0, &block->mmap));
+
+    // Add the block to the pool of its memory type.
+    block->next = gpu->allocator.blocks[memory_type];
+    gpu->allocator.blocks[memory_type] = block;
+    return block;
+}
+
+
+
+static void _memory_block_destroy(DvzGpu* gpu, DvzMemoryBlock* block)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(block != NULL);
+
+    // Remove the block from its pool.
+    DvzMemoryBlock** prev = &gpu->allocator.blocks[block->memory_type];
+    while (*prev != NULL && *prev != block)
+        prev = &(*prev)->next;
+    ASSERT(*prev == block);
+    *prev = block->next;
+
+    log_trace("free memory block of %s", pretty_size(block->size));
+    if (block->mmap != NULL)
+        vkUnmapMemory(gpu->device, block->memory);
+    vkFreeMemory(gpu->device, block->memory, NULL);
+    FREE(block->free_ranges);
+    FREE(block);
+}
+
+
+
+static void
+_free_range_insert(DvzMemoryBlock* block, uint32_t idx, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(block != NULL);
+    ASSERT(idx <= block->free_count);
+    if (block->free_count == block->free_capacity)
+    {
+        block->free_capacity *= 2;
+        block->free_ranges = (DvzMemoryRange*)realloc(
+            block->free_ranges, block->free_capacity * sizeof(DvzMemoryRange));
+    }
+    memmove(
+        &block->free_ranges[idx + 1], &block->free_ranges[idx],
+        (block->free_count - idx) * sizeof(DvzMemoryRange));
+    block->free_ranges[idx].offset = offset;
+    block->free_ranges[idx].size = size;
+    block->free_count++;
+}
+
+
+
+static void _free_range_remove(DvzMemoryBlock* block, uint32_t idx)
+{
+    ASSERT(block != NULL);
+    ASSERT(idx < block->free_count);
+    memmove(
+        &block->free_ranges[idx], &block->free_ranges[idx + 1],
+        (block->free_count - idx - 1) * sizeof(DvzMemoryRange));
+    block->free_count--;
+}
+
+
+
+// Try to sub-allocate some memory in a block, return whether it succeeded.
+static bool _memory_block_alloc(
+    DvzMemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+    ASSERT(block != NULL);
+    ASSERT(offset != NULL);
+    VkDeviceSize off = 0;
+
+    switch (block->strategy)
+    {
+
+    case DVZ_MEMORY_STRATEGY_LINEAR:
+        off = aligned_size(block->head, alignment);
+        if (off + size > block->size)
+            return false;
+        block->head = off + size;
+        *offset = off;
+        return true;
+
+    case DVZ_MEMORY_STRATEGY_FREE_LIST:
+        // First fit.
+        for (uint32_t i = 0; i < block->free_count; i++)
+        {
+            DvzMemoryRange range = block->free_ranges[i];
+            off = aligned_size(range.offset, alignment);
+            if (off + size > range.offset + range.size)
+                continue;
+
+            // Replace the free range by the gaps before and after the allocation, if any.
+            _free_range_remove(block, i);
+            VkDeviceSize end = off + size;
+            if (end < range.offset + range.size)
+                _free_range_insert(block, i, end, range.offset + range.size - end);
+            if (off > range.offset)
+                _free_range_insert(block, i, range.offset, off - range.offset);
+            *offset = off;
+            return true;
+        }
+        return false;
+
+    case DVZ_MEMORY_STRATEGY_DEDICATED:
+        if (block->allocation_count > 0)
+            return false;
+        *offset = 0;
+        return true;
+
+    default:
+        break;
+    }
+    return false;
+}
+
+
+
+static void _memory_block_free(DvzMemoryBlock* block, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(block != NULL);
+    ASSERT(block->allocation_count > 0);
+    block->allocation_count--;
+    ASSERT(block->used >= size);
+    block->used -= size;
+
+    if (block->strategy == DVZ_MEMORY_STRATEGY_LINEAR)
+    {
+        // Linear blocks are only recycled once all of their allocations have been freed.
+        if (block->allocation_count == 0)
+            block->head = 0;
+        return;
+    }
+    if (block->strategy != DVZ_MEMORY_STRATEGY_FREE_LIST)
+        return;
+
+    // Find the first free range after the freed one.
+    uint32_t idx = 0;
+    while (idx < block->free_count && block->free_ranges[idx].offset < offset)
+        idx++;
+
+    // Coalesce with the next and previous free ranges.
+    bool merge_next = idx < block->free_count && offset + size == block->free_ranges[idx].offset;
+    bool merge_prev = idx > 0 && block->free_ranges[idx - 1].offset +
+                                         block->free_ranges[idx - 1].size ==
+                                     offset;
+    if (merge_prev && merge_next)
+    {
+        block->free_ranges[idx - 1].size += size + block->free_ranges[idx].size;
+        _free_range_remove(block, idx);
+    }
+    else if (merge_prev)
+    {
+        block->free_ranges[idx - 1].size += size;
+    }
+    else if (merge_next)
+    {
+        block->free_ranges[idx].offset = offset;
+        block->free_ranges[idx].size += size;
+    }
+    else
+    {
+        _free_range_insert(block, idx, offset, size);
+    }
+}
+
+
+
+// Allocate device memory for a resource, sub-allocating from a shared block when possible.
+static bool _memory_alloc(
+    DvzGpu* gpu, VkMemoryRequirements* req, VkMemoryPropertyFlags properties,
+    DvzMemoryStrategy strategy, bool optimal, DvzAllocation* allocation)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(req != NULL);
+    ASSERT(allocation != NULL);
+    ASSERT(req->size > 0);
+
+    DvzAllocator* allocator = &gpu->allocator;
+    uint32_t memory_type =
+        find_memory_type(req->memoryTypeBits, properties, gpu->memory_properties);
+    VkDeviceSize block_size = allocator->block_sizes[memory_type];
+    if (req->size > block_size / DVZ_MEMORY_DEDICATED_RATIO)
+        strategy = DVZ_MEMORY_STRATEGY_DEDICATED;
+
+    pthread_mutex_lock(&allocator->lock);
+
+    DvzMemoryBlock* block = NULL;
+    VkDeviceSize offset = 0;
+    if (strategy != DVZ_MEMORY_STRATEGY_DEDICATED)
+    {
+        // Look for an existing block with the same strategy and tiling.
+        for (block = allocator->blocks[memory_type]; block != NULL; block = block->next)
+        {
+            if (block->strategy == strategy && block->optimal == optimal &&
+                _memory_block_alloc(block, req->size, req->alignment, &offset))
+                break;
+        }
+    }
+    if (block == NULL)
+    {
+        block = _memory_block(
+            gpu, memory_type,
+            strategy == DVZ_MEMORY_STRATEGY_DEDICATED ? req->size : block_size, strategy,
+            optimal);
+        if (block == NULL || !_memory_block_alloc(block, req->size, req->alignment, &offset))
+        {
+            pthread_mutex_unlock(&allocator->lock);
+            return false;
+        }
+    }
+
+    block->allocation_count++;
+    block->used += req->size;
+    allocation->block = block;
+    allocation->offset = offset;
+    allocation->size = req->size;
+
+    pthread_mutex_unlock(&allocator->lock);
+    return true;
+}
+
+
+
+static void _memory_free(DvzGpu* gpu, DvzAllocation* allocation)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(allocation != NULL);
+    DvzMemoryBlock* block = allocation->block;
+    if (block == NULL)
+        return;
+
+    DvzAllocator* allocator = &gpu->allocator;
+    pthread_mutex_lock(&allocator->lock);
+
+    _memory_block_free(block, allocation->offset, allocation->size);
+
+    // Release empty blocks, but keep the last shared block of each memory type around to avoid
+    // allocating and freeing device memory repeatedly.
+    if (block->allocation_count == 0 &&
+        (block->strategy == DVZ_MEMORY_STRATEGY_DEDICATED ||
+         allocator->blocks[block->memory_type] != block || block->next != NULL))
+        _memory_block_destroy(gpu, block);
+
+    pthread_mutex_unlock(&allocator->lock);
+    memset(allocation, 0, sizeof(DvzAllocation));
+}
+
+
+
+static void _allocator_destroy(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    DvzAllocator* allocator = &gpu->allocator;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
+    {
+        while (allocator->blocks[i] != NULL)
+        {
+            if (allocator->blocks[i]->allocation_count > 0)
+                log_warn(
+                    "destroying memory block with %d live allocation(s)",
+                    allocator->blocks[i]->allocation_count);
+            _memory_block_destroy(gpu, allocator->blocks[i]);
+        }
+    }
+    pthread_mutex_destroy(&allocator->lock);
+}
+
+
+
+/*************************************************************************************************/
+/*  Buffers                                                                                      */
+/*************************************************************************************************/
+
 static void make_shared(
     DvzQueues* queues, uint32_t queue_count, const uint32_t* queue_indices, //
     VkSharingMode* sharing_mode, uint32_t* queue_family_count, uint32_t* queue_families)
@@ -1239,12 +1896,12 @@ static void make_shared(
 
 
 static void create_buffer(
-    VkDevice device, DvzQueues* queues, uint32_t queue_count, uint32_t* queue_indices, //
-    VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-    VkPhysicalDeviceMemoryProperties memory_properties, VkDeviceSize size, //
-    VkBuffer* buffer, VkDeviceMemory* bufferMemory)
+    DvzGpu* gpu, uint32_t queue_count, uint32_t* queue_indices, //
+    VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDeviceSize size,
+    DvzMemoryStrategy strategy, VkBuffer* buffer, DvzAllocation* allocation)
 {
-    ASSERT(queues != NULL);
+    ASSERT(gpu != NULL);
+    ASSERT(allocation != NULL);
 
     VkBufferCreateInfo buf_info = {0};
     buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1253,27 +1910,25 @@ static void create_buffer(
 
     uint32_t queue_families[DVZ_MAX_QUEUE_FAMILIES];
     make_shared(
-        queues, queue_count, queue_indices, //
+        &gpu->queues, queue_count, queue_indices, //
         &buf_info.sharingMode, &buf_info.queueFamilyIndexCount, queue_families);
     buf_info.pQueueFamilyIndices = queue_families;
 
     log_trace(
         "create buffer with size %s, sharing mode %s", pretty_size(size),
         buf_info.sharingMode == 0 ? "exclusive" : "concurrent");
-    VK_CHECK_RESULT(vkCreateBuffer(device, &buf_info, NULL, buffer));
+    VK_CHECK_RESULT(vkCreateBuffer(gpu->device, &buf_info, NULL, buffer));
 
     VkMemoryRequirements memRequirements = {0};
-    vkGetBufferMemoryRequirements(device, *buffer, &memRequirements);
+    vkGetBufferMemoryRequirements(gpu->device, *buffer, &memRequirements);
 
-    VkMemoryAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = memRequirements.size;
-    alloc_info.memoryTypeIndex =
-        find_memory_type(memRequirements.memoryTypeBits, properties, memory_properties);
-
-    VK_CHECK_RESULT(vkAllocateMemory(device, &alloc_info, NULL, bufferMemory));
-
-    vkBindBufferMemory(device, *buffer, *bufferMemory, 0);
+    if (!_memory_alloc(gpu, &memRequirements, properties, strategy, false, allocation))
+    {
+        log_error("unable to allocate memory for buffer of size %s", pretty_size(size));
+        return;
+    }
+    VK_CHECK_RESULT(vkBindBufferMemory(
+        gpu->device, *buffer, allocation->block->memory, allocation->offset));
 }
 
 
@@ -1308,13 +1963,14 @@ static void check_dims(VkImageType image_type, uint32_t width, uint32_t height,
 
 
 static void create_image(
-    VkDevice device, DvzQueues* queues, uint32_t queue_count, uint32_t* queue_indices,        //
+    DvzGpu* gpu, uint32_t queue_count, uint32_t* queue_indices,                               //
     VkImageType image_type, uint32_t width, uint32_t height, uint32_t depth, VkFormat format, //
     VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,          //
-    VkPhysicalDeviceMemoryProperties memory_properties,                                       //
-    VkImage* image, VkDeviceMemory* imageMemory)                                              //
+    DvzMemoryStrategy strategy, VkImage* image, DvzAllocation* allocation)                    //
 {
     log_trace("create image %dD %dx%dx%d", image_type + 1, width, height, depth);
+    ASSERT(gpu != NULL);
+    ASSERT(allocation != NULL);
     ASSERT(width > 0);
 
     VkImageCreateInfo info = {0};
@@ -1334,24 +1990,25 @@ static void create_image(
     // Sharing mode, depending on the queues that need to access the image.
     uint32_t queue_families[DVZ_MAX_QUEUE_FAMILIES];
     make_shared(
-        queues, queue_count, queue_indices, //
+        &gpu->queues, queue_count, queue_indices, //
         &info.sharingMode, &info.queueFamilyIndexCount, queue_families);
     info.pQueueFamilyIndices = queue_families;
 
-    VK_CHECK_RESULT(vkCreateImage(device, &info, NULL, image));
+    VK_CHECK_RESULT(vkCreateImage(gpu->device, &info, NULL, image));
 
     VkMemoryRequirements memRequirements = {0};
-    vkGetImageMemoryRequirements(device, *image, &memRequirements);
+    vkGetImageMemoryRequirements(gpu->device, *image, &memRequirements);
 
-    VkMemoryAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = memRequirements.size;
-    alloc_info.memoryTypeIndex =
-        find_memory_type(memRequirements.memoryTypeBits, properties, memory_properties);
-
-    VK_CHECK_RESULT(vkAllocateMemory(device, &alloc_info, NULL, imageMemory));
-
-    vkBindImageMemory(device, *image, *imageMemory, 0);
+    // Linear and optimal resources are kept in separate blocks so that bufferImageGranularity
+    // never needs to be taken into account.
+    bool optimal = tiling != VK_IMAGE_TILING_LINEAR;
+    if (!_memory_alloc(gpu, &memRequirements, properties, strategy, optimal, allocation))
+    {
+        log_error("unable to allocate memory for image %dx%dx%d", width, height, depth);
+        return;
+    }
+    VK_CHECK_RESULT(vkBindImageMemory(
+        gpu->device, *image, allocation->block->memory, allocation->offset));
 }
 
 
@@ -1382,6 +2039,154 @@ static void create_image_view(
 
 
 
+/*************************************************************************************************/
+/*  Image download conversion                                                                    */
+/*************************************************************************************************/
+
+// Convert a row of 4-component source pixels into RGB or RGBA pixels, swapping the first and
+// third components if needed (BGRA to RGB(A)). Scalar reference implementation.
+static void _image_row_convert_scalar(
+    uint8_t* dst, const uint8_t* src, uint32_t width, VkDeviceSize bytes_per_component,
+    bool swizzle, uint32_t n_components)
+{
+    VkDeviceSize bpc = bytes_per_component;
+    uint32_t l = 0;
+    for (uint32_t x = 0; x < width; x++)
+    {
+        for (uint32_t k = 0; k < n_components; k++)
+        {
+            l = (swizzle && k <= 2) ? 2 - k : k;
+            memcpy(dst + k * bpc, src + l * bpc, bpc);
+        }
+        src += 4 * bpc;
+        dst += n_components * bpc;
+    }
+}
+
+// The SIMD kernels below only handle 8-bit components. They return the number of converted
+// pixels, the rest of the row is converted by the scalar implementation.
+
+#if DVZ_SIMD_AVX
+
+// SSSE3: 4 pixels per shuffle. In RGB mode, the 16-byte store writes 4 bytes past the 3 pixels,
+// so we stop early enough to stay within the row.
+__attribute__((target("ssse3"))) static uint32_t _image_row_convert_ssse3(
+    uint8_t* dst, const uint8_t* src, uint32_t width, bool swizzle, uint32_t n_components)
+{
+    const char z = -1; // pshufb writes a zero byte
+    __m128i mask;
+    if (n_components == 4)
+        mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    else if (swizzle)
+        mask = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, z, z, z, z);
+    else
+        mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, z, z, z, z);
+
+    uint32_t margin = n_components == 4 ? 4 : 6;
+    uint32_t x = 0;
+    for (; x + margin <= width; x += 4)
+    {
+        _mm_storeu_si128(
+            (__m128i*)(void*)dst,
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(const void*)src), mask));
+        src += 16;
+        dst += 4 * n_components;
+    }
+    return x;
+}
+
+// AVX2: 8 pixels per shuffle, BGRA to RGBA only. The shuffle works within each 128-bit lane,
+// which always contains whole pixels.
+__attribute__((target("avx2"))) static uint32_t
+_image_row_bgra_rgba_avx2(uint8_t* dst, const uint8_t* src, uint32_t width)
+{
+    const __m256i mask = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, //
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        _mm256_storeu_si256(
+            (__m256i*)(void*)dst,
+            _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(const void*)src), mask));
+        src += 32;
+        dst += 32;
+    }
+    return x;
+}
+
+#elif DVZ_SIMD_NEON
+
+// NEON: 16 pixels per iteration, deinterleaved into 4 component registers.
+static uint32_t _image_row_convert_neon(
+    uint8_t* dst, const uint8_t* src, uint32_t width, bool swizzle, uint32_t n_components)
+{
+    uint8x16x4_t px;
+    uint8x16_t tmp;
+    uint8x16x3_t rgb;
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        px = vld4q_u8(src);
+        if (swizzle)
+        {
+            tmp = px.val[0];
+            px.val[0] = px.val[2];
+            px.val[2] = tmp;
+        }
+        if (n_components == 4)
+        {
+            vst4q_u8(dst, px);
+        }
+        else
+        {
+            rgb.val[0] = px.val[0];
+            rgb.val[1] = px.val[1];
+            rgb.val[2] = px.val[2];
+            vst3q_u8(dst, rgb);
+        }
+        src += 64;
+        dst += 16 * n_components;
+    }
+    return x;
+}
+
+#endif
+
+// Convert a row of pixels, with the fastest kernel available.
+static void _image_row_convert(
+    uint8_t* dst, const uint8_t* src, uint32_t width, VkDeviceSize bytes_per_component,
+    bool swizzle, uint32_t n_components)
+{
+    ASSERT(n_components == 3 || n_components == 4);
+
+    // Plain copy, for example with the RGBA32I pick images.
+    if (!swizzle && n_components == 4)
+    {
+        memcpy(dst, src, width * 4 * bytes_per_component);
+        return;
+    }
+
+    uint32_t done = 0;
+    if (bytes_per_component == 1)
+    {
+#if DVZ_SIMD_AVX
+        if (swizzle && n_components == 4 && _cpu_has_avx2())
+            done = _image_row_bgra_rgba_avx2(dst, src, width);
+        else if (_cpu_has_ssse3())
+            done = _image_row_convert_ssse3(dst, src, width, swizzle, n_components);
+#elif DVZ_SIMD_NEON
+        done = _image_row_convert_neon(dst, src, width, swizzle, n_components);
+#endif
+    }
+    ASSERT(done <= width);
+    _image_row_convert_scalar(
+        dst + done * n_components * bytes_per_component, src + done * 4 * bytes_per_component,
+        width - done, bytes_per_component, swizzle, n_components);
+}
+
+
+
 /*************************************************************************************************/
 /*  Sampler                                                                                      */
 /*************************************************************************************************/
@@ -1650,8 +2455,8 @@ static VkShaderModule create_shader_module_from_file(VkDevice device, const char
 /*************************************************************************************************/
 
 static void create_compute_pipeline(
-    VkDevice device, VkShaderModule shader_module, VkPipelineLayout pipeline_layout,
-    VkPipeline* pipeline)
+    VkDevice device, VkPipelineCache cache, VkShaderModule shader_module,
+    VkPipelineLayout pipeline_layout, VkPipeline* pipeline)
 {
     // Create the shader and pipeline.
     VkComputePipelineCreateInfo pipelineInfo = {0};
@@ -1662,8 +2467,7 @@ static void create_compute_pipeline(
     pipelineInfo.stage.pName = "main";
     pipelineInfo.stage.module = shader_module;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-    VK_CHECK_RESULT(
-        vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, pipeline));
+    VK_CHECK_RESULT(vkCreateComputePipelines(device, cache, 1, &pipelineInfo, NULL, pipeline));
 }
 
 
@@ -1827,7 +2631,8 @@ static VkAttachmentReference create_attachment_ref(uint32_t attachment, VkImageL
 
 static void begin_render_pass(
     VkRenderPass renderpass, VkCommandBuffer cmd_buf, VkFramebuffer framebuffer, //
-    uint32_t width, uint32_t height, uint32_t clear_count, VkClearValue* clear_colors)
+    uint32_t width, uint32_t height, uint32_t clear_count, VkClearValue* clear_colors,
+    VkSubpassContents contents)
 {
     ASSERT(renderpass != VK_NULL_HANDLE);
     ASSERT(framebuffer != VK_NULL_HANDLE);
@@ -1842,7 +2647,7 @@ static void begin_render_pass(
     info.renderArea = renderArea;
     info.clearValueCount = clear_count;
     info.pClearValues = clear_colors;
-    vkCmdBeginRenderPass(cmd_buf, &info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd_buf, &info, contents);
 }
 
 #endif
@@ -305,6 +305,60 @@ int test_canvas_events(TestContext* tc)
 
 
 
+static void _slow_button_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    // Keep the event thread busy so that the next events accumulate in the queue.
+    dvz_sleep(100);
+}
+
+int test_canvas_events_coalesce(TestContext* tc)
+{
+    DvzApp* app = tc->app;
+    OFFSCREEN_SKIP
+
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, WIDTH, HEIGHT, 0);
+
+    EventHolder events = {0};
+    dvz_event_callback( //
+        canvas, DVZ_EVENT_MOUSE_PRESS, 0, DVZ_EVENT_MODE_ASYNC, _slow_button_callback, NULL);
+    dvz_event_callback( //
+        canvas, DVZ_EVENT_MOUSE_WHEEL, 0, DVZ_EVENT_MODE_ASYNC, _wheel_callback, &events);
+    dvz_event_callback( //
+        canvas, DVZ_EVENT_MOUSE_MOVE, 0, DVZ_EVENT_MODE_ASYNC, _move_callback, &events);
+
+    dvz_event_mouse_press(canvas, DVZ_MOUSE_BUTTON_LEFT, 0);
+
+    // Mouse moves: only the latest position is kept.
+    vec2 pos = {0};
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        pos[0] = 10 + i;
+        dvz_event_mouse_move(canvas, pos, 0);
+    }
+
+    // Mouse wheel: the directions are accumulated.
+    vec2 dir = {0, -1};
+    for (uint32_t i = 0; i < 5; i++)
+        dvz_event_mouse_wheel(canvas, pos, dir, 0);
+
+    // Wait until the event thread has processed all events.
+    dvz_sleep(200);
+    AT(dvz_event_pending(canvas, DVZ_EVENT_MOUSE_MOVE) == 0);
+
+    AT(dvz_event_coalesced(canvas, DVZ_EVENT_MOUSE_MOVE) == 9);
+    AT(dvz_event_coalesced(canvas, DVZ_EVENT_MOUSE_WHEEL) == 4);
+    AT(dvz_event_coalesced(canvas, DVZ_EVENT_MOUSE_PRESS) == 0);
+    AC(events.move.u.m.pos[0], 19, EPS);
+    AC(events.wheel.u.w.dir[1], -5, EPS);
+
+    dvz_canvas_destroy(canvas);
+    return 0;
+}
+
+
+
 static void _gui_callback(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
@@ -412,12 +466,122 @@ int test_canvas_screencast(TestContext* tc)
 
     dvz_app_run(app, 60);
 
+    // The downloads overlap with the rendering of the next frames.
+    DvzScreencastStats stats = dvz_screencast_stats(canvas);
+    AT(stats.frames > 0);
+    AT(stats.latency_max > 0);
+    log_debug(
+        "%" PRIu64 " frames, %" PRIu64 " dropped, latency %.1f ms", stats.frames, stats.dropped,
+        stats.latency_avg * 1000);
+
     dvz_canvas_destroy(canvas);
     return res;
 }
 
 
 
+static void _screenshot_async_callback(
+    DvzCanvas* canvas, uint8_t* rgba, uint32_t width, uint32_t height, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(rgba != NULL);
+    int* count = (int*)user_data;
+    ASSERT(count != NULL);
+
+    // The canvas is green, check the central pixel.
+    uint8_t* pixel = &rgba[3 * (width * (height / 2) + width / 2)];
+    if (pixel[0] == 0 && pixel[1] == 255 && pixel[2] == 0)
+        count[0]++;
+    else
+        count[1]++;
+}
+
+static void _frame_screenshot_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    if (ev.u.f.idx % 10 == 0)
+        dvz_screenshot_async(canvas, false, _screenshot_async_callback, ev.user_data);
+}
+
+int test_canvas_screenshot_async(TestContext* tc)
+{
+    DvzApp* app = tc->app;
+
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, WIDTH, HEIGHT, 0);
+    dvz_canvas_clear_color(canvas, 0, 1, 0);
+
+    // Number of correct and wrong screenshots.
+    int count[2] = {0};
+    dvz_event_callback(
+        canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _frame_screenshot_callback, count);
+
+    dvz_app_run(app, 60);
+    AT(count[0] >= 5);
+    AT(count[1] == 0);
+
+    dvz_canvas_destroy(canvas);
+    return 0;
+}
+
+
+
+static void _pick_batch_callback(
+    DvzCanvas* canvas, uint32_t n, DvzPickResult* results, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(results != NULL);
+    int* count = (int*)user_data;
+    ASSERT(count != NULL);
+
+    // The canvas is green, including at the clipped positions.
+    int32_t* picked = NULL;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ASSERT(results[i].latency >= 0);
+        picked = results[i].picked;
+        if (picked[0] == 0 && picked[1] == 255 && picked[2] == 0)
+            count[0]++;
+        else
+            count[1]++;
+    }
+}
+
+static void _frame_pick_batch_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    uvec2 positions[] = {{0, 0}, {WIDTH / 2, HEIGHT / 2}, {WIDTH - 1, HEIGHT - 1}, {1000000, 5}};
+    if (ev.u.f.idx % 5 == 0)
+        dvz_canvas_pick_batch(canvas, 4, positions, _pick_batch_callback, ev.user_data);
+}
+
+int test_canvas_pick_batch(TestContext* tc)
+{
+    DvzApp* app = tc->app;
+
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, WIDTH, HEIGHT, 0);
+    dvz_canvas_clear_color(canvas, 0, 1, 0);
+
+    // Too many queries.
+    uvec2 positions[DVZ_MAX_PICK_QUERIES + 1] = {0};
+    AT(!dvz_canvas_pick_batch(canvas, DVZ_MAX_PICK_QUERIES + 1, positions, NULL, NULL));
+
+    // Number of correct and wrong picked values.
+    int count[2] = {0};
+    dvz_event_callback(
+        canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _frame_pick_batch_callback, count);
+
+    dvz_app_run(app, 60);
+    AT(count[0] >= 4 * 5);
+    AT(count[1] == 0);
+
+    dvz_canvas_destroy(canvas);
+    return 0;
+}
+
+
+
 static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
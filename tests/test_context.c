@@ -8,6 +8,106 @@
 /*  Utils                                                                                        */
 /*************************************************************************************************/
 
+static DvzMemoryStats _memory_stats(DvzGpu* gpu)
+{
+    DvzMemoryStats stats = {0}, heap_stats = {0};
+    for (uint32_t i = 0; i < gpu->memory_properties.memoryHeapCount; i++)
+    {
+        heap_stats = dvz_gpu_memory_stats(gpu, i);
+        stats.used += heap_stats.used;
+        stats.allocation_count += heap_stats.allocation_count;
+    }
+    return stats;
+}
+
+
+
+
+
+/*************************************************************************************************/
+/*  Context                                                                                      */
+/*************************************************************************************************/
+
+int test_context_lazy(TestContext* tc)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    dvz_gpu_default(gpu, NULL);
+
+    // The context creation is cheap as the default resources are created on first use.
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    DvzContext* ctx = dvz_context(gpu);
+    double elapsed = _clock_get(&clock);
+    log_debug("context created in %.3f ms", elapsed * 1000);
+    AT(elapsed < 0.25);
+
+    // No device memory has been allocated yet.
+    DvzMemoryStats stats = _memory_stats(gpu);
+    AT(stats.used == 0);
+    AT(stats.allocation_count == 0);
+    AT(ctx->font_atlas.font_texture == NULL);
+    AT(ctx->color_texture.texture == NULL);
+    AT(ctx->transfer_texture == NULL);
+
+    // Smaller vertex buffer.
+    DvzContextConfig config = {0};
+    config.buffer_sizes[DVZ_BUFFER_TYPE_VERTEX] = 1024 * 1024;
+    dvz_context_config(ctx, config);
+    AT(ctx->config.buffer_sizes[DVZ_BUFFER_TYPE_STORAGE] == DVZ_BUFFER_TYPE_STORAGE_SIZE);
+
+    // Only the vertex buffer is created when allocating vertex regions.
+    DvzBufferRegions br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_VERTEX, 1, 1024);
+    AT(br.buffer->size == 1024 * 1024);
+    stats = _memory_stats(gpu);
+    AT(stats.allocation_count == 1);
+    AT(stats.used >= 1024 * 1024);
+    AT(stats.used < DVZ_BUFFER_TYPE_VERTEX_SIZE);
+
+    // The colormap texture is created and uploaded on demand.
+    DvzTexture* texture = dvz_context_color_texture(ctx);
+    AT(texture != NULL);
+    AT(dvz_context_color_texture(ctx) == texture);
+    AT(ctx->font_atlas.font_texture == NULL);
+
+    dvz_app_destroy(app);
+    return 0;
+}
+
+
+
+int test_context_reset(TestContext* tc)
+{
+    DvzContext* ctx = tc->context;
+    ASSERT(ctx != NULL);
+
+    // Only the vertex buffer is created, the other default buffers are never used.
+    DvzBufferRegions br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_VERTEX, 1, 1024);
+    AT(dvz_obj_is_created(&br.buffer->obj));
+
+    // The reset releases all default buffers, and declares them again in the same slots.
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        dvz_context_reset(ctx);
+        AT(ctx->buffers.count == DVZ_BUFFER_TYPE_COUNT);
+        DvzBuffer* buffer = NULL;
+        for (uint32_t i = 0; i < DVZ_BUFFER_TYPE_COUNT; i++)
+        {
+            buffer = (DvzBuffer*)dvz_container_get(&ctx->buffers, i);
+            AT(buffer != NULL);
+            AT(buffer->type == (DvzBufferType)i);
+            AT(!dvz_obj_is_created(&buffer->obj));
+        }
+    }
+
+    // The default buffers are created on first use after the reset.
+    br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, 1024);
+    AT(br.buffer == dvz_container_get(&ctx->buffers, DVZ_BUFFER_TYPE_STORAGE));
+    AT(dvz_obj_is_created(&br.buffer->obj));
+
+    return 0;
+}
+
 
 
 /*************************************************************************************************/
@@ -51,6 +151,53 @@ int test_context_buffer(TestContext* tc)
 
 
 
+int test_context_buffer_free(TestContext* tc)
+{
+    DvzContext* ctx = tc->context;
+    ASSERT(ctx != NULL);
+
+    DvzBufferRegions br_a = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, 1024);
+    DvzBufferRegions br_b = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, 1024);
+    DvzBufferRegions br_c = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, 256);
+    DvzBuffer* buffer = br_a.buffer;
+    VkDeviceSize offset_a = br_a.offsets[0];
+    VkDeviceSize offset_b = br_b.offsets[0];
+    VkDeviceSize offset_c = br_c.offsets[0];
+    VkDeviceSize allocated = buffer->allocated_size;
+
+    // The space of a freed region is reused.
+    dvz_ctx_buffers_free(ctx, &br_b);
+    AT(br_b.buffer == NULL);
+    DvzBufferRegions br_d = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, 512);
+    AT(br_d.offsets[0] == offset_b);
+    AT(buffer->allocated_size == allocated);
+
+    // The allocated space ends with the last region that is still allocated.
+    dvz_ctx_buffers_free(ctx, &br_d);
+    dvz_ctx_buffers_free(ctx, &br_a);
+    AT(buffer->allocated_size == allocated);
+
+    // Compaction moves the owned regions and keeps their contents.
+    uint8_t data[256] = {0};
+    for (uint32_t i = 0; i < 256; i++)
+        data[i] = i;
+    dvz_upload_buffer(ctx, br_c, 0, 256, data);
+    dvz_ctx_buffers_owner(ctx, &br_c, NULL, NULL);
+    AT(dvz_ctx_buffers_compact(ctx, DVZ_BUFFER_TYPE_STORAGE) == 1);
+    AT(br_c.offsets[0] == offset_a);
+    AT(br_c.offsets[0] < offset_c);
+    AT(buffer->allocated_size == offset_a + 256);
+
+    uint8_t data_2[256] = {0};
+    dvz_download_buffer(ctx, br_c, 0, 256, data_2);
+    AT(memcmp(data, data_2, 256) == 0);
+
+    dvz_ctx_buffers_free(ctx, &br_c);
+    return 0;
+}
+
+
+
 int test_context_transfer_buffer(TestContext* tc)
 {
     DvzContext* ctx = tc->context;
@@ -67,14 +214,61 @@ int test_context_transfer_buffer(TestContext* tc)
 
     // NOTE: when the app main loop is not running (which is the case here), these transfer
     // functions process the transfers immediately.
-    dvz_upload_buffer(ctx, br, 64, 32, data);
+    uint64_t ticket = dvz_upload_buffer(ctx, br, 64, 32, data);
+    AT(dvz_transfer_done(ctx, ticket));
 
     // Download data.
     uint8_t data_2[32] = {0};
-    dvz_download_buffer(ctx, br, 64, 32, data_2);
+    AT(dvz_download_buffer(ctx, br, 64, 32, data_2) == ticket + 1);
     for (uint32_t i = 0; i < 32; i++)
         AT(data_2[i] == i);
 
+    // Emulate the event loop: the transfers are enqueued, then processed in order in a single
+    // asynchronous batch.
+    ASSERT(ctx->gpu->app != NULL);
+    ctx->gpu->app->is_running = true;
+    data[64] = 100;
+    memset(data_2, 0, sizeof(data_2));
+    dvz_copy_buffer(ctx, br, 64, br, 0, 32);
+    dvz_upload_buffer(ctx, br, 0, 1, &data[64]);
+    ticket = dvz_download_buffer(ctx, br, 0, 32, data_2);
+    AT(!dvz_transfer_done(ctx, ticket));
+    dvz_transfer_wait(ctx, ticket);
+    AT(dvz_transfer_done(ctx, ticket));
+    ctx->gpu->app->is_running = false;
+
+    AT(data_2[0] == 100);
+    for (uint32_t i = 1; i < 32; i++)
+        AT(data_2[i] == i);
+
+    return 0;
+}
+
+
+
+int test_context_transfer_large(TestContext* tc)
+{
+    DvzContext* ctx = tc->context;
+    ASSERT(ctx != NULL);
+
+    // Transfer larger than the staging buffer, streamed in chunks.
+    VkDeviceSize size = ctx->batch.ring.size + 3 * DVZ_TRANSFER_CHUNK_SIZE + 17;
+    DvzBufferRegions br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, size);
+
+    uint8_t* data = (uint8_t*)calloc(size, 1);
+    for (uint64_t i = 0; i < size; i++)
+        data[i] = (uint8_t)(i % 251);
+    dvz_upload_buffer(ctx, br, 0, size, data);
+
+    uint8_t* data_2 = (uint8_t*)calloc(size, 1);
+    dvz_download_buffer(ctx, br, 0, size, data_2);
+    AT(memcmp(data, data_2, size) == 0);
+
+    // The staging ring is entirely released once the transfers have completed.
+    AT(ctx->batch.ring.used == 0);
+
+    FREE(data);
+    FREE(data_2);
     return 0;
 }
 
@@ -229,7 +423,7 @@ int test_context_colormap_custom(TestContext* tc)
     // Check that the GPU texture has been updated.
     cvec4* arr = calloc(256 * 256, sizeof(cvec4));
     dvz_texture_download(
-        ctx->color_texture.texture, DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET, //
+        dvz_context_color_texture(ctx), DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET, //
         256 * 256 * sizeof(cvec4), arr);
     dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
     cvec2 ij = {0};
@@ -770,7 +770,7 @@ int test_graphics_text(TestContext* tc)
     ASSERT(glyphs != NULL);
 
     // Font atlas
-    DvzFontAtlas* atlas = &context->font_atlas;
+    DvzFontAtlas* atlas = dvz_context_font_atlas(context);
 
     DvzGraphicsTextParams params = {0};
     params.grid_size[0] = (int32_t)atlas->rows;
@@ -938,7 +938,7 @@ int test_graphics_image_cmap(TestContext* tc)
     // Graphics bindings.
     _graphics_bindings(&tg);
     _graphics_params(&tg, sizeof(DvzGraphicsImageCmapParams), &params);
-    dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 1, context->color_texture.texture);
+    dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 1, dvz_context_color_texture(context));
     dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 2, texture);
 
     // Run the test.
@@ -996,7 +996,7 @@ int test_graphics_volume_slice(TestContext* tc)
     // Graphics bindings.
     _graphics_bindings(&tg);
     _graphics_params(&tg, sizeof(DvzGraphicsVolumeSliceParams), &params);
-    dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 1, context->color_texture.texture);
+    dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 1, dvz_context_color_texture(context));
     dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 2, texture);
 
     // Arcball rotation.
@@ -1056,7 +1056,8 @@ int test_graphics_volume_1(TestContext* tc)
     _graphics_params(&tg, sizeof(DvzGraphicsVolumeParams), &params);
     dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 1, texture);
     dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 2, texture);
-    dvz_bindings_texture(&tg.bindings, DVZ_USER_BINDING + 3, context->transfer_texture);
+    dvz_bindings_texture(
+        &tg.bindings, DVZ_USER_BINDING + 3, dvz_context_transfer_texture(context));
 
     // Arcball rotation.
     vec3 angles = {+M_PI / 6, -M_PI / 4, 0};
@@ -1137,3 +1138,180 @@ int test_graphics_mesh(TestContext* tc)
 
     return res;
 }
+
+
+
+/*************************************************************************************************/
+/*  Pipeline cache                                                                               */
+/*************************************************************************************************/
+
+// Create a canvas on a fresh offscreen app. The pipeline cache is only persisted to the given
+// path, if any.
+static DvzCanvas* _graphics_offscreen_canvas(const char* cache_path)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    dvz_gpu_pipeline_cache(gpu, cache_path);
+    return dvz_canvas(gpu, WIDTH, HEIGHT, 0);
+}
+
+
+
+// Create all builtin graphics pipelines on a fresh app, and return the elapsed time. The size of
+// the pipeline cache data loaded from disk is returned in `loaded`.
+static double _graphics_builtin_startup(const char* cache_path, size_t* loaded)
+{
+    DvzGraphicsType types[] = {
+        DVZ_GRAPHICS_POINT,           DVZ_GRAPHICS_LINE,            DVZ_GRAPHICS_LINE_STRIP,
+        DVZ_GRAPHICS_TRIANGLE,        DVZ_GRAPHICS_TRIANGLE_STRIP,  DVZ_GRAPHICS_TRIANGLE_FAN,
+        DVZ_GRAPHICS_MARKER,          DVZ_GRAPHICS_SEGMENT,         DVZ_GRAPHICS_PATH,
+        DVZ_GRAPHICS_TEXT,            DVZ_GRAPHICS_IMAGE,           DVZ_GRAPHICS_IMAGE_CMAP,
+        DVZ_GRAPHICS_VOLUME_SLICE,    DVZ_GRAPHICS_VOLUME,          DVZ_GRAPHICS_MESH,
+    };
+
+    DvzCanvas* canvas = _graphics_offscreen_canvas(cache_path);
+    ASSERT(loaded != NULL);
+    *loaded = canvas->gpu->pipeline_cache_loaded;
+
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < ARRAY_COUNT(types); i++)
+        dvz_graphics_builtin(canvas, types[i], 0);
+    double elapsed = _clock_get(&clock);
+
+    // The pipeline cache is saved to disk when the GPU is destroyed.
+    dvz_app_destroy(canvas->app);
+    return elapsed;
+}
+
+
+
+int test_graphics_pipeline_cache(TestContext* tc)
+{
+    // The cache file is created in a temporary directory, which is not shared with the other
+    // tests and leaves the user cache directory untouched.
+    char dir[] = "/tmp/datoviz_cache_XXXXXX";
+    AT(mkdtemp(dir) != NULL);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/pipeline_cache.bin", dir);
+    size_t loaded = 0;
+
+    // Cold startup: the cache file is created.
+    double cold = _graphics_builtin_startup(path, &loaded);
+    AT(loaded == 0);
+    AT(file_exists(path));
+    AT(file_size(path) > 32);
+
+    // Warm startup: the pipelines are created from the cache file.
+    double warm = _graphics_builtin_startup(path, &loaded);
+    AT(loaded > 32);
+    log_info("builtin graphics creation: cold %.1f ms, warm %.1f ms", cold * 1000, warm * 1000);
+
+    // An invalid cache file is discarded.
+    FILE* f = fopen(path, "wb");
+    fwrite("invalid", 1, 7, f);
+    fclose(f);
+    _graphics_builtin_startup(path, &loaded);
+    AT(loaded == 0);
+    AT(file_size(path) > 32);
+
+    remove(path);
+    rmdir(dir);
+    return 0;
+}
+
+
+
+int test_graphics_warmup(TestContext* tc)
+{
+    DvzCanvas* canvas = _graphics_offscreen_canvas(NULL);
+    uint32_t count = canvas->graphics.count;
+
+    DvzGraphicsSpec specs[] = {
+        {DVZ_GRAPHICS_MARKER, 0}, {DVZ_GRAPHICS_SEGMENT, 0}, {DVZ_GRAPHICS_PATH, 0},
+        {DVZ_GRAPHICS_TEXT, 0},   {DVZ_GRAPHICS_IMAGE, 0},   {DVZ_GRAPHICS_MESH, 0},
+    };
+
+    // Background warm-up.
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    dvz_graphics_warmup(canvas, ARRAY_COUNT(specs), specs, true);
+    log_info("background warm-up returned after %.1f ms", _clock_get(&clock) * 1000);
+    dvz_graphics_warmup_wait(canvas);
+    log_info("warm-up of %d pipelines: %.1f ms", ARRAY_COUNT(specs), _clock_get(&clock) * 1000);
+
+    // All pipelines have been created.
+    AT(canvas->graphics.count == count + ARRAY_COUNT(specs));
+    DvzContainerIterator iter = dvz_container_iterator(&canvas->graphics);
+    DvzGraphics* graphics = NULL;
+    while (iter.item != NULL)
+    {
+        graphics = iter.item;
+        AT(dvz_obj_is_created(&graphics->obj));
+        dvz_container_iter(&iter);
+    }
+
+    // The existing pipelines are not created again.
+    dvz_graphics_warmup(canvas, ARRAY_COUNT(specs), specs, false);
+    AT(canvas->graphics.count == count + ARRAY_COUNT(specs));
+
+    // Destroying the canvas during a background warm-up waits for the workers.
+    DvzGraphicsSpec specs_depth[] = {
+        {DVZ_GRAPHICS_POINT, DVZ_GRAPHICS_FLAGS_DEPTH_TEST},
+        {DVZ_GRAPHICS_TRIANGLE, DVZ_GRAPHICS_FLAGS_DEPTH_TEST},
+    };
+    dvz_graphics_warmup(canvas, ARRAY_COUNT(specs_depth), specs_depth, true);
+
+    dvz_app_destroy(canvas->app);
+    return 0;
+}
+
+
+
+int test_graphics_registry(TestContext* tc)
+{
+    DvzCanvas* canvas = _graphics_offscreen_canvas(NULL);
+    DvzGraphicsRegistry* registry = &canvas->graphics_registry;
+    uint32_t count = canvas->graphics.count;
+    uint64_t hits = registry->hits;
+    uint64_t misses = registry->misses;
+
+    // The same type and flags share the same pipeline.
+    const uint32_t n = 100;
+    DvzGraphics* marker = dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, 0);
+    for (uint32_t i = 1; i < n; i++)
+        AT(dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, 0) == marker);
+    AT(canvas->graphics.count == count + 1);
+    AT(registry->hits == hits + n - 1);
+    AT(registry->misses == misses + 1);
+
+    // Different types or flags lead to different pipelines.
+    DvzGraphics* path = dvz_graphics_builtin(canvas, DVZ_GRAPHICS_PATH, 0);
+    DvzGraphics* marker_depth =
+        dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, DVZ_GRAPHICS_FLAGS_DEPTH_TEST);
+    AT(path != marker);
+    AT(marker_depth != marker);
+    AT(canvas->graphics.count == count + 3);
+    AT(dvz_graphics_builtin(canvas, DVZ_GRAPHICS_PATH, 0) == path);
+
+    // The pipeline is destroyed when the last user goes.
+    for (uint32_t i = 0; i < n - 1; i++)
+        dvz_graphics_release(canvas, marker);
+    AT(dvz_obj_is_created(&marker->obj));
+    dvz_graphics_release(canvas, marker);
+    AT(!dvz_obj_is_created(&marker->obj));
+
+    // The other pipelines are still registered.
+    AT(dvz_graphics_builtin(canvas, DVZ_GRAPHICS_PATH, 0) == path);
+    AT(dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, DVZ_GRAPHICS_FLAGS_DEPTH_TEST) ==
+       marker_depth);
+
+    // A new request after destruction creates a new pipeline.
+    misses = registry->misses;
+    marker = dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, 0);
+    AT(dvz_obj_is_created(&marker->obj));
+    AT(registry->misses == misses + 1);
+
+    dvz_app_destroy(canvas->app);
+    return 0;
+}
@@ -59,6 +59,17 @@ static DvzVisual* _add_visual(DvzPanel* panel)
 
 
 
+static bool _panel_cmds_valid(DvzPanel* panel, uint32_t img_count)
+{
+    ASSERT(panel != NULL);
+    for (uint32_t i = 0; i < img_count; i++)
+        if (!panel->cmds_valid[i])
+            return false;
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Visuals tests                                                                                */
 /*************************************************************************************************/
@@ -295,3 +306,226 @@ int test_scene_dynamic_axes(TestContext* tc)
     _dark_background(canvas);
     return res;
 }
+
+
+
+int test_scene_zero_alloc(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    _add_visual(panel);
+
+    // Warm up: the first frames and the first interactions fill the pools and arenas.
+    vec2 pos = {0};
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        pos[0] = pos[1] = 10 * i;
+        dvz_event_mouse_move(canvas, pos, 0);
+        dvz_event_mouse_wheel(canvas, pos, (vec2){0, 1}, 0);
+        dvz_app_run(canvas->app, 1);
+    }
+
+    // Steady state: a static scene with interaction must not allocate anything.
+    uint64_t count = dvz_alloc_count();
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        pos[0] = pos[1] = 100 - 5 * i;
+        dvz_event_mouse_move(canvas, pos, 0);
+        dvz_event_mouse_wheel(canvas, pos, (vec2){0, i % 2 ? 1 : -1}, 0);
+        dvz_app_run(canvas->app, 1);
+    }
+    count = dvz_alloc_count() - count;
+    log_debug("%d allocations during 20 frames", (int)count);
+    AT(count == 0);
+
+    dvz_scene_destroy(scene);
+    return 0;
+}
+
+
+
+int test_scene_on_demand(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = _add_visual(panel);
+    dvz_canvas_on_demand(canvas, true);
+
+    // The first frames upload the data and fill the command buffers.
+    dvz_app_run(canvas->app, 10);
+    uint64_t frame_idx = canvas->frame_idx;
+    AT(frame_idx > 0);
+    AT(panel->mvp_valid != 0);
+
+    // Nothing changes: no frame is rendered.
+    dvz_app_run(canvas->app, 10);
+    AT(canvas->frame_idx == frame_idx);
+    AT(canvas->idle);
+
+    // An input event requires a new frame.
+    dvz_event_mouse_wheel(canvas, (vec2){10, 10}, (vec2){0, 1}, 0);
+    dvz_app_run(canvas->app, 1);
+    AT(canvas->frame_idx > frame_idx);
+    dvz_app_run(canvas->app, 10);
+    frame_idx = canvas->frame_idx;
+
+    // A visual data change requires a new frame.
+    _point_data(visual, 50);
+    dvz_app_run(canvas->app, 1);
+    AT(canvas->frame_idx > frame_idx);
+    dvz_app_run(canvas->app, 10);
+    frame_idx = canvas->frame_idx;
+
+    // The MVP is uploaded to the swapchain images that do not have it yet.
+    panel->mvp_valid = 0;
+    dvz_canvas_dirty(canvas);
+    dvz_app_run(canvas->app, 1);
+    AT(canvas->frame_idx > frame_idx);
+    AT(panel->mvp_valid == 1u << canvas->swapchain.img_idx);
+
+    dvz_canvas_on_demand(canvas, false);
+    dvz_scene_destroy(scene);
+    return 0;
+}
+
+
+
+int test_scene_partial_refill(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 2);
+    DvzPanel* panel0 = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzPanel* panel1 = dvz_scene_panel(scene, 0, 1, DVZ_CONTROLLER_PANZOOM, 0);
+    _add_visual(panel0);
+    DvzVisual* visual = _add_visual(panel1);
+    uint32_t img_count = canvas->swapchain.img_count;
+
+    // The first frames record the secondary command buffers of both panels.
+    dvz_app_run(canvas->app, 10);
+    AT(panel0->cmds_panel.secondary);
+    AT(_panel_cmds_valid(panel0, img_count));
+    AT(_panel_cmds_valid(panel1, img_count));
+
+    // Changing the vertex count of a visual only records the commands of its panel again.
+    uint64_t recorded0 = panel0->cmds_recorded;
+    uint64_t recorded1 = panel1->cmds_recorded;
+    _point_data(visual, 100);
+    dvz_app_run(canvas->app, 1);
+    AT(!canvas->refills.full);
+    AT(_panel_cmds_valid(panel0, img_count));
+    AT(panel1->cmds_valid[canvas->swapchain.img_idx]);
+
+    dvz_app_run(canvas->app, 10);
+    AT(_panel_cmds_valid(panel1, img_count));
+    AT(atomic_load(&canvas->refills.status) == DVZ_REFILL_NONE);
+    AT(panel0->cmds_recorded == recorded0);
+    AT(panel1->cmds_recorded > recorded1);
+
+    dvz_scene_destroy(scene);
+    return 0;
+}
+
+
+
+int test_scene_parallel_refill(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 2, 2);
+    DvzPanel* panels[4] = {0};
+    DvzVisual* visual = NULL;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        panels[i] = dvz_scene_panel(scene, i / 2, i % 2, DVZ_CONTROLLER_PANZOOM, 0);
+        visual = _add_visual(panels[i]);
+    }
+    uint32_t img_count = canvas->swapchain.img_count;
+    dvz_scene_record_threads(scene, 2);
+
+    // Each panel is recorded by a fixed thread, with the command pool of that thread.
+    dvz_app_run(canvas->app, 10);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        AT(_panel_cmds_valid(panels[i], img_count));
+        AT(panels[i]->cmds_thread == i % 2);
+    }
+
+    // Partial refills only record the invalidated panels.
+    _point_data(visual, 100);
+    dvz_app_run(canvas->app, 10);
+    for (uint32_t i = 0; i < 4; i++)
+        AT(_panel_cmds_valid(panels[i], img_count));
+    uint8_t* rgb_threads = dvz_screenshot(canvas, false);
+
+    // Back to the recording on the main thread.
+    dvz_scene_record_threads(scene, 0);
+    dvz_app_run(canvas->app, 10);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        AT(_panel_cmds_valid(panels[i], img_count));
+        AT(panels[i]->cmds_thread == UINT32_MAX);
+    }
+
+    // The rendered image does not depend on the number of recording threads.
+    uint8_t* rgb_main = dvz_screenshot(canvas, false);
+    uvec2 size = {0};
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, size);
+    AT(memcmp(rgb_threads, rgb_main, size[0] * size[1] * 3) == 0);
+    FREE(rgb_threads);
+    FREE(rgb_main);
+
+    dvz_scene_destroy(scene);
+    return 0;
+}
+
+
+
+int test_scene_indirect_draws(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = _add_visual(panel);
+    uint32_t img_count = canvas->swapchain.img_count;
+    uint32_t all_images = (1u << img_count) - 1;
+
+    dvz_app_run(canvas->app, 10);
+    AT(visual->br_draw.buffer != NULL);
+    AT(visual->draw_args[0].draw.vertexCount == 50);
+    AT(visual->draw_args_valid == all_images);
+    AT(_panel_cmds_valid(panel, img_count));
+
+    // Fewer items: the vertex buffer is large enough, only the draw arguments change.
+    _point_data(visual, 30);
+    dvz_app_run(canvas->app, 1);
+    AT(visual->draw_args[0].draw.vertexCount == 30);
+    AT(visual->draw_args_valid == 1u << canvas->swapchain.img_idx);
+    AT(_panel_cmds_valid(panel, img_count));
+    dvz_app_run(canvas->app, 10);
+    AT(visual->draw_args_valid == all_images);
+
+    // Hiding and showing the visual does not refill the command buffers either.
+    dvz_visual_visible(visual, false);
+    AT(visual->draw_args[0].draw.vertexCount == 0);
+    dvz_app_run(canvas->app, 10);
+    AT(_panel_cmds_valid(panel, img_count));
+    dvz_visual_visible(visual, true);
+    AT(visual->draw_args[0].draw.vertexCount == 30);
+    dvz_app_run(canvas->app, 10);
+    AT(_panel_cmds_valid(panel, img_count));
+    AT(atomic_load(&canvas->refills.status) == DVZ_REFILL_NONE);
+
+    dvz_scene_destroy(scene);
+    return 0;
+}
@@ -1,3 +1,6 @@
+#include <sched.h>
+
+#include "../include/datoviz/app.h"
 #include "../include/datoviz/array.h"
 #include "../include/datoviz/common.h"
 #include "../include/datoviz/fifo.h"
@@ -62,7 +65,7 @@ int test_utils_container(TestContext* tc)
     uint32_t capacity = 2;
 
     DvzContainer container = dvz_container(capacity, sizeof(TestObject), 0);
-    AT(container.items != NULL);
+    AT(container.chunks[0] != NULL);
     AT(container.item_size == sizeof(TestObject));
     AT(container.capacity == capacity);
     AT(container.count == 0);
@@ -72,9 +75,9 @@ int test_utils_container(TestContext* tc)
     AT(a != NULL);
     a->x = 1;
     dvz_obj_created(&a->obj);
-    AT(container.items[0] != NULL);
-    AT(container.items[0] == a);
-    AT(container.items[1] == NULL);
+    AT(dvz_container_get(&container, 0) != NULL);
+    AT(dvz_container_get(&container, 0) == a);
+    AT(dvz_container_get(&container, 1) == NULL);
     AT(container.capacity == capacity);
     AT(container.count == 1);
 
@@ -83,24 +86,34 @@ int test_utils_container(TestContext* tc)
     AT(b != NULL);
     b->x = 2;
     dvz_obj_created(&b->obj);
-    AT(container.items[1] != NULL);
-    AT(container.items[1] == b);
+    AT(dvz_container_get(&container, 1) != NULL);
+    AT(dvz_container_get(&container, 1) == b);
     AT(container.capacity == capacity);
     AT(container.count == 2);
 
+    // Handles.
+    DvzHandle handle = dvz_container_handle(&container, a);
+    AT(handle != DVZ_HANDLE_NONE);
+    AT(dvz_container_resolve(&container, handle) == a);
+
     // Destroy the first object.
     dvz_obj_destroyed(&a->obj);
+    AT(dvz_container_resolve(&container, handle) == NULL);
 
     // Allocate another one.
     TestObject* c = dvz_container_alloc(&container);
     AT(c != NULL);
     c->x = 3;
     dvz_obj_created(&c->obj);
-    AT(container.items[0] != NULL);
-    AT(container.items[0] == c);
+    AT(dvz_container_get(&container, 0) != NULL);
+    AT(dvz_container_get(&container, 0) == c);
     AT(container.capacity == capacity);
     AT(container.count == 2);
 
+    // The slot has been reused, but the handle to the destroyed object remains invalid.
+    AT(dvz_container_resolve(&container, handle) == NULL);
+    AT(dvz_container_resolve(&container, dvz_container_handle(&container, c)) == c);
+
     // Allocate another one.
     // Container will be reallocated.
     TestObject* d = dvz_container_alloc(&container);
@@ -109,9 +122,13 @@ int test_utils_container(TestContext* tc)
     dvz_obj_created(&d->obj);
     AT(container.capacity == 4);
     AT(container.count == 3);
-    AT(container.items[2] != NULL);
-    AT(container.items[2] == d);
-    AT(container.items[3] == NULL);
+    AT(dvz_container_get(&container, 2) != NULL);
+    AT(dvz_container_get(&container, 2) == d);
+    AT(dvz_container_get(&container, 3) == NULL);
+
+    // The existing objects have not been moved.
+    AT(b->x == 2);
+    AT(c->x == 3);
 
     for (uint32_t k = 0; k < 10; k++)
     {
@@ -439,6 +456,170 @@ int test_utils_deq_2(TestContext* tc)
 
 
 
+#define RING_PRODUCERS 4
+#define RING_ITEMS      100000
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t idx;
+    uint8_t payload[56]; // typical size of a small event
+} TestRingItem;
+
+typedef struct
+{
+    DvzFifo* fifo;
+    DvzRing* ring;
+    uint32_t producer;
+} TestRingProducer;
+
+static void* _ring_producer(void* arg)
+{
+    TestRingProducer* p = arg;
+    TestRingItem item = {0};
+    item.producer = p->producer;
+    for (uint32_t i = 0; i < RING_ITEMS; i++)
+    {
+        item.idx = i;
+        while (!dvz_ring_enqueue(p->ring, &item))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void* _fifo_producer(void* arg)
+{
+    TestRingProducer* p = arg;
+    TestRingItem* item = NULL;
+    for (uint32_t i = 0; i < RING_ITEMS; i++)
+    {
+        // NOTE: the FIFO queue cannot grow beyond DVZ_MAX_FIFO_CAPACITY.
+        while (dvz_fifo_size(p->fifo) >= DVZ_MAX_FIFO_CAPACITY / 2)
+            sched_yield();
+        // Like the existing callers, every item is copied on the heap.
+        item = calloc(1, sizeof(TestRingItem));
+        item->producer = p->producer;
+        item->idx = i;
+        dvz_fifo_enqueue(p->fifo, item);
+    }
+    return NULL;
+}
+
+int test_utils_ring(TestContext* tc)
+{
+    DvzRing ring = dvz_ring(6, sizeof(TestRingItem));
+    AT(ring.capacity == 8);
+    AT(dvz_ring_size(&ring) == 0);
+
+    // Bounded queue.
+    TestRingItem item = {0};
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        item.idx = i;
+        AT(dvz_ring_enqueue(&ring, &item));
+    }
+    AT(!dvz_ring_enqueue(&ring, &item));
+    AT(dvz_ring_size(&ring) == 8);
+
+    // Batch dequeue.
+    TestRingItem items[8] = {0};
+    AT(dvz_ring_dequeue_batch(&ring, items, 5, false) == 5);
+    for (uint32_t i = 0; i < 5; i++)
+        AT(items[i].idx == i);
+    AT(dvz_ring_dequeue_batch(&ring, items, 8, false) == 3);
+    AT(items[0].idx == 5 && items[2].idx == 7);
+    AT(!dvz_ring_dequeue(&ring, &item, false));
+
+    // Several producer threads, the items of every producer are dequeued in order.
+    pthread_t threads[RING_PRODUCERS] = {0};
+    TestRingProducer producers[RING_PRODUCERS] = {0};
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+    {
+        producers[i].ring = &ring;
+        producers[i].producer = i;
+        pthread_create(&threads[i], NULL, _ring_producer, &producers[i]);
+    }
+    uint32_t next[RING_PRODUCERS] = {0};
+    uint32_t count = 0;
+    uint32_t n = 0;
+    while (count < RING_PRODUCERS * RING_ITEMS)
+    {
+        n = dvz_ring_dequeue_batch(&ring, items, 8, true);
+        AT(n > 0);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            AT(items[i].idx == next[items[i].producer]);
+            next[items[i].producer]++;
+        }
+        count += n;
+    }
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    AT(dvz_ring_size(&ring) == 0);
+
+    dvz_ring_destroy(&ring);
+    return 0;
+}
+
+
+
+// Contention benchmark: several producer threads and a single consumer, with the mutex-based
+// FIFO queue and with the lock-free ring.
+int test_utils_ring_bench(TestContext* tc)
+{
+    pthread_t threads[RING_PRODUCERS] = {0};
+    TestRingProducer producers[RING_PRODUCERS] = {0};
+    uint32_t total = RING_PRODUCERS * RING_ITEMS;
+    uint32_t count = 0;
+    DvzClock clock = {0};
+
+    // Mutex-based FIFO queue.
+    DvzFifo fifo = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+    {
+        producers[i].fifo = &fifo;
+        producers[i].producer = i;
+        pthread_create(&threads[i], NULL, _fifo_producer, &producers[i]);
+    }
+    TestRingItem* item = NULL;
+    for (count = 0; count < total; count++)
+    {
+        item = dvz_fifo_dequeue(&fifo, true);
+        AT(item != NULL);
+        FREE(item);
+    }
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    double fifo_time = _clock_get(&clock);
+    dvz_fifo_destroy(&fifo);
+
+    // Lock-free ring with batch dequeue.
+    DvzRing ring = dvz_ring(DVZ_MAX_FIFO_CAPACITY, sizeof(TestRingItem));
+    TestRingItem items[64] = {0};
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+    {
+        producers[i].ring = &ring;
+        pthread_create(&threads[i], NULL, _ring_producer, &producers[i]);
+    }
+    for (count = 0; count < total;)
+        count += dvz_ring_dequeue_batch(&ring, items, 64, true);
+    for (uint32_t i = 0; i < RING_PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    double ring_time = _clock_get(&clock);
+    dvz_ring_destroy(&ring);
+
+    log_info(
+        "%d producers, %d items: FIFO queue %.1f ms (%.1f M items/s), lock-free ring %.1f ms "
+        "(%.1f M items/s)",
+        RING_PRODUCERS, total, fifo_time * 1000, total / fifo_time * 1e-6, ring_time * 1000,
+        total / ring_time * 1e-6);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Array tests                                                                                  */
 /*************************************************************************************************/
@@ -683,6 +864,56 @@ int test_utils_array_cast(TestContext* tc)
 
 
 
+int test_utils_array_column(TestContext* tc)
+{
+    // Record array with a vec3 column between two other fields.
+    typedef struct
+    {
+        uint8_t a;
+        vec3 pos;
+        float c;
+    } TestVertex;
+
+    const uint32_t n = 5, reps = 3, count = 20;
+    dvec3 pos[5] = {0};
+    for (uint32_t i = 0; i < n; i++)
+        for (uint32_t k = 0; k < 3; k++)
+            pos[i][k] = (i + 1) * (k + 1) / 3.0;
+
+    DvzArray arr = dvz_array_struct(count, sizeof(TestVertex));
+    TestVertex* item = NULL;
+
+    // Fused dvec3 to vec3 cast, repeated.
+    dvz_array_column(
+        &arr, offsetof(TestVertex, pos), sizeof(dvec3), 0, count, n, pos, DVZ_DTYPE_DVEC3,
+        DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_REPEAT, reps);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        item = dvz_array_item(&arr, i);
+        AT(item->a == 0);
+        AT(item->c == 0);
+        for (uint32_t k = 0; k < 3; k++)
+            AT(item->pos[k] == (float)pos[MIN(i / reps, n - 1)][k]);
+    }
+
+    // Single copy: only the first item of each group of reps is written.
+    dvz_array_clear(&arr);
+    float c[] = {1, 2, 3};
+    dvz_array_column(
+        &arr, offsetof(TestVertex, c), sizeof(float), 0, count, 3, c, 0, 0,
+        DVZ_ARRAY_COPY_SINGLE, reps);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        item = dvz_array_item(&arr, i);
+        AT(item->c == (i % reps == 0 ? c[MIN(i / reps, 2)] : 0));
+    }
+
+    dvz_array_destroy(&arr);
+    return 0;
+}
+
+
+
 int test_utils_array_mvp(TestContext* tc)
 {
     DvzArray arr = dvz_array_struct(1, sizeof(_mvp));
@@ -910,6 +1141,113 @@ int test_utils_transforms_4(TestContext* tc)
 
 
 
+int test_utils_transforms_pos(TestContext* tc)
+{
+    // Large enough to be split across worker threads.
+    const uint32_t n = 4 * DVZ_TRANSFORM_PARALLEL_THRESHOLD + 3;
+
+    DvzDataCoords coords = {0};
+    coords.box = (DvzBox){{-10, 0, -1}, {10, 100, 1}};
+    coords.transform = DVZ_TRANSFORM_CARTESIAN;
+    DvzTransform tr = _transform_interp(coords.box, DVZ_BOX_NDC);
+
+    DvzArray pos_in = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvec3* pos = (dvec3*)pos_in.data;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        pos[i][0] = -10 + 20 * dvz_rand_float();
+        pos[i][1] = 100 * dvz_rand_float();
+        pos[i][2] = -1 + 2 * dvz_rand_float();
+    }
+
+    // DVEC3 to DVEC3.
+    DvzArray pos_out = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvz_transform_pos(coords, &pos_in, &pos_out, false);
+
+    // DVEC3 written directly to VEC3.
+    DvzArray pos_outf = dvz_array(n, DVZ_DTYPE_VEC3);
+    dvz_transform_pos(coords, &pos_in, &pos_outf, false);
+
+    dvec3 expected = {0};
+    dvec3* out = (dvec3*)pos_out.data;
+    vec3* outf = (vec3*)pos_outf.data;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        _transform_apply(&tr, pos[i], expected);
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            AC(out[i][k], expected[k], EPS);
+            AC(outf[i][k], (float)expected[k], EPS);
+        }
+    }
+
+    // FLOAT input.
+    DvzArray x_in = dvz_array(2, DVZ_DTYPE_FLOAT);
+    DvzArray x_out = dvz_array(2, DVZ_DTYPE_FLOAT);
+    ((float*)x_in.data)[0] = -10;
+    ((float*)x_in.data)[1] = 0;
+    dvz_transform_pos(coords, &x_in, &x_out, false);
+    AC(((float*)x_out.data)[0], -1, EPS);
+    AC(((float*)x_out.data)[1], 0, EPS);
+
+    dvz_array_destroy(&pos_in);
+    dvz_array_destroy(&pos_out);
+    dvz_array_destroy(&pos_outf);
+    dvz_array_destroy(&x_in);
+    dvz_array_destroy(&x_out);
+    return 0;
+}
+
+
+
+int test_utils_transforms_gpu(TestContext* tc)
+{
+    const uint32_t n = 1000;
+
+    // Box far away from 0, where float32 positions would lose precision.
+    DvzDataCoords coords = {0};
+    coords.box = (DvzBox){{1e6, -1, -1}, {1e6 + 10, 1, 1}};
+    coords.transform = DVZ_TRANSFORM_CARTESIAN;
+    coords.flags = DVZ_TRANSFORM_FLAGS_GPU;
+    AT(_is_data_gpu(&coords));
+
+    // The origin moves to the center of the box.
+    AT(_data_origin_update(&coords));
+    AT(coords.origin[0] == 1e6 + 5);
+    AT(!_data_origin_update(&coords));
+
+    DvzArray pos_in = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvec3* pos = (dvec3*)pos_in.data;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        pos[i][0] = 1e6 + 10 * dvz_rand_float();
+        pos[i][1] = -1 + 2 * dvz_rand_float();
+    }
+
+    // Positions relative to the origin, in float32 as in the vertex buffer.
+    DvzArray pos_out = dvz_array(n, DVZ_DTYPE_VEC3);
+    dvz_transform_pos(coords, &pos_in, &pos_out, false);
+
+    // Emulate the vertex shader, and compare with the CPU normalization.
+    vec4 scale = {0}, shift = {0};
+    _data_gpu_affine(&coords, scale, shift);
+    DvzTransform tr = _transform_interp(coords.box, DVZ_BOX_NDC);
+    vec3* rel = (vec3*)pos_out.data;
+    dvec3 expected = {0};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        _transform_apply(&tr, pos[i], expected);
+        for (uint32_t k = 0; k < 3; k++)
+            AC(rel[i][k] * scale[k] + shift[k], expected[k], 1e-5);
+    }
+
+    dvz_array_destroy(&pos_in);
+    dvz_array_destroy(&pos_out);
+    return 0;
+}
+
+
+
 // int test_utils_transforms_5(TestContext* tc)
 // {
 //     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
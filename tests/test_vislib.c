@@ -817,7 +817,7 @@ static int _vislib_axes(TestContext* tc, DvzAxisCoord coord, const char* name)
 
 
     // Font atlas.
-    DvzFontAtlas* atlas = &canvas->gpu->context->font_atlas;
+    DvzFontAtlas* atlas = dvz_context_font_atlas(canvas->gpu->context);
     ASSERT(atlas != NULL);
     ASSERT(atlas->font_str != NULL);
     ASSERT(strlen(atlas->font_str) > 0);
@@ -1,5 +1,6 @@
 #include "../include/datoviz/colormaps.h"
 #include "../include/datoviz/interact.h"
+#include "../include/datoviz/vislib.h"
 #include "../include/datoviz/visuals.h"
 #include "proto.h"
 #include "tests.h"
@@ -465,6 +466,183 @@ int test_visuals_partial(TestContext* tc)
 
 
 
+int test_visuals_dirty(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    // Create the visual.
+    DvzVisual visual = dvz_visual(canvas);
+    _visual_create(&visual);
+    _visual_bindings(&visual);
+
+    // Vertex data.
+    const uint32_t N = 12;
+    _visual_data(&visual, N);
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_POS, 0);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(prop->dirty.all);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(!prop->dirty.all && prop->dirty.count == 0);
+    AT(!source->dirty.all && source->dirty.count == 0);
+
+    // Successive partial updates, the adjacent ranges are coalesced.
+    dvec3 pos = {0, .5, 0};
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, 3, 2, 1, pos);
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, 5, 2, 1, pos);
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, 9, 1, 1, pos);
+    AT(!prop->dirty.all);
+    AT(prop->dirty.count == 2);
+    AT(prop->dirty.first[0] == 3 && prop->dirty.last[0] == 7);
+    AT(prop->dirty.first[1] == 9 && prop->dirty.last[1] == 10);
+
+    // Only the modified items are copied to the vertex array.
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(prop->dirty.count == 0);
+    AT(source->dirty.count == 0);
+    DvzVertex* vertex = NULL;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        vertex = dvz_array_item(&source->arr, i);
+        if ((i >= 3 && i < 7) || i == 9)
+            AT(vertex->pos[1] == .5);
+        else
+            AT(vertex->pos[1] == 0);
+    }
+
+    // Changing the number of items marks the whole array as modified.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 1, pos);
+    AT(prop->dirty.all);
+
+    _visual_destroy(&visual);
+    return 0;
+}
+
+
+
+int test_visuals_stream(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    // Create the visual.
+    DvzVisual visual = dvz_visual(canvas);
+    _visual_create(&visual);
+    _visual_bindings(&visual);
+
+    // Ring buffer with a capacity of 8 items.
+    const uint32_t N = 8;
+    dvz_visual_stream(&visual, N);
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_POS, 0);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    dvec3 pos[12] = {0};
+    cvec4 color[12] = {0};
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        pos[i][1] = i;
+        color[i][0] = color[i][3] = 255;
+    }
+
+    // Partially fill the ring buffer.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 5, pos);
+    dvz_visual_data_append(&visual, DVZ_PROP_COLOR, 0, 5, color);
+    AT(prop->arr_orig.item_count == 5);
+    AT(visual.stream_head == 5);
+    AT(visual.viewport.ring_base == 0);
+    AT(visual.viewport.ring_size == N);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == 6);
+
+    // The GPU buffer is allocated once with the full capacity.
+    DvzBufferRegions br = source->u.br;
+    AT(br.size >= (N + 1) * sizeof(DvzVertex));
+
+    // Wrap around the end of the ring buffer.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 6, &pos[5]);
+    dvz_visual_data_append(&visual, DVZ_PROP_COLOR, 0, 6, &color[5]);
+    AT(prop->arr_orig.item_count == N);
+    AT(visual.stream_head == 3);
+    AT(visual.viewport.ring_base == 3);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == N + 1);
+
+    // Once the ring buffer is full, only the new items are copied.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 1, &pos[11]);
+    dvz_visual_data_append(&visual, DVZ_PROP_COLOR, 0, 1, &color[11]);
+    AT(!prop->dirty.all);
+    AT(prop->dirty.count == 1);
+    AT(prop->dirty.first[0] == 3 && prop->dirty.last[0] == 4);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(prop->dirty.count == 0);
+    AT(source->u.br.buffer == br.buffer);
+    AT(source->u.br.offsets[0] == br.offsets[0]);
+
+    // The last item mirrors the first one.
+    const float expected[] = {8, 9, 10, 11, 4, 5, 6, 7, 8};
+    DvzVertex* vertex = NULL;
+    for (uint32_t i = 0; i < N + 1; i++)
+    {
+        vertex = dvz_array_item(&source->arr, i);
+        AT(vertex->pos[1] == expected[i]);
+    }
+
+    _visual_destroy(&visual);
+    return 0;
+}
+
+
+
+int test_visuals_stream_path(TestContext* tc)
+{
+    DvzCanvas* canvas = tc->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_PATH, 0);
+
+    // Ring buffer with a capacity of 4 points.
+    const uint32_t N = 4;
+    dvz_visual_stream(&visual, N);
+    AT(visual.stream_capacity == N);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    dvec3 pos[6] = {0};
+    for (uint32_t i = 0; i < 6; i++)
+        pos[i][1] = 10 + i;
+
+    // Wrap around the end of the ring buffer: slots 0 and 1 hold the points 4 and 5.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 4, pos);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 2, &pos[4]);
+    AT(visual.viewport.ring_base == 2);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+
+    // 4 vertices per point, and the first point is mirrored after the end of the ring buffer.
+    AT(source->arr.item_count == 4 * (N + 1));
+    DvzGraphicsPathVertex* vertex = dvz_array_item(&source->arr, 4 * N);
+    AT(memcmp(vertex, dvz_array_item(&source->arr, 0), sizeof(*vertex)) == 0);
+
+    // The neighbors of each point are taken in chronological order, across the wrap point, and
+    // the x coordinates hold the ring buffer slots of the neighbors.
+    const float expected[][4] = {
+        {13, 14, 15, 15}, {14, 15, 15, 15}, {12, 12, 13, 14}, {12, 13, 14, 15}};
+    const float slots[][4] = {{3, 0, 1, 1}, {0, 1, 1, 1}, {2, 2, 3, 0}, {2, 3, 0, 1}};
+    for (uint32_t i = 0; i < N; i++)
+    {
+        vertex = dvz_array_item(&source->arr, 4 * i);
+        AT(vertex->p0[1] == expected[i][0] && vertex->p0[0] == slots[i][0]);
+        AT(vertex->p1[1] == expected[i][1] && vertex->p1[0] == slots[i][1]);
+        AT(vertex->p2[1] == expected[i][2] && vertex->p2[0] == slots[i][2]);
+        AT(vertex->p3[1] == expected[i][3] && vertex->p3[0] == slots[i][3]);
+    }
+
+    dvz_visual_destroy(&visual);
+    return 0;
+}
+
+
+
 static void _visual_append(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
@@ -420,8 +420,8 @@ int test_vklite_app(TestContext* tc)
 
     AT(app->obj.status == DVZ_OBJECT_STATUS_CREATED);
     AT(app->gpus.count >= 1);
-    AT(((DvzGpu*)(app->gpus.items[0]))->name != NULL);
-    AT(((DvzGpu*)(app->gpus.items[0]))->obj.status == DVZ_OBJECT_STATUS_INIT);
+    AT(((DvzGpu*)dvz_container_get(&app->gpus, 0))->name != NULL);
+    AT(((DvzGpu*)dvz_container_get(&app->gpus, 0))->obj.status == DVZ_OBJECT_STATUS_INIT);
 
     DvzGpu* gpu = dvz_gpu_best(app);
     dvz_gpu_queue(gpu, 0, DVZ_QUEUE_TRANSFER);
@@ -558,6 +558,98 @@ int test_vklite_buffer_resize(TestContext* tc)
 
 
 
+static DvzMemoryStats _memory_stats(DvzGpu* gpu)
+{
+    DvzMemoryStats stats = {0}, heap_stats = {0};
+    for (uint32_t i = 0; i < gpu->memory_properties.memoryHeapCount; i++)
+    {
+        heap_stats = dvz_gpu_memory_stats(gpu, i);
+        stats.used += heap_stats.used;
+        stats.reserved += heap_stats.reserved;
+        stats.block_count += heap_stats.block_count;
+        stats.allocation_count += heap_stats.allocation_count;
+    }
+    return stats;
+}
+
+int test_vklite_memory(TestContext* tc)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    dvz_gpu_queue(gpu, 0, DVZ_QUEUE_RENDER);
+    dvz_gpu_create(gpu, 0);
+
+    const uint32_t n = 64;
+    DvzBuffer* buffers = calloc(n, sizeof(DvzBuffer));
+    DvzImages* images = calloc(n, sizeof(DvzImages));
+
+    // Create many small buffers and images.
+    for (uint32_t i = 0; i < n; i++)
+    {
+        buffers[i] = dvz_buffer(gpu);
+        dvz_buffer_size(&buffers[i], 256 * (i + 1));
+        dvz_buffer_usage(&buffers[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        if (i % 2 == 0)
+            dvz_buffer_memory(
+                &buffers[i],
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        dvz_buffer_queue_access(&buffers[i], 0);
+        dvz_buffer_create(&buffers[i]);
+
+        images[i] = dvz_images(gpu, VK_IMAGE_TYPE_2D, 1);
+        dvz_images_format(&images[i], VK_FORMAT_R8G8B8A8_UNORM);
+        dvz_images_size(&images[i], 16, 16, 1);
+        dvz_images_usage(&images[i], VK_IMAGE_USAGE_SAMPLED_BIT);
+        dvz_images_queue_access(&images[i], 0);
+        dvz_images_create(&images[i]);
+    }
+
+    // All resources are sub-allocated from a handful of memory blocks.
+    DvzMemoryStats stats = _memory_stats(gpu);
+    log_debug(
+        "%d allocations in %d blocks, %s used", stats.allocation_count, stats.block_count,
+        pretty_size(stats.used));
+    AT(stats.allocation_count == 2 * n);
+    AT(stats.block_count <= 8);
+    AT(stats.used > 0);
+    AT(stats.reserved >= stats.used);
+
+    // The mapped regions of different buffers sharing a block do not overlap.
+    uint8_t* mmap0 = dvz_buffer_map(&buffers[0], 0, VK_WHOLE_SIZE);
+    uint8_t* mmap2 = dvz_buffer_map(&buffers[2], 0, VK_WHOLE_SIZE);
+    AT(mmap0 + buffers[0].size <= mmap2 || mmap2 + buffers[2].size <= mmap0);
+    dvz_buffer_unmap(&buffers[0]);
+    dvz_buffer_unmap(&buffers[2]);
+
+    // A large buffer gets a dedicated allocation.
+    DvzBuffer large = dvz_buffer(gpu);
+    dvz_buffer_size(&large, DVZ_MEMORY_BLOCK_SIZE);
+    dvz_buffer_usage(&large, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    dvz_buffer_queue_access(&large, 0);
+    dvz_buffer_create(&large);
+    AT(large.allocation.block->strategy == DVZ_MEMORY_STRATEGY_DEDICATED);
+    AT(_memory_stats(gpu).block_count == stats.block_count + 1);
+    dvz_buffer_destroy(&large);
+    AT(_memory_stats(gpu).block_count == stats.block_count);
+
+    // Destroy the resources, the memory is returned to the blocks.
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dvz_buffer_destroy(&buffers[i]);
+        dvz_images_destroy(&images[i]);
+    }
+    stats = _memory_stats(gpu);
+    AT(stats.allocation_count == 0);
+    AT(stats.used == 0);
+
+    FREE(buffers);
+    FREE(images);
+    dvz_app_destroy(app);
+    return 0;
+}
+
+
+
 int test_vklite_compute(TestContext* tc)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
@@ -727,6 +819,47 @@ int test_vklite_images(TestContext* tc)
 
 
 
+int test_vklite_images_download(TestContext* tc)
+{
+    // Compare the SIMD conversion kernels with the scalar implementation, for all pixel layouts
+    // and for row widths that are not multiples of the SIMD widths.
+    const uint32_t max_width = 67;
+    uint8_t* src = calloc(max_width * 4 * 4, 1);
+    uint8_t* expected = calloc(max_width * 4 * 4, 1);
+    uint8_t* actual = calloc(max_width * 4 * 4 + 1, 1);
+    for (uint32_t i = 0; i < max_width * 4 * 4; i++)
+        src[i] = (uint8_t)dvz_rand_byte();
+
+    VkDeviceSize bpc = 0;
+    VkDeviceSize size = 0;
+    for (uint32_t w = 1; w <= max_width; w++)
+    {
+        for (bpc = 1; bpc <= 4; bpc *= 4)
+        {
+            for (uint32_t n_components = 3; n_components <= 4; n_components++)
+            {
+                for (uint32_t swizzle = 0; swizzle < 2; swizzle++)
+                {
+                    size = w * n_components * bpc;
+                    memset(actual, 0, max_width * 4 * 4 + 1);
+                    _image_row_convert_scalar(expected, src, w, bpc, swizzle, n_components);
+                    _image_row_convert(actual, src, w, bpc, swizzle, n_components);
+                    AT(memcmp(expected, actual, size) == 0);
+                    // Nothing is written past the row.
+                    AT(actual[size] == 0);
+                }
+            }
+        }
+    }
+
+    FREE(src);
+    FREE(expected);
+    FREE(actual);
+    return 0;
+}
+
+
+
 int test_vklite_sampler(TestContext* tc)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
@@ -21,6 +21,8 @@ int test_utils_fifo_discard(TestContext*);
 int test_utils_fifo_first(TestContext*);
 int test_utils_deq_1(TestContext*);
 int test_utils_deq_2(TestContext*);
+int test_utils_ring(TestContext*);
+int test_utils_ring_bench(TestContext*);
 
 int test_utils_array_1(TestContext*);
 int test_utils_array_2(TestContext*);
@@ -30,6 +32,7 @@ int test_utils_array_5(TestContext*);
 int test_utils_array_6(TestContext*);
 int test_utils_array_7(TestContext*);
 int test_utils_array_cast(TestContext*);
+int test_utils_array_column(TestContext*);
 int test_utils_array_mvp(TestContext*);
 int test_utils_array_3D(TestContext*);
 
@@ -37,6 +40,8 @@ int test_utils_transforms_1(TestContext*);
 int test_utils_transforms_2(TestContext*);
 int test_utils_transforms_3(TestContext*);
 int test_utils_transforms_4(TestContext*);
+int test_utils_transforms_pos(TestContext*);
+int test_utils_transforms_gpu(TestContext*);
 // int test_utils_transforms_5(TestContext*);
 
 int test_utils_colormap_idx(TestContext*);
@@ -57,9 +62,11 @@ int test_vklite_app(TestContext*);
 int test_vklite_commands(TestContext*);
 int test_vklite_buffer_1(TestContext*);
 int test_vklite_buffer_resize(TestContext*);
+int test_vklite_memory(TestContext*);
 int test_vklite_compute(TestContext*);
 int test_vklite_push(TestContext*);
 int test_vklite_images(TestContext*);
+int test_vklite_images_download(TestContext*);
 int test_vklite_sampler(TestContext*);
 int test_vklite_barrier_buffer(TestContext*);
 int test_vklite_barrier_image(TestContext*);
@@ -74,10 +81,14 @@ int test_vklite_canvas_blank(TestContext*);
 int test_vklite_canvas_triangle(TestContext*);
 
 // Test context.
+int test_context_lazy(TestContext*);
+int test_context_reset(TestContext*);
 int test_context_buffer(TestContext*);
+int test_context_buffer_free(TestContext*);
 int test_context_texture(TestContext*);
 int test_context_compute(TestContext*);
 int test_context_transfer_buffer(TestContext*);
+int test_context_transfer_large(TestContext*);
 int test_context_transfer_texture(TestContext*);
 int test_context_colormap_custom(TestContext*);
 
@@ -85,8 +96,11 @@ int test_context_colormap_custom(TestContext*);
 int test_canvas_blank(TestContext*);
 int test_canvas_multiple(TestContext*);
 int test_canvas_events(TestContext*);
+int test_canvas_events_coalesce(TestContext*);
 int test_canvas_gui(TestContext*);
 int test_canvas_screencast(TestContext*);
+int test_canvas_screenshot_async(TestContext*);
+int test_canvas_pick_batch(TestContext*);
 int test_canvas_video(TestContext*);
 
 int test_canvas_triangle_1(TestContext*);
@@ -120,6 +134,9 @@ int test_graphics_image_cmap(TestContext*);
 int test_graphics_volume_slice(TestContext*);
 int test_graphics_volume_1(TestContext*);
 int test_graphics_mesh(TestContext*);
+int test_graphics_pipeline_cache(TestContext*);
+int test_graphics_warmup(TestContext*);
+int test_graphics_registry(TestContext*);
 
 // Test visuals.
 int test_visuals_sources(TestContext*);
@@ -127,6 +144,9 @@ int test_visuals_props(TestContext*);
 int test_visuals_update_color(TestContext*);
 int test_visuals_update_pos(TestContext*);
 int test_visuals_partial(TestContext*);
+int test_visuals_dirty(TestContext*);
+int test_visuals_stream(TestContext*);
+int test_visuals_stream_path(TestContext*);
 int test_visuals_append(TestContext*);
 int test_visuals_shared(TestContext*);
 
@@ -160,6 +180,11 @@ int test_scene_link(TestContext*);
 int test_scene_different_size(TestContext*);
 int test_scene_different_controllers(TestContext*);
 int test_scene_dynamic_axes(TestContext*);
+int test_scene_zero_alloc(TestContext*);
+int test_scene_on_demand(TestContext*);
+int test_scene_partial_refill(TestContext*);
+int test_scene_parallel_refill(TestContext*);
+int test_scene_indirect_draws(TestContext*);
 
 
 
@@ -183,6 +208,8 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(NONE, test_utils_fifo_first),       //
     CASE_FIXTURE(NONE, test_utils_deq_1),            //
     CASE_FIXTURE(NONE, test_utils_deq_2),            //
+    CASE_FIXTURE(NONE, test_utils_ring),             //
+    CASE_FIXTURE(NONE, test_utils_ring_bench),       //
     CASE_FIXTURE(NONE, test_utils_array_1),          //
     CASE_FIXTURE(NONE, test_utils_array_2),          //
     CASE_FIXTURE(NONE, test_utils_array_3),          //
@@ -191,12 +218,15 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(NONE, test_utils_array_6),          //
     CASE_FIXTURE(NONE, test_utils_array_7),          //
     CASE_FIXTURE(NONE, test_utils_array_cast),       //
+    CASE_FIXTURE(NONE, test_utils_array_column),     //
     CASE_FIXTURE(NONE, test_utils_array_mvp),        //
     CASE_FIXTURE(NONE, test_utils_array_3D),         //
     CASE_FIXTURE(NONE, test_utils_transforms_1),     //
     CASE_FIXTURE(NONE, test_utils_transforms_2),     //
     CASE_FIXTURE(NONE, test_utils_transforms_3),     //
     CASE_FIXTURE(NONE, test_utils_transforms_4),     //
+    CASE_FIXTURE(NONE, test_utils_transforms_pos),   //
+    CASE_FIXTURE(NONE, test_utils_transforms_gpu),   //
     CASE_FIXTURE(NONE, test_utils_colormap_idx),     //
     CASE_FIXTURE(NONE, test_utils_colormap_uv),      //
     CASE_FIXTURE(NONE, test_utils_colormap_extent),  //
@@ -214,9 +244,11 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(NONE, test_vklite_commands),        //
     CASE_FIXTURE(NONE, test_vklite_buffer_1),        //
     CASE_FIXTURE(NONE, test_vklite_buffer_resize),   //
+    CASE_FIXTURE(NONE, test_vklite_memory),          //
     CASE_FIXTURE(NONE, test_vklite_compute),         //
     CASE_FIXTURE(NONE, test_vklite_push),            //
     CASE_FIXTURE(NONE, test_vklite_images),          //
+    CASE_FIXTURE(NONE, test_vklite_images_download), //
     CASE_FIXTURE(NONE, test_vklite_sampler),         //
     CASE_FIXTURE(NONE, test_vklite_barrier_buffer),  //
     CASE_FIXTURE(NONE, test_vklite_barrier_image),   //
@@ -231,10 +263,14 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(NONE, test_vklite_canvas_triangle), //
 
     // Context.
+    CASE_FIXTURE(NONE, test_context_lazy),                //
+    CASE_FIXTURE(CONTEXT, test_context_reset),            //
     CASE_FIXTURE(CONTEXT, test_context_buffer),           //
+    CASE_FIXTURE(CONTEXT, test_context_buffer_free),      //
     CASE_FIXTURE(CONTEXT, test_context_compute),          //
     CASE_FIXTURE(CONTEXT, test_context_texture),          //
     CASE_FIXTURE(CONTEXT, test_context_transfer_buffer),  //
+    CASE_FIXTURE(CONTEXT, test_context_transfer_large),   //
     CASE_FIXTURE(CONTEXT, test_context_transfer_texture), //
     CASE_FIXTURE(CONTEXT, test_context_colormap_custom),  //
 
@@ -242,8 +278,11 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(APP, test_canvas_blank),              //
     CASE_FIXTURE(APP, test_canvas_multiple),           //
     CASE_FIXTURE(APP, test_canvas_events),             //
+    CASE_FIXTURE(APP, test_canvas_events_coalesce),    //
     CASE_FIXTURE(APP, test_canvas_gui),                //
     CASE_FIXTURE(APP, test_canvas_screencast),         //
+    CASE_FIXTURE(APP, test_canvas_screenshot_async),   //
+    CASE_FIXTURE(APP, test_canvas_pick_batch),         //
     CASE_FIXTURE(APP, test_canvas_video),              //
     CASE_FIXTURE(APP, test_canvas_triangle_1),         //
     CASE_FIXTURE(APP, test_canvas_triangle_resize),    //
@@ -276,6 +315,9 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(CANVAS, test_graphics_volume_slice),   //
     CASE_FIXTURE(CANVAS, test_graphics_volume_1),       //
     CASE_FIXTURE(CANVAS, test_graphics_mesh),           //
+    CASE_FIXTURE(NONE, test_graphics_pipeline_cache),   //
+    CASE_FIXTURE(NONE, test_graphics_warmup),           //
+    CASE_FIXTURE(NONE, test_graphics_registry),         //
 
     // Visuals.
     CASE_FIXTURE(CANVAS, test_visuals_sources),      //
@@ -283,6 +325,9 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(CANVAS, test_visuals_update_color), //
     CASE_FIXTURE(CANVAS, test_visuals_update_pos),   //
     CASE_FIXTURE(CANVAS, test_visuals_partial),      //
+    CASE_FIXTURE(CANVAS, test_visuals_dirty),        //
+    CASE_FIXTURE(CANVAS, test_visuals_stream),       //
+    CASE_FIXTURE(CANVAS, test_visuals_stream_path),  //
     CASE_FIXTURE(CANVAS, test_visuals_append),       //
     CASE_FIXTURE(CANVAS, test_visuals_shared),       //
 
@@ -316,6 +361,11 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE(CANVAS, test_scene_different_size),        //
     CASE_FIXTURE(CANVAS, test_scene_different_controllers), //
     CASE_FIXTURE(CANVAS, test_scene_dynamic_axes),          //
+    CASE_FIXTURE(CANVAS, test_scene_zero_alloc),            //
+    CASE_FIXTURE(CANVAS, test_scene_on_demand),             //
+    CASE_FIXTURE(CANVAS, test_scene_partial_refill),        //
+    CASE_FIXTURE(CANVAS, test_scene_parallel_refill),       //
+    CASE_FIXTURE(CANVAS, test_scene_indirect_draws),        //
 
 };
 